@@ -0,0 +1,69 @@
+#ifndef BENCHMARK_HPP_
+#define BENCHMARK_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+struct BenchmarkSettings
+{
+    std::size_t max_entity_count = 1000000;
+    std::size_t math_element_count = 100000;
+    std::size_t repetition_count = 3;
+};
+
+struct BenchmarkResult
+{
+    std::string suite;
+    std::string name;
+    std::size_t element_count;
+    double total_ms;
+    double ns_per_element;
+    // Only filled by accuracy benchmarks, negative otherwise
+    double max_error = -1.0;
+};
+
+class BenchmarkReport
+{
+public:
+    void Add(BenchmarkResult const& result) { results_.push_back(result); }
+    std::vector<BenchmarkResult> const& GetResults() const { return results_; }
+    void WriteJson(std::ostream & os) const;
+
+private:
+    std::vector<BenchmarkResult> results_;
+
+};
+
+// Runs setup() then body() repetition_count times and keeps the fastest body() run,
+// setup isn't timed. Returns milliseconds
+template <class Setup, class Body>
+double MeasureBest(std::size_t repetition_count, Setup setup, Body body)
+{
+    double best_ms = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < repetition_count; ++i)
+    {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best_ms = std::min(best_ms, elapsed.count());
+    }
+
+    return best_ms;
+}
+
+// Keeps the compiler from optimizing away benchmark results
+void ConsumeValue(double value);
+
+void RunEcsBenchmarks(BenchmarkSettings const& settings, BenchmarkReport & report);
+// Throughput of every math kernel level plus max error against a double precision reference
+void RunMathBenchmarks(BenchmarkSettings const& settings, BenchmarkReport & report);
+// Replays a WorldRecorder log and reports the time of every frame
+void RunReplayBenchmark(char const* filename, BenchmarkReport & report);
+
+#endif // BENCHMARK_HPP_
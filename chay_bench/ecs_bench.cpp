@@ -0,0 +1,175 @@
+#include "benchmark.hpp"
+#include "component_manager.hpp"
+#include "world_recorder.hpp"
+#include <string>
+#include <memory>
+#include <numeric>
+#include <random>
+
+class BenchPosition : public Component
+{
+public:
+    BenchPosition(EntityId entity_id)
+        : Component(entity_id)
+    {}
+
+    float x, y, z;
+};
+
+class BenchVelocity : public Component
+{
+public:
+    BenchVelocity(EntityId entity_id)
+        : Component(entity_id)
+    {}
+
+    float x, y, z;
+};
+
+REGISTER_COMPONENT_CLASS(BenchPosition, bench_position);
+REGISTER_COMPONENT_CLASS(BenchVelocity, bench_velocity);
+
+namespace
+{
+    constexpr std::size_t kEntityCounts[] = { 10000, 100000, 1000000 };
+
+    void AddResult(BenchmarkReport & report, char const* name, std::size_t count, double total_ms)
+    {
+        // Nothing was measured, a per-element time would be inf and break the JSON
+        if (count == 0)
+        {
+            return;
+        }
+
+        report.Add({ "ecs", name, count, total_ms, total_ms * 1e6 / count });
+    }
+
+    void CreatePositions(ComponentManager & component_manager, std::size_t count)
+    {
+        for (EntityId entity_id = 0; entity_id < count; ++entity_id)
+        {
+            auto position = component_manager.CreateComponent<BenchPosition>(entity_id);
+            position->x = static_cast<float>(entity_id);
+            position->y = 0.0f;
+            position->z = 0.0f;
+        }
+    }
+
+    void RunEcsBenchmarks(BenchmarkSettings const& settings, BenchmarkReport & report, std::size_t count)
+    {
+        std::size_t repetitions = settings.repetition_count;
+        std::unique_ptr<ComponentManager> component_manager;
+
+        std::vector<EntityId> shuffled_ids(count);
+        std::iota(shuffled_ids.begin(), shuffled_ids.end(), 0);
+        std::shuffle(shuffled_ids.begin(), shuffled_ids.end(), std::mt19937_64(42));
+
+        auto fresh_world = [&component_manager, count]()
+        {
+            component_manager = std::make_unique<ComponentManager>();
+            CreatePositions(*component_manager, count);
+        };
+
+        // Create
+        double total_ms = MeasureBest(repetitions,
+            [&component_manager]() { component_manager = std::make_unique<ComponentManager>(); },
+            [&component_manager, count]() { CreatePositions(*component_manager, count); });
+        AddResult(report, "create", count, total_ms);
+
+        // Lookup by id in creation order
+        fresh_world();
+        total_ms = MeasureBest(repetitions, []() {}, [&component_manager, count]()
+        {
+            float sum = 0.0f;
+            for (EntityId entity_id = 0; entity_id < count; ++entity_id)
+            {
+                sum += component_manager->GetComponent<BenchPosition>(entity_id)->x;
+            }
+            ConsumeValue(sum);
+        });
+        AddResult(report, "lookup", count, total_ms);
+
+        // Lookup by id in random order, read-modify-write
+        total_ms = MeasureBest(repetitions, []() {}, [&component_manager, &shuffled_ids]()
+        {
+            for (EntityId entity_id : shuffled_ids)
+            {
+                component_manager->GetComponent<BenchPosition>(entity_id)->y += 1.0f;
+            }
+        });
+        AddResult(report, "random_access", count, total_ms);
+
+        // Dense iteration over a single pool
+        total_ms = MeasureBest(repetitions, []() {}, [&component_manager]()
+        {
+            component_manager->ForEach<BenchPosition>([](BenchPosition & position)
+            {
+                position.z += position.x * 0.5f;
+            });
+        });
+        AddResult(report, "iterate", count, total_ms);
+
+        // Two-component view: every other entity has a velocity
+        for (EntityId entity_id = 0; entity_id < count; entity_id += 2)
+        {
+            auto velocity = component_manager->CreateComponent<BenchVelocity>(entity_id);
+            velocity->x = 1.0f;
+            velocity->y = 2.0f;
+            velocity->z = 3.0f;
+        }
+
+        total_ms = MeasureBest(repetitions, []() {}, [&component_manager]()
+        {
+            component_manager->ForEach<BenchPosition>([&component_manager](BenchPosition & position)
+            {
+                if (auto velocity = component_manager->TryGetComponent<BenchVelocity>(position.GetEntityId()))
+                {
+                    position.x += velocity->x;
+                    position.y += velocity->y;
+                    position.z += velocity->z;
+                }
+            });
+        });
+        AddResult(report, "view2", count, total_ms);
+
+        // Destroy in random order
+        total_ms = MeasureBest(repetitions, fresh_world, [&component_manager, &shuffled_ids]()
+        {
+            for (EntityId entity_id : shuffled_ids)
+            {
+                component_manager->DestroyComponent<BenchPosition>(entity_id);
+            }
+        });
+        AddResult(report, "destroy", count, total_ms);
+    }
+}
+
+void RunEcsBenchmarks(BenchmarkSettings const& settings, BenchmarkReport & report)
+{
+    for (std::size_t count : kEntityCounts)
+    {
+        if (count <= settings.max_entity_count)
+        {
+            RunEcsBenchmarks(settings, report, count);
+        }
+    }
+}
+
+void RunReplayBenchmark(char const* filename, BenchmarkReport & report)
+{
+    ComponentManager component_manager;
+    WorldReplayer replayer(component_manager, WorldReplayer::Load(filename));
+
+    for (;;)
+    {
+        auto start = std::chrono::steady_clock::now();
+        if (!replayer.ReplayFrame())
+        {
+            break;
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::string name = "frame_" + std::to_string(replayer.GetFrameIndex() - 1);
+        report.Add({ "replay", name, 1, elapsed.count(), elapsed.count() * 1e6 });
+    }
+}
@@ -0,0 +1,120 @@
+#include "benchmark.hpp"
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    volatile double g_sink = 0.0;
+
+    void PrintUsage()
+    {
+        std::cerr << "Usage: ChayBench [--suite all|ecs|math] [--max-entities N] [--math-elements N] [--repetitions N] [--output file.json] [--replay recording.bin]\n";
+    }
+}
+
+void ConsumeValue(double value)
+{
+    g_sink = g_sink + value;
+}
+
+void BenchmarkReport::WriteJson(std::ostream & os) const
+{
+    os << "{\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results_.size(); ++i)
+    {
+        auto const& result = results_[i];
+        os << "    { \"suite\": \"" << result.suite << "\""
+           << ", \"name\": \"" << result.name << "\""
+           << ", \"element_count\": " << result.element_count
+           << ", \"total_ms\": " << result.total_ms
+           << ", \"ns_per_element\": " << result.ns_per_element;
+        if (result.max_error >= 0.0)
+        {
+            os << ", \"max_error\": " << result.max_error;
+        }
+        os << " }" << (i + 1 < results_.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkSettings settings;
+    char const* output_filename = nullptr;
+    char const* replay_filename = nullptr;
+    char const* suite = "all";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (i + 1 < argc && std::strcmp(argv[i], "--max-entities") == 0)
+        {
+            settings.max_entity_count = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (i + 1 < argc && std::strcmp(argv[i], "--math-elements") == 0)
+        {
+            settings.math_element_count = std::max<std::size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        }
+        else if (i + 1 < argc && std::strcmp(argv[i], "--suite") == 0)
+        {
+            suite = argv[++i];
+        }
+        else if (i + 1 < argc && std::strcmp(argv[i], "--repetitions") == 0)
+        {
+            settings.repetition_count = std::max<std::size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        }
+        else if (i + 1 < argc && std::strcmp(argv[i], "--output") == 0)
+        {
+            output_filename = argv[++i];
+        }
+        else if (i + 1 < argc && std::strcmp(argv[i], "--replay") == 0)
+        {
+            replay_filename = argv[++i];
+        }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    BenchmarkReport report;
+
+    try
+    {
+        if (replay_filename)
+        {
+            RunReplayBenchmark(replay_filename, report);
+        }
+        else
+        {
+            bool run_all = std::strcmp(suite, "all") == 0;
+            if (run_all || std::strcmp(suite, "ecs") == 0)
+            {
+                RunEcsBenchmarks(settings, report);
+            }
+            if (run_all || std::strcmp(suite, "math") == 0)
+            {
+                RunMathBenchmarks(settings, report);
+            }
+        }
+    }
+    catch (std::exception& ex)
+    {
+        std::cerr << "Caught exception:\n" << ex.what() << std::endl;
+        return -1;
+    }
+
+    if (output_filename)
+    {
+        std::ofstream output(output_filename);
+        report.WriteJson(output);
+    }
+    else
+    {
+        report.WriteJson(std::cout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,473 @@
+#include "benchmark.hpp"
+#include "mathlib.hpp"
+#include "math_kernels.hpp"
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace
+{
+    // Double precision reference results. Errors are relative to max(1, |reference|), matrix errors
+    // to the largest element of the reference so that cancellation in one element isn't amplified
+    struct DoubleMatrix
+    {
+        double m[4][4];
+    };
+
+    DoubleMatrix ToDouble(Matrix const& a)
+    {
+        DoubleMatrix result;
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                result.m[i][j] = a.m[i][j];
+            }
+        }
+
+        return result;
+    }
+
+    DoubleMatrix Multiply(DoubleMatrix const& a, DoubleMatrix const& b)
+    {
+        DoubleMatrix result = {};
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                for (int k = 0; k < 4; ++k)
+                {
+                    result.m[i][j] += a.m[i][k] * b.m[k][j];
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // Gauss-Jordan elimination with partial pivoting
+    DoubleMatrix Inverse(DoubleMatrix a)
+    {
+        DoubleMatrix result = {};
+        for (int i = 0; i < 4; ++i)
+        {
+            result.m[i][i] = 1.0;
+        }
+
+        for (int column = 0; column < 4; ++column)
+        {
+            int pivot = column;
+            for (int row = column + 1; row < 4; ++row)
+            {
+                if (std::abs(a.m[row][column]) > std::abs(a.m[pivot][column]))
+                {
+                    pivot = row;
+                }
+            }
+
+            std::swap(a.m[column], a.m[pivot]);
+            std::swap(result.m[column], result.m[pivot]);
+
+            double inv_pivot = 1.0 / a.m[column][column];
+            for (int j = 0; j < 4; ++j)
+            {
+                a.m[column][j] *= inv_pivot;
+                result.m[column][j] *= inv_pivot;
+            }
+
+            for (int row = 0; row < 4; ++row)
+            {
+                double factor = a.m[row][column];
+                if (row == column || factor == 0.0)
+                {
+                    continue;
+                }
+
+                for (int j = 0; j < 4; ++j)
+                {
+                    a.m[row][j] -= factor * a.m[column][j];
+                    result.m[row][j] -= factor * result.m[column][j];
+                }
+            }
+        }
+
+        return result;
+    }
+
+    double Error(double value, double reference)
+    {
+        return std::abs(value - reference) / std::max(1.0, std::abs(reference));
+    }
+
+    double MatrixError(Matrix const& value, DoubleMatrix const& reference)
+    {
+        double scale = 1.0;
+        double error = 0.0;
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                scale = std::max(scale, std::abs(reference.m[i][j]));
+                error = std::max(error, std::abs(value.m[i][j] - reference.m[i][j]));
+            }
+        }
+
+        return error / scale;
+    }
+
+    void AddResult(BenchmarkReport & report, std::string const& name, std::size_t count, double total_ms, double max_error)
+    {
+        // Nothing was measured, a per-element time would be inf and break the JSON
+        if (count == 0)
+        {
+            return;
+        }
+
+        report.Add({ "math", name, count, total_ms, total_ms * 1e6 / count, max_error });
+    }
+
+    struct MathInputs
+    {
+        // General, affine (scaled) and rigid matrices, each kernel gets the class it is meant for
+        std::vector<Matrix> general;
+        std::vector<Matrix> affine;
+        std::vector<Matrix> rigid;
+        std::vector<float3> points;
+        std::vector<float3> eyes;
+        std::vector<float> fovs;
+    };
+
+    MathInputs CreateInputs(std::size_t count)
+    {
+        std::mt19937 rng(44);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+        std::uniform_real_distribution<float> angle(-MATH_PI, MATH_PI);
+
+        MathInputs inputs;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            // Diagonally dominant keeps the general matrices well conditioned
+            Matrix general;
+            for (int r = 0; r < 4; ++r)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    general.m[r][c] = unit(rng) + (r == c ? 4.0f : 0.0f);
+                }
+            }
+
+            float3 translation(unit(rng) * 100.0f, unit(rng) * 100.0f, unit(rng) * 100.0f);
+            Matrix rotation = Matrix::RotationAxis(float3(unit(rng), unit(rng), unit(rng) + 2.0f), angle(rng));
+            inputs.general.push_back(general);
+            inputs.rigid.push_back(Matrix::Translation(translation) * rotation);
+            inputs.affine.push_back(inputs.rigid.back() * Matrix::Scaling(scale(rng), scale(rng), scale(rng)));
+            inputs.points.push_back(translation);
+            inputs.eyes.push_back(float3(unit(rng), unit(rng), unit(rng)) * 50.0f);
+            inputs.fovs.push_back(0.5f + 0.5f * scale(rng));
+        }
+
+        return inputs;
+    }
+
+    void RunKernelBenchmarks(BenchmarkSettings const& settings, BenchmarkReport & report, MathInputs const& inputs, SimdLevel level)
+    {
+        MathKernels const& kernels = GetMathKernels(level);
+        std::size_t count = inputs.general.size();
+        std::size_t repetitions = settings.repetition_count;
+        std::string suffix = std::string("_") + GetSimdLevelName(level);
+        std::vector<Matrix> matrices(count);
+        std::vector<float3> points(count);
+
+        auto no_setup = []() {};
+
+        // Multiply, one call per product and batched
+        double total_ms = MeasureBest(repetitions, no_setup, [&]()
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                kernels.multiply_matrix(&inputs.affine[i].m[0][0], &inputs.general[i].m[0][0], &matrices[i].m[0][0]);
+            }
+        });
+
+        double max_error = 0.0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            max_error = std::max(max_error, MatrixError(matrices[i], Multiply(ToDouble(inputs.affine[i]), ToDouble(inputs.general[i]))));
+        }
+        AddResult(report, "multiply_matrix" + suffix, count, total_ms, max_error);
+
+        total_ms = MeasureBest(repetitions, no_setup, [&]()
+        {
+            kernels.multiply_matrices(&inputs.affine[0].m[0][0], &inputs.general[0].m[0][0], &matrices[0].m[0][0], count);
+        });
+
+        max_error = 0.0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            max_error = std::max(max_error, MatrixError(matrices[i], Multiply(ToDouble(inputs.affine[i]), ToDouble(inputs.general[i]))));
+        }
+        AddResult(report, "multiply_matrices" + suffix, count, total_ms, max_error);
+
+        // Inverses, each on the matrix class it is meant for
+        struct InverseCase
+        {
+            char const* name;
+            void (*invert)(float const* m, float* result);
+            std::vector<Matrix> const* input;
+        };
+
+        for (InverseCase const& inverse : { InverseCase{ "invert_matrix", kernels.invert_matrix, &inputs.general },
+                                            InverseCase{ "invert_affine", kernels.invert_affine, &inputs.affine },
+                                            InverseCase{ "invert_rigid", kernels.invert_rigid, &inputs.rigid } })
+        {
+            std::vector<Matrix> const& input = *inverse.input;
+            total_ms = MeasureBest(repetitions, no_setup, [&]()
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    inverse.invert(&input[i].m[0][0], &matrices[i].m[0][0]);
+                }
+            });
+
+            max_error = 0.0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                max_error = std::max(max_error, MatrixError(matrices[i], Inverse(ToDouble(input[i]))));
+            }
+            AddResult(report, inverse.name + suffix, count, total_ms, max_error);
+        }
+
+        // Points through one matrix
+        Matrix const& m = inputs.affine[0];
+        total_ms = MeasureBest(repetitions, no_setup, [&]()
+        {
+            kernels.transform_points(&m.m[0][0], &inputs.points[0].x, &points[0].x, count);
+        });
+
+        max_error = 0.0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float3 const& p = inputs.points[i];
+            float3 const& r = points[i];
+            for (int row = 0; row < 3; ++row)
+            {
+                // Relative to the magnitude of the summed terms, cancellation is the input's fault
+                double reference = double(m.m[row][0]) * p.x + double(m.m[row][1]) * p.y + double(m.m[row][2]) * p.z + m.m[row][3];
+                double magnitude = std::abs(m.m[row][0] * p.x) + std::abs(m.m[row][1] * p.y) + std::abs(m.m[row][2] * p.z) + std::abs(m.m[row][3]);
+                max_error = std::max(max_error, std::abs((&r.x)[row] - reference) / std::max(1.0, magnitude));
+            }
+        }
+        AddResult(report, "transform_points" + suffix, count, total_ms, max_error);
+
+        total_ms = MeasureBest(repetitions, no_setup, [&]()
+        {
+            kernels.normalize_vectors(&inputs.points[0].x, &points[0].x, count);
+        });
+
+        max_error = 0.0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float3 const& p = inputs.points[i];
+            double length = std::sqrt(double(p.x) * p.x + double(p.y) * p.y + double(p.z) * p.z);
+            max_error = std::max(max_error, Error(points[i].x, p.x / length));
+            max_error = std::max(max_error, Error(points[i].y, p.y / length));
+            max_error = std::max(max_error, Error(points[i].z, p.z / length));
+        }
+        AddResult(report, "normalize_vectors" + suffix, count, total_ms, max_error);
+
+        // Generators and noise have no double reference, throughput only
+        std::vector<float> values(count);
+        std::uint32_t random_state[4][kRandomStreams] = {};
+        random_state[0][0] = 1;
+        total_ms = MeasureBest(repetitions, no_setup, [&]()
+        {
+            kernels.random_float(&random_state[0][0], values.data(), count, 0.0f, 1.0f);
+        });
+        AddResult(report, "random_float" + suffix, count, total_ms, -1.0);
+
+        std::vector<float> xs(count), ys(count), zs(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            xs[i] = inputs.points[i].x * 0.1f;
+            ys[i] = inputs.points[i].y * 0.1f;
+            zs[i] = inputs.points[i].z * 0.1f;
+        }
+
+        for (NoiseType type : { NoiseType::kValue, NoiseType::kGradient, NoiseType::kSimplex })
+        {
+            char const* names[] = { "value_noise", "gradient_noise", "simplex_noise" };
+            total_ms = MeasureBest(repetitions, no_setup, [&]()
+            {
+                kernels.noise(type, xs.data(), ys.data(), zs.data(), 1u, values.data(), count);
+            });
+            AddResult(report, names[static_cast<int>(type)] + suffix, count, total_ms, -1.0);
+        }
+
+        // Main view and three cascades, separate passes against one pass over the bounds
+        constexpr std::size_t kViewCount = 4;
+        Frustum frusta[kViewCount];
+        for (std::size_t view = 0; view < kViewCount; ++view)
+        {
+            Matrix view_matrix = Matrix::LookAtLH(inputs.eyes[view], float3(0.0f, 0.0f, 0.0f));
+            frusta[view] = Frustum::FromViewProjection(view_matrix * Matrix::PerspectiveFovLH(inputs.fovs[view], 1.0f, 0.1f, 20.0f * (view + 1)));
+        }
+
+        std::vector<float> extents(count, 0.5f);
+        std::vector<std::uint8_t> classes(count);
+        total_ms = MeasureBest(repetitions, no_setup, [&]()
+        {
+            for (Frustum const& frustum : frusta)
+            {
+                kernels.cull_aabbs(&frustum.planes[0].x, xs.data(), ys.data(), zs.data(),
+                                   extents.data(), extents.data(), extents.data(), classes.data(), count);
+            }
+        });
+        AddResult(report, "cull_aabbs_x4" + suffix, count, total_ms, -1.0);
+
+        std::vector<std::uint32_t> visibility(count);
+        total_ms = MeasureBest(repetitions, no_setup, [&]()
+        {
+            kernels.cull_aabbs_multi(&frusta[0].planes[0].x, kViewCount, xs.data(), ys.data(), zs.data(),
+                                     extents.data(), extents.data(), extents.data(), visibility.data(), count);
+        });
+        AddResult(report, "cull_aabbs_multi4" + suffix, count, total_ms, -1.0);
+        ConsumeValue(static_cast<double>(classes[count - 1] + visibility[count - 1]));
+
+        // Occluder sized triangles of about 50 pixels into a 256 x 128 occlusion buffer
+        constexpr std::uint32_t kDepthWidth = 256;
+        constexpr std::uint32_t kDepthHeight = 128;
+        std::size_t triangle_count = count / 3;
+        std::vector<float> triangles(triangle_count * 9);
+        for (std::size_t i = 0; i < triangle_count * 3; ++i)
+        {
+            std::size_t corner = i / 3 * 3;
+            triangles[i * 3 + 0] = (xs[corner] + 10.0f) * 12.8f + xs[i] * 0.5f;
+            triangles[i * 3 + 1] = (ys[corner] + 10.0f) * 6.4f + ys[i] * 0.5f;
+            triangles[i * 3 + 2] = zs[i] * 0.05f + 0.5f;
+        }
+
+        if (triangle_count > 0)
+        {
+            std::vector<float> depth(kDepthWidth * kDepthHeight);
+            total_ms = MeasureBest(repetitions, [&]() { std::fill(depth.begin(), depth.end(), 1.0f); }, [&]()
+            {
+                kernels.rasterize_depth(triangles.data(), triangle_count, depth.data(), kDepthWidth, kDepthHeight);
+            });
+            AddResult(report, "rasterize_depth" + suffix, triangle_count, total_ms, -1.0);
+            ConsumeValue(depth[kDepthWidth * kDepthHeight / 2]);
+        }
+        ConsumeValue(values[count - 1]);
+    }
+
+    // Builders without SIMD variants, measured once
+    void RunBuilderBenchmarks(BenchmarkSettings const& settings, BenchmarkReport & report, MathInputs const& inputs)
+    {
+        std::size_t count = inputs.eyes.size();
+        std::vector<Matrix> matrices(count);
+        std::vector<float3> points(count);
+        float3 const target(1.0f, 2.0f, 3.0f);
+        float3 const up(0.0f, 0.0f, 1.0f);
+
+        double total_ms = MeasureBest(settings.repetition_count, []() {}, [&]()
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                matrices[i] = Matrix::LookAtRH(inputs.eyes[i], target, up);
+            }
+        });
+
+        double max_error = 0.0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            // Same construction as Matrix::LookAtRH in double
+            double eye[3] = { inputs.eyes[i].x, inputs.eyes[i].y, inputs.eyes[i].z };
+            double z[3] = { eye[0] - target.x, eye[1] - target.y, eye[2] - target.z };
+            double z_length = std::sqrt(z[0] * z[0] + z[1] * z[1] + z[2] * z[2]);
+            for (double & c : z)
+            {
+                c /= z_length;
+            }
+
+            double x[3] = { up.y * z[2] - up.z * z[1], up.z * z[0] - up.x * z[2], up.x * z[1] - up.y * z[0] };
+            double x_length = std::sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+            for (double & c : x)
+            {
+                c /= x_length;
+            }
+
+            double y[3] = { z[1] * x[2] - z[2] * x[1], z[2] * x[0] - z[0] * x[2], z[0] * x[1] - z[1] * x[0] };
+            DoubleMatrix reference = { {
+                { x[0], y[0], z[0], 0.0 },
+                { x[1], y[1], z[1], 0.0 },
+                { x[2], y[2], z[2], 0.0 },
+                { -(x[0] * eye[0] + x[1] * eye[1] + x[2] * eye[2]),
+                  -(y[0] * eye[0] + y[1] * eye[1] + y[2] * eye[2]),
+                  -(z[0] * eye[0] + z[1] * eye[1] + z[2] * eye[2]), 1.0 } } };
+            max_error = std::max(max_error, MatrixError(matrices[i], reference));
+        }
+        AddResult(report, "look_at_rh", count, total_ms, max_error);
+
+        float const aspect = 16.0f / 9.0f;
+        float const near_z = 0.1f;
+        float const far_z = 1000.0f;
+        total_ms = MeasureBest(settings.repetition_count, []() {}, [&]()
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                matrices[i] = Matrix::PerspectiveFovRH(inputs.fovs[i], aspect, near_z, far_z);
+            }
+        });
+
+        max_error = 0.0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            double h = 1.0 / std::tan(0.5 * inputs.fovs[i]);
+            double range = double(far_z) / (double(near_z) - far_z);
+            DoubleMatrix reference = { {
+                { h / aspect, 0.0, 0.0, 0.0 },
+                { 0.0, h, 0.0, 0.0 },
+                { 0.0, 0.0, range, -1.0 },
+                { 0.0, 0.0, range * near_z, 0.0 } } };
+            max_error = std::max(max_error, MatrixError(matrices[i], reference));
+        }
+        AddResult(report, "perspective_fov_rh", count, total_ms, max_error);
+
+        // Member normalize as the baseline for normalize_vectors
+        total_ms = MeasureBest(settings.repetition_count, []() {}, [&]()
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                points[i] = inputs.points[i].normalize();
+            }
+        });
+
+        max_error = 0.0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float3 const& p = inputs.points[i];
+            double length = std::sqrt(double(p.x) * p.x + double(p.y) * p.y + double(p.z) * p.z);
+            max_error = std::max(max_error, Error(points[i].x, p.x / length));
+            max_error = std::max(max_error, Error(points[i].y, p.y / length));
+            max_error = std::max(max_error, Error(points[i].z, p.z / length));
+        }
+        AddResult(report, "float3_normalize", count, total_ms, max_error);
+        ConsumeValue(points[count - 1].x + matrices[count - 1].m[0][0]);
+    }
+}
+
+void RunMathBenchmarks(BenchmarkSettings const& settings, BenchmarkReport & report)
+{
+    MathInputs inputs = CreateInputs(settings.math_element_count);
+
+    for (SimdLevel level : { SimdLevel::kScalar, SimdLevel::kSse41, SimdLevel::kAvx2, SimdLevel::kAvx512 })
+    {
+        // Unsupported levels would silently rerun a lower one
+        if (level <= GetMaxSimdLevel())
+        {
+            RunKernelBenchmarks(settings, report, inputs, level);
+        }
+    }
+
+    RunBuilderBenchmarks(settings, report, inputs);
+}
@@ -0,0 +1,22 @@
+#ifndef BIT_UTILS_HPP_
+#define BIT_UTILS_HPP_
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// value must not be zero
+inline std::uint32_t CountTrailingZeros(std::uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<std::uint32_t>(index);
+#else
+    return static_cast<std::uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+#endif // BIT_UTILS_HPP_
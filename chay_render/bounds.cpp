@@ -0,0 +1,158 @@
+#include "mathlib.hpp"
+#include "math_kernels.hpp"
+
+static_assert(sizeof(Aabb) == sizeof(float) * 6, "Bounds kernels expect packed boxes");
+
+void Aabb::Grow(const float3& point)
+{
+    min_point = float3(std::fmin(min_point.x, point.x), std::fmin(min_point.y, point.y), std::fmin(min_point.z, point.z));
+    max_point = float3(std::fmax(max_point.x, point.x), std::fmax(max_point.y, point.y), std::fmax(max_point.z, point.z));
+}
+
+Aabb Aabb::Transform(const Matrix& m) const
+{
+    if (IsEmpty())
+    {
+        return *this;
+    }
+
+    Aabb result;
+    GetMathKernels().transform_aabbs(&m.m[0][0], &min_point.x, &result.min_point.x, 1);
+    return result;
+}
+
+Aabb merge(const Aabb& a, const Aabb& b)
+{
+#if CHAY_SIMD_X86
+    // Both boxes are 6 floats, the two overlapping loads cover them without reading past the end
+    __m128 a_min = _mm_loadu_ps(&a.min_point.x);
+    __m128 b_min = _mm_loadu_ps(&b.min_point.x);
+    __m128 a_max = _mm_loadu_ps(&a.min_point.x + 2);
+    __m128 b_max = _mm_loadu_ps(&b.min_point.x + 2);
+    float lower[4], upper[4];
+    _mm_storeu_ps(lower, _mm_min_ps(a_min, b_min));
+    _mm_storeu_ps(upper, _mm_max_ps(a_max, b_max));
+    return Aabb(float3(lower[0], lower[1], lower[2]), float3(upper[1], upper[2], upper[3]));
+#else
+    return Aabb(float3(std::fmin(a.min_point.x, b.min_point.x), std::fmin(a.min_point.y, b.min_point.y), std::fmin(a.min_point.z, b.min_point.z)),
+                float3(std::fmax(a.max_point.x, b.max_point.x), std::fmax(a.max_point.y, b.max_point.y), std::fmax(a.max_point.z, b.max_point.z)));
+#endif
+}
+
+Aabb ComputeBounds(const float* positions, std::size_t stride, std::size_t count)
+{
+    Aabb result;
+    if (count > 0)
+    {
+        GetMathKernels().compute_bounds(positions, stride, count, &result.min_point.x, &result.max_point.x);
+    }
+
+    return result;
+}
+
+Aabb MergeBounds(const Aabb* boxes, std::size_t count)
+{
+    // Minimum of the min corners and maximum of the max corners, the other halves are discarded
+    Aabb lower = ComputeBounds(&boxes->min_point.x, 6, count);
+    Aabb upper = ComputeBounds(&boxes->max_point.x, 6, count);
+    return Aabb(lower.min_point, upper.max_point);
+}
+
+void TransformAabbs(const Matrix& m, const Aabb* boxes, Aabb* result, std::size_t count)
+{
+    GetMathKernels().transform_aabbs(&m.m[0][0], &boxes->min_point.x, &result->min_point.x, count);
+}
+
+BoundingSphere BoundingSphere::FromPoints(const float* positions, std::size_t stride, std::size_t count)
+{
+    if (count == 0)
+    {
+        return BoundingSphere();
+    }
+
+    float3 center = ComputeBounds(positions, stride, count).GetCenter();
+    float radius_sq = GetMathKernels().max_distance_sq(positions, stride, count, &center.x);
+    return BoundingSphere(center, std::sqrt(radius_sq));
+}
+
+BoundingSphere BoundingSphere::Transform(const Matrix& m) const
+{
+    float scale_sq = 0.0f;
+    for (int j = 0; j < 3; ++j)
+    {
+        float3 column(m.m[0][j], m.m[1][j], m.m[2][j]);
+        scale_sq = std::fmax(scale_sq, dot(column, column));
+    }
+
+    return BoundingSphere(m * center, radius * std::sqrt(scale_sq));
+}
+
+BoundingSphere merge(const BoundingSphere& a, const BoundingSphere& b)
+{
+    if (a.IsEmpty())
+    {
+        return b;
+    }
+
+    if (b.IsEmpty())
+    {
+        return a;
+    }
+
+    float3 offset = b.center - a.center;
+    float distance = offset.length();
+    if (distance + b.radius <= a.radius)
+    {
+        return a;
+    }
+
+    if (distance + a.radius <= b.radius)
+    {
+        return b;
+    }
+
+    float radius = (distance + a.radius + b.radius) * 0.5f;
+    return BoundingSphere(a.center + offset * ((radius - a.radius) / distance), radius);
+}
+
+Obb Obb::FromAabb(const Aabb& aabb, const Matrix& m)
+{
+    Obb result;
+    result.center = m * aabb.GetCenter();
+    float3 extent = aabb.GetExtent();
+    for (int j = 0; j < 3; ++j)
+    {
+        float3 column(m.m[0][j], m.m[1][j], m.m[2][j]);
+        float scale = column.length();
+        result.axes[j] = column * (1.0f / scale);
+        result.extent[j] = extent[j] * scale;
+    }
+
+    return result;
+}
+
+bool Obb::Contains(const float3& point) const
+{
+    float3 offset = point - center;
+    for (int j = 0; j < 3; ++j)
+    {
+        if (std::abs(dot(offset, axes[j])) > extent[j])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+Aabb Obb::GetAabb() const
+{
+    // World extent along each axis is the sum of the projected box axes
+    float3 world_extent;
+    for (int i = 0; i < 3; ++i)
+    {
+        world_extent[i] = std::abs(axes[0][i]) * extent[0] + std::abs(axes[1][i]) * extent[1] + std::abs(axes[2][i]) * extent[2];
+    }
+
+    return Aabb::FromCenterExtent(center, world_extent);
+}
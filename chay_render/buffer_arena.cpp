@@ -0,0 +1,102 @@
+#include "buffer_arena.hpp"
+#include <new>
+
+BufferArena::~BufferArena()
+{
+    // Chunks free themselves, blocks of components which were never released are still here
+    for (void* block : large_blocks_)
+    {
+        ::operator delete(block);
+    }
+}
+
+std::size_t BufferArena::GetBlockSize(std::size_t size)
+{
+    std::size_t block_size = kBufferArenaMinBlockSize;
+    while (block_size < size)
+    {
+        block_size <<= 1;
+    }
+
+    return block_size;
+}
+
+std::size_t BufferArena::GetSizeClass(std::size_t size)
+{
+    std::size_t size_class = 0;
+    for (std::size_t block_size = kBufferArenaMinBlockSize; block_size < size; block_size <<= 1)
+    {
+        ++size_class;
+    }
+
+    return size_class;
+}
+
+void* BufferArena::Allocate(std::size_t size)
+{
+    std::size_t block_size = GetBlockSize(size);
+
+    // Blocks which don't fit a chunk go straight to the system allocator
+    if (block_size > kBufferArenaChunkSize)
+    {
+        void* block = ::operator new(block_size);
+        large_blocks_.insert(block);
+        return block;
+    }
+
+    std::size_t size_class = GetSizeClass(block_size);
+    if (size_class < free_lists_.size() && free_lists_[size_class])
+    {
+        FreeBlock* block = free_lists_[size_class];
+        free_lists_[size_class] = block->next;
+        return block;
+    }
+
+    if (chunk_offset_ + block_size > kBufferArenaChunkSize)
+    {
+        // Chunk tail is too small for this class, donate it to smaller free lists
+        std::size_t tail_size = kBufferArenaChunkSize - chunk_offset_;
+        for (std::size_t tail_block_size = kBufferArenaChunkSize / 2; tail_size >= kBufferArenaMinBlockSize; tail_block_size >>= 1)
+        {
+            if (tail_size >= tail_block_size)
+            {
+                Free(chunks_.back().get() + chunk_offset_, tail_block_size);
+                chunk_offset_ += tail_block_size;
+                tail_size -= tail_block_size;
+            }
+        }
+
+        chunks_.emplace_back(new std::uint8_t[kBufferArenaChunkSize]);
+        chunk_offset_ = 0;
+    }
+
+    void* block = chunks_.back().get() + chunk_offset_;
+    chunk_offset_ += block_size;
+    return block;
+}
+
+void BufferArena::Free(void* ptr, std::size_t size)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    std::size_t block_size = GetBlockSize(size);
+    if (block_size > kBufferArenaChunkSize)
+    {
+        large_blocks_.erase(ptr);
+        ::operator delete(ptr);
+        return;
+    }
+
+    std::size_t size_class = GetSizeClass(block_size);
+    if (size_class >= free_lists_.size())
+    {
+        free_lists_.resize(size_class + 1, nullptr);
+    }
+
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    block->next = free_lists_[size_class];
+    free_lists_[size_class] = block;
+}
@@ -0,0 +1,48 @@
+#ifndef BUFFER_ARENA_HPP_
+#define BUFFER_ARENA_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <unordered_set>
+
+constexpr std::size_t kBufferArenaChunkSize = 64u * 1024u;
+constexpr std::size_t kBufferArenaMinBlockSize = 16u;
+
+// Backing storage for DynamicBuffer overflow. Memory is carved from large chunks
+// in power-of-two size classes and recycled through per-class free lists,
+// so growing a buffer only hits the system allocator when a new chunk is needed.
+// Blocks never move, pointers stay valid until they are freed. Not thread-safe.
+class BufferArena
+{
+public:
+    BufferArena() = default;
+    BufferArena(BufferArena const&) = delete;
+    BufferArena & operator=(BufferArena const&) = delete;
+    ~BufferArena();
+
+    // Returned block is 16-byte aligned and at least GetBlockSize(size) bytes long
+    void* Allocate(std::size_t size);
+    // size must be the same value that was passed to Allocate
+    void Free(void* ptr, std::size_t size);
+
+    static std::size_t GetBlockSize(std::size_t size);
+    std::size_t GetReservedSize() const { return chunks_.size() * kBufferArenaChunkSize; }
+
+private:
+    static std::size_t GetSizeClass(std::size_t size);
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    std::vector<std::unique_ptr<std::uint8_t[]>> chunks_;
+    std::size_t chunk_offset_ = kBufferArenaChunkSize;
+    std::vector<FreeBlock*> free_lists_;
+    std::unordered_set<void*> large_blocks_;
+
+};
+
+#endif // BUFFER_ARENA_HPP_
@@ -1 +1,136 @@
 #include "camera.hpp"
+#include "component_manager.hpp"
+
+REGISTER_COMPONENT_CLASS(Camera, camera);
+
+void Camera::SetPosition(const float3& position)
+{
+    position_ = position;
+    valid_flags_ &= ~kViewDependent;
+}
+
+void Camera::SetDirection(const float3& direction, const float3& up)
+{
+    // A zero direction or one parallel to up has no view basis, LookAtLH would produce NaNs
+    float3 side = cross(direction, up);
+    if (dot(side, side) == 0.0f)
+    {
+        return;
+    }
+
+    direction_ = direction;
+    up_ = up;
+    valid_flags_ &= ~kViewDependent;
+}
+
+void Camera::LookAt(const float3& target, const float3& up)
+{
+    SetDirection(target - position_, up);
+}
+
+void Camera::SetPerspective(float fov, float aspect, float near_z, float far_z)
+{
+    fov_or_height_ = fov;
+    aspect_ = aspect;
+    near_z_ = near_z;
+    far_z_ = far_z;
+    orthographic_ = false;
+    valid_flags_ &= ~kProjectionDependent;
+}
+
+void Camera::SetOrthographic(float width, float height, float near_z, float far_z)
+{
+    fov_or_height_ = height;
+    aspect_ = width / height;
+    near_z_ = near_z;
+    far_z_ = far_z;
+    orthographic_ = true;
+    valid_flags_ &= ~kProjectionDependent;
+}
+
+void Camera::SetAspect(float aspect)
+{
+    aspect_ = aspect;
+    valid_flags_ &= ~kProjectionDependent;
+}
+
+Matrix const& Camera::GetView() const
+{
+    if (!(valid_flags_ & kViewValid))
+    {
+        view_ = Matrix::LookAtLH(position_, position_ + direction_, up_);
+        valid_flags_ |= kViewValid;
+    }
+
+    return view_;
+}
+
+Matrix const& Camera::GetProjection() const
+{
+    if (!(valid_flags_ & kProjectionValid))
+    {
+        projection_ = orthographic_
+            ? Matrix::OrthoLH(fov_or_height_ * aspect_, fov_or_height_, near_z_, far_z_)
+            : Matrix::PerspectiveFovLH(fov_or_height_, aspect_, near_z_, far_z_);
+        valid_flags_ |= kProjectionValid;
+    }
+
+    return projection_;
+}
+
+Matrix const& Camera::GetViewProjection() const
+{
+    if (!(valid_flags_ & kViewProjectionValid))
+    {
+        view_projection_ = GetView() * GetProjection();
+        valid_flags_ |= kViewProjectionValid;
+    }
+
+    return view_projection_;
+}
+
+Matrix const& Camera::GetInverseView() const
+{
+    if (!(valid_flags_ & kInverseViewValid))
+    {
+        // LookAt matrices are rotation + translation
+        inverse_view_ = GetView().InverseRigid();
+        valid_flags_ |= kInverseViewValid;
+    }
+
+    return inverse_view_;
+}
+
+Matrix const& Camera::GetInverseProjection() const
+{
+    if (!(valid_flags_ & kInverseProjectionValid))
+    {
+        inverse_projection_ = orthographic_ ? GetProjection().InverseAffine() : GetProjection().Inverse();
+        valid_flags_ |= kInverseProjectionValid;
+    }
+
+    return inverse_projection_;
+}
+
+Matrix const& Camera::GetInverseViewProjection() const
+{
+    if (!(valid_flags_ & kInverseViewProjectionValid))
+    {
+        // Composed from the cheap inverses instead of a general inverse of the product
+        inverse_view_projection_ = GetInverseProjection() * GetInverseView();
+        valid_flags_ |= kInverseViewProjectionValid;
+    }
+
+    return inverse_view_projection_;
+}
+
+Frustum const& Camera::GetFrustum() const
+{
+    if (!(valid_flags_ & kFrustumValid))
+    {
+        frustum_ = Frustum::FromViewProjection(GetViewProjection());
+        valid_flags_ |= kFrustumValid;
+    }
+
+    return frustum_;
+}
@@ -1,11 +1,82 @@
 #ifndef CAMERA_HPP_
 #define CAMERA_HPP_
 
-class Camera
+#include "component.hpp"
+#include "mathlib.hpp"
+#include <cstdint>
+
+// Camera component with lazily cached matrices and frustum. Matrices follow LookAtLH and
+// PerspectiveFovLH/OrthoLH: row vectors, clip = p * view * projection, depth in [0, 1].
+// The zero state means nothing is cached yet, both for cameras in zeroed pool memory, where
+// constructors don't run, and for ones constructed directly. Set the placement and the lens
+// before the first query
+class Camera : public Component
 {
 public:
+    Camera(EntityId entity_id)
+        : Component(entity_id)
+    {}
+
+    // Placement, each setter only invalidates what depends on the view. A degenerate direction,
+    // e.g. LookAt of the camera position itself, is ignored and the previous one is kept
+    void SetPosition(const float3& position);
+    void SetDirection(const float3& direction, const float3& up = float3(0.0f, 0.0f, 1.0f));
+    void LookAt(const float3& target, const float3& up = float3(0.0f, 0.0f, 1.0f));
+    float3 const& GetPosition() const { return position_; }
+    float3 const& GetDirection() const { return direction_; }
+    float3 const& GetUp() const { return up_; }
+
+    // Lens, fov is vertical in radians
+    void SetPerspective(float fov, float aspect, float near_z, float far_z);
+    void SetOrthographic(float width, float height, float near_z, float far_z);
+    // Keeps the vertical fov or the ortho height, e.g. on swapchain resize
+    void SetAspect(float aspect);
+    bool IsOrthographic() const { return orthographic_; }
+    float GetNearZ() const { return near_z_; }
+    float GetFarZ() const { return far_z_; }
+
+    // Recomputed on first use after a change, references stay valid for the component's lifetime
+    Matrix const& GetView() const;
+    Matrix const& GetProjection() const;
+    Matrix const& GetViewProjection() const;
+    Matrix const& GetInverseView() const;
+    Matrix const& GetInverseProjection() const;
+    Matrix const& GetInverseViewProjection() const;
+    Frustum const& GetFrustum() const;
 
 private:
+    enum CacheFlags : std::uint32_t
+    {
+        kViewValid = 1u << 0,
+        kProjectionValid = 1u << 1,
+        kViewProjectionValid = 1u << 2,
+        kInverseViewValid = 1u << 3,
+        kInverseProjectionValid = 1u << 4,
+        kInverseViewProjectionValid = 1u << 5,
+        kFrustumValid = 1u << 6,
+
+        kViewDependent = kViewValid | kViewProjectionValid | kInverseViewValid | kInverseViewProjectionValid | kFrustumValid,
+        kProjectionDependent = kProjectionValid | kViewProjectionValid | kInverseProjectionValid | kInverseViewProjectionValid | kFrustumValid
+    };
+
+    float3 position_;
+    float3 direction_;
+    float3 up_;
+    // Vertical fov for perspective, view height for orthographic
+    float fov_or_height_ = 0.0f;
+    float aspect_ = 0.0f;
+    float near_z_ = 0.0f;
+    float far_z_ = 0.0f;
+    bool orthographic_ = false;
+
+    mutable std::uint32_t valid_flags_ = 0;
+    mutable Matrix view_;
+    mutable Matrix projection_;
+    mutable Matrix view_projection_;
+    mutable Matrix inverse_view_;
+    mutable Matrix inverse_projection_;
+    mutable Matrix inverse_view_projection_;
+    mutable Frustum frustum_;
 
 };
 
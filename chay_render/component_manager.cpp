@@ -1,4 +1,6 @@
 #include "component_manager.hpp"
+#include <algorithm>
+#include <cstring>
 
 namespace
 {
@@ -15,6 +17,20 @@ namespace
         }
 
     };
+
+    class SharedComponentPoolFactoryMap
+    {
+    private:
+        std::unordered_map<std::string, SharedComponentPoolBase* (*)()> shared_component_pool_factory_map_;
+
+    public:
+        static decltype(shared_component_pool_factory_map_) & GetMap()
+        {
+            static SharedComponentPoolFactoryMap map;
+            return map.shared_component_pool_factory_map_;
+        }
+
+    };
 }
 
 void RegisterComponentPoolFactory(char const* type_name, ComponentPool* (*factory_fun)())
@@ -22,6 +38,11 @@ void RegisterComponentPoolFactory(char const* type_name, ComponentPool* (*factor
     ComponentPoolFactoryMap::GetMap().emplace(type_name, factory_fun);
 }
 
+void RegisterSharedComponentPoolFactory(char const* type_name, SharedComponentPoolBase* (*factory_fun)())
+{
+    SharedComponentPoolFactoryMap::GetMap().emplace(type_name, factory_fun);
+}
+
 ComponentManager::ComponentManager()
 {
     CreateComponentPools();
@@ -34,4 +55,223 @@ void ComponentManager::CreateComponentPools()
         ComponentPool* pool = factory.second();
         component_pools_.emplace(pool->GetComponentTypeId(), pool);
     }
+
+    for (auto factory : SharedComponentPoolFactoryMap::GetMap())
+    {
+        SharedComponentPoolBase* pool = factory.second();
+        shared_component_pools_.emplace(pool->GetComponentTypeId(), pool);
+    }
+}
+
+ComponentPool & ComponentManager::GetComponentPool(char const* name)
+{
+    for (auto & pool : component_pools_)
+    {
+        if (pool.second->GetName() == name)
+        {
+            return *pool.second;
+        }
+    }
+
+    throw std::runtime_error("Failed to get component pool: component type is not registered");
+}
+
+SharedComponentPoolBase & ComponentManager::GetSharedComponentPool(char const* name)
+{
+    for (auto & pool : shared_component_pools_)
+    {
+        if (pool.second->GetName() == name)
+        {
+            return *pool.second;
+        }
+    }
+
+    throw std::runtime_error("Failed to get shared component pool: component type is not registered");
+}
+
+void ComponentManager::SetRecorder(WorldRecorder* recorder)
+{
+    recorder_ = recorder;
+    for (auto & pool : component_pools_)
+    {
+        pool.second->SetRecorder(recorder);
+    }
+
+    for (auto & pool : shared_component_pools_)
+    {
+        pool.second->SetRecorder(recorder);
+    }
+}
+
+void ComponentPool::FreeComponent(EntityId id)
+{
+    if (concurrent_allocation_active_)
+    {
+        throw std::runtime_error("Can't free components while concurrent allocation is active!");
+    }
+
+    auto it = entity_id_2_pool_index_.find(id);
+    if (it == entity_id_2_pool_index_.end())
+    {
+        throw std::runtime_error("Failed to find component!");
+    }
+
+    std::size_t index = it->second;
+    std::size_t last_index = component_count_ - 1;
+    entity_id_2_pool_index_.erase(it);
+
+    // Fill the hole with the last component to keep the pool dense
+    if (index != last_index)
+    {
+        EntityId last_id = pool_index_2_entity_id_[last_index];
+        std::memcpy(pool_.data() + component_size_ * index,
+            pool_.data() + component_size_ * last_index, component_size_);
+        pool_index_2_entity_id_[index] = last_id;
+        entity_id_2_pool_index_[last_id] = index;
+        SetEnabledByIndex(index, IsEnabledByIndex(last_index));
+    }
+
+    std::memset(pool_.data() + component_size_ * last_index, 0, component_size_);
+    pool_index_2_entity_id_.pop_back();
+    SetEnabledByIndex(last_index, false);
+    --component_count_;
+
+    if (recorder_)
+    {
+        recorder_->RecordDestroy(*this, id);
+    }
+}
+
+ComponentPool::BlockAllocator::BlockAllocator(ComponentPool & pool, std::size_t block_size)
+    : pool_(pool)
+    , block_size_(block_size)
+{
+}
+
+void* ComponentPool::BlockAllocator::AllocateComponent(EntityId id)
+{
+    // Checked on every call: after EndConcurrentAllocation the rest of a block may
+    // already hold compacted components or lie past the end of the pool
+    if (!pool_.concurrent_allocation_active_)
+    {
+        throw std::runtime_error("Concurrent allocation is not active!");
+    }
+
+    if (next_index_ == end_index_ || session_ != pool_.concurrent_session_)
+    {
+        // Claim the next block, no other thread will ever touch this index range
+        std::size_t begin_index = pool_.concurrent_next_index_.fetch_add(block_size_, std::memory_order_relaxed);
+        if (begin_index >= pool_.concurrent_end_index_)
+        {
+            throw std::runtime_error("Concurrent allocation capacity exceeded!");
+        }
+
+        next_index_ = begin_index;
+        end_index_ = std::min(begin_index + block_size_, pool_.concurrent_end_index_);
+        session_ = pool_.concurrent_session_;
+    }
+
+    pool_.pool_index_2_entity_id_[next_index_] = id;
+    return pool_.pool_.data() + pool_.component_size_ * (next_index_++);
+}
+
+void ComponentPool::BeginConcurrentAllocation(std::size_t max_component_count)
+{
+    if (concurrent_allocation_active_)
+    {
+        throw std::runtime_error("Concurrent allocation is already active!");
+    }
+
+    concurrent_end_index_ = component_count_ + max_component_count;
+
+    // All storage is reserved upfront, so workers never reallocate the pool
+    if (component_size_ * concurrent_end_index_ > pool_.size())
+    {
+        std::size_t grow_count = (concurrent_end_index_ + kComponentPoolGrowCount - 1) / kComponentPoolGrowCount;
+        pool_.resize(component_size_ * kComponentPoolGrowCount * grow_count);
+    }
+
+    // Slots which are never allocated keep the invalid id and are compacted away later
+    pool_index_2_entity_id_.resize(concurrent_end_index_, kInvalidEntityId);
+    concurrent_next_index_.store(component_count_, std::memory_order_relaxed);
+    ++concurrent_session_;
+    concurrent_allocation_active_ = true;
+}
+
+void ComponentPool::EndConcurrentAllocation()
+{
+    if (!concurrent_allocation_active_)
+    {
+        throw std::runtime_error("Concurrent allocation is not active!");
+    }
+
+    std::size_t used_end_index = std::min(concurrent_next_index_.load(), concurrent_end_index_);
+
+    // Register the new ids before anything moves, so a duplicate can still be rolled back
+    for (std::size_t read_index = component_count_; read_index < used_end_index; ++read_index)
+    {
+        EntityId id = pool_index_2_entity_id_[read_index];
+        if (id == kInvalidEntityId || entity_id_2_pool_index_.emplace(id, read_index).second)
+        {
+            continue;
+        }
+
+        // Everything registered so far is new to the pool, drop it along with the whole session
+        for (std::size_t index = component_count_; index < read_index; ++index)
+        {
+            if (pool_index_2_entity_id_[index] != kInvalidEntityId)
+            {
+                entity_id_2_pool_index_.erase(pool_index_2_entity_id_[index]);
+            }
+        }
+
+        std::memset(pool_.data() + component_size_ * component_count_, 0,
+            component_size_ * (used_end_index - component_count_));
+        pool_index_2_entity_id_.resize(component_count_);
+        concurrent_allocation_active_ = false;
+        throw std::runtime_error("Component is already allocated!");
+    }
+
+    std::size_t write_index = component_count_;
+    for (std::size_t read_index = component_count_; read_index < used_end_index; ++read_index)
+    {
+        EntityId id = pool_index_2_entity_id_[read_index];
+        if (id == kInvalidEntityId)
+        {
+            continue;
+        }
+
+        if (read_index != write_index)
+        {
+            std::memcpy(pool_.data() + component_size_ * write_index,
+                pool_.data() + component_size_ * read_index, component_size_);
+            entity_id_2_pool_index_[id] = write_index;
+        }
+
+        pool_index_2_entity_id_[write_index++] = id;
+    }
+
+    // Keep unused storage zeroed as if it had never been handed out
+    std::memset(pool_.data() + component_size_ * write_index, 0,
+        component_size_ * (used_end_index - write_index));
+
+    for (std::size_t index = component_count_; index < write_index; ++index)
+    {
+        SetEnabledByIndex(index, true);
+    }
+
+    std::size_t first_new_index = component_count_;
+    component_count_ = write_index;
+    pool_index_2_entity_id_.resize(component_count_);
+    concurrent_allocation_active_ = false;
+
+    // Workers don't touch the recorder, publish the new components in pool order
+    if (recorder_)
+    {
+        for (std::size_t index = first_new_index; index < component_count_; ++index)
+        {
+            recorder_->RecordCreate(*this, pool_index_2_entity_id_[index]);
+            recorder_->RecordWrite(*this, pool_index_2_entity_id_[index]);
+        }
+    }
 }
@@ -2,29 +2,72 @@
 #define COMPONENT_MANAGER_HPP_
 
 #include "component.hpp"
+#include "buffer_arena.hpp"
+#include "shared_component_pool.hpp"
+#include "bit_utils.hpp"
+#include "world_recorder.hpp"
 #include <memory>
 #include <vector>
 #include <unordered_map>
 #include <typeinfo>
 #include <stdexcept>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <type_traits>
 
 constexpr std::size_t kComponentPoolGrowCount = 1024u;
+constexpr std::size_t kComponentBlockSize = 64u;
 
 class ComponentPool
 {
 public:
-    ComponentPool(ComponentTypeId component_type_id, std::size_t component_size)
+    // Hands out components from blocks carved from the pool during concurrent allocation.
+    // Create one allocator per thread, blocks are claimed with a single atomic increment
+    class BlockAllocator
+    {
+    public:
+        BlockAllocator(ComponentPool & pool, std::size_t block_size = kComponentBlockSize);
+        // Thread-safe as long as every thread uses its own allocator
+        void* AllocateComponent(EntityId id);
+
+    private:
+        ComponentPool & pool_;
+        std::size_t block_size_;
+        std::size_t next_index_ = 0;
+        std::size_t end_index_ = 0;
+        // Concurrent allocation session the current block was claimed in
+        std::uint64_t session_ = 0;
+
+    };
+
+    ComponentPool(ComponentTypeId component_type_id, std::size_t component_size, char const* name)
         : component_type_id_(component_type_id)
         , component_size_(component_size)
+        , name_(name)
     {
         pool_.resize(component_size_ * kComponentPoolGrowCount);
     }
 
     ComponentTypeId GetComponentTypeId() const { return component_type_id_; }
+    std::size_t GetComponentSize() const { return component_size_; }
+    std::size_t GetComponentCount() const { return component_count_; }
+    // Name the component class was registered with, stable across builds
+    std::string const& GetName() const { return name_; }
+
+    // Structural changes are reported to the recorder while it is set
+    void SetRecorder(WorldRecorder* recorder) { recorder_ = recorder; }
+    WorldRecorder* GetRecorder() const { return recorder_; }
     // Don't keep this pointer for a long time!
     // This operation can invalidate iterators on the next allocation
     void* AllocateComponent(EntityId id)
     {
+        if (concurrent_allocation_active_)
+        {
+            throw std::runtime_error("Use BlockAllocator while concurrent allocation is active!");
+        }
+
         auto it = entity_id_2_pool_index_.find(id);
         if (it != entity_id_2_pool_index_.end())
         {
@@ -32,12 +75,19 @@ public:
         }
 
         // Grow pool if we don't have enough space
-        if (component_size_ * component_count_ > pool_.size())
+        if (component_size_ * (component_count_ + 1) > pool_.size())
         {
             pool_.resize(pool_.size() + component_size_ * kComponentPoolGrowCount);
         }
 
         entity_id_2_pool_index_.emplace(id, component_count_);
+        pool_index_2_entity_id_.push_back(id);
+        SetEnabledByIndex(component_count_, true);
+
+        if (recorder_)
+        {
+            recorder_->RecordCreate(*this, id);
+        }
 
         return pool_.data() + component_size_ * (component_count_++);
     }
@@ -53,12 +103,110 @@ public:
         return pool_.data() + component_size_ * it->second;
     }
 
+    // Returns nullptr instead of throwing, for joins over several pools
+    void* TryGetComponent(EntityId id)
+    {
+        auto it = entity_id_2_pool_index_.find(id);
+        return it != entity_id_2_pool_index_.end() ? pool_.data() + component_size_ * it->second : nullptr;
+    }
+
+    // Moves the last component into the freed slot, so pointers and indices
+    // of the last component change. DynamicBuffer members must be released before
+    void FreeComponent(EntityId id);
+
+    // Overflow storage for DynamicBuffer members of this pool's components
+    BufferArena & GetBufferArena() { return buffer_arena_; }
+
+    // Dense access for iteration, index must be less than GetComponentCount()
+    void* GetComponentByIndex(std::size_t index) { return pool_.data() + component_size_ * index; }
+    EntityId GetEntityIdByIndex(std::size_t index) const { return pool_index_2_entity_id_[index]; }
+
+    // Disabled components keep their storage but are skipped by ForEachEnabled.
+    // Toggling is a single bit flip, no memory is moved
+    void SetEnabled(EntityId id, bool enabled)
+    {
+        SetEnabledByIndex(GetIndex(id), enabled);
+
+        if (recorder_)
+        {
+            recorder_->RecordSetEnabled(*this, id, enabled);
+        }
+    }
+
+    bool IsEnabled(EntityId id) const { return IsEnabledByIndex(GetIndex(id)); }
+
+    void SetEnabledByIndex(std::size_t index, bool enabled)
+    {
+        if (index / 64 >= enabled_masks_.size())
+        {
+            enabled_masks_.resize(index / 64 + 1, 0);
+        }
+
+        std::uint64_t bit = std::uint64_t(1) << (index % 64);
+        enabled_masks_[index / 64] = enabled ? (enabled_masks_[index / 64] | bit) : (enabled_masks_[index / 64] & ~bit);
+    }
+
+    bool IsEnabledByIndex(std::size_t index) const
+    {
+        return (enabled_masks_[index / 64] >> (index % 64)) & 1;
+    }
+
+    // Calls func(void* component, EntityId id) for enabled components in [begin_index, end_index).
+    // Skips whole words of disabled components and visits set bits only.
+    // func must not allocate components of this pool
+    template <class Func>
+    void ForEachEnabled(std::size_t begin_index, std::size_t end_index, Func func);
+
+    template <class Func>
+    void ForEachEnabled(Func func) { ForEachEnabled(0, component_count_, func); }
+
+    // Reorders components in place so that keys are ascending and fixes up the entity mapping.
+    // keys[i] belongs to the component at index i and is reordered along with it.
+    // Insertion sort is used on purpose: a pool sorted every frame stays nearly sorted,
+    // so the common case is a single linear pass over the keys
+    template <class Key>
+    void SortByKeys(std::vector<Key> & keys);
+
+    // Reserves space for up to max_component_count components which are then allocated
+    // from worker threads through BlockAllocator. Must be called from a single thread
+    void BeginConcurrentAllocation(std::size_t max_component_count);
+    // Compacts partially used blocks and publishes the new components to GetComponent.
+    // Must be called from a single thread after all workers are done. If an entity got a
+    // component twice, or already had one, the whole session is discarded and it throws
+    // with the pool as it was before BeginConcurrentAllocation
+    void EndConcurrentAllocation();
+
 private:
+    std::size_t GetIndex(EntityId id) const
+    {
+        auto it = entity_id_2_pool_index_.find(id);
+        if (it == entity_id_2_pool_index_.end())
+        {
+            throw std::runtime_error("Failed to find component!");
+        }
+
+        return it->second;
+    }
+
     ComponentTypeId component_type_id_;
     std::size_t component_size_;
+    std::string name_;
     std::size_t component_count_ = 0;
     std::vector<std::uint8_t> pool_;
     std::unordered_map<EntityId, std::size_t> entity_id_2_pool_index_;
+    std::vector<EntityId> pool_index_2_entity_id_;
+    // One bit per component, bits past component_count_ are always clear
+    std::vector<std::uint64_t> enabled_masks_;
+    std::vector<std::uint8_t> temp_component_;
+    BufferArena buffer_arena_;
+    WorldRecorder* recorder_ = nullptr;
+
+    // Concurrent allocation state
+    bool concurrent_allocation_active_ = false;
+    // Incremented by BeginConcurrentAllocation, blocks of earlier sessions are stale
+    std::uint64_t concurrent_session_ = 0;
+    std::size_t concurrent_end_index_ = 0;
+    std::atomic<std::size_t> concurrent_next_index_{ 0 };
 
 };
 
@@ -69,15 +217,173 @@ public:
     template <class T>
     T* CreateComponent(EntityId entity_id);
 
+    template <class T>
+    T* CreateComponent(ComponentPool::BlockAllocator & allocator, EntityId entity_id);
+
     template <class T>
     T* GetComponent(EntityId entity_id);
 
+    // Returns nullptr if the entity has no component of type T
+    template <class T>
+    T* TryGetComponent(EntityId entity_id) { return static_cast<T*>(GetComponentPool<T>().TryGetComponent(entity_id)); }
+
+    template <class T>
+    void DestroyComponent(EntityId entity_id) { GetComponentPool<T>().FreeComponent(entity_id); }
+
+    template <class T>
+    ComponentPool & GetComponentPool();
+
+    // Looks a pool up by the name it was registered with
+    ComponentPool & GetComponentPool(char const* name);
+    SharedComponentPoolBase & GetSharedComponentPool(char const* name);
+
+    // Every pool reports its structural changes to the recorder, nullptr stops recording
+    void SetRecorder(WorldRecorder* recorder);
+
+    // Records the current value of the component if a recorder is set.
+    // Call after modifying a component to make the change part of the recording
+    template <class T>
+    void MarkComponentWritten(EntityId entity_id);
+
+    template <class T>
+    BufferArena & GetBufferArena() { return GetComponentPool<T>().GetBufferArena(); }
+
+    // Shared components store each distinct value once, see SharedComponentPool
+    template <class T>
+    void SetSharedComponent(EntityId entity_id, T const& value);
+
+    template <class T>
+    T const& GetSharedComponent(EntityId entity_id);
+
+    template <class T>
+    void RemoveSharedComponent(EntityId entity_id);
+
+    // func(T const& value, EntityId const* entities, std::size_t entity_count) per distinct value
+    template <class T, class Func>
+    void ForEachSharedGroup(Func func);
+
+    template <class T>
+    SharedComponentPool<T> & GetSharedComponentPool();
+
+    template <class T>
+    void SetComponentEnabled(EntityId entity_id, bool enabled) { GetComponentPool<T>().SetEnabled(entity_id, enabled); }
+
+    template <class T>
+    bool IsComponentEnabled(EntityId entity_id) { return GetComponentPool<T>().IsEnabled(entity_id); }
+
+    // Calls func(T&) for every enabled component of type T in pool order
+    template <class T, class Func>
+    void ForEach(Func func);
+
+    // Sorts components of type T by key_func(T const&), e.g. by material or Morton code
+    template <class T, class KeyFunc>
+    void SortComponents(KeyFunc key_func);
+
 private:
     void CreateComponentPools();
     std::unordered_map<ComponentTypeId, std::unique_ptr<ComponentPool>> component_pools_;
+    std::unordered_map<ComponentTypeId, std::unique_ptr<SharedComponentPoolBase>> shared_component_pools_;
+    WorldRecorder* recorder_ = nullptr;
 
 };
 
+template <class Key>
+void ComponentPool::SortByKeys(std::vector<Key> & keys)
+{
+    if (concurrent_allocation_active_)
+    {
+        throw std::runtime_error("Can't sort pool while concurrent allocation is active!");
+    }
+
+    if (keys.size() != component_count_)
+    {
+        throw std::runtime_error("Sort key count doesn't match component count!");
+    }
+
+    temp_component_.resize(component_size_);
+    bool moved = false;
+
+    for (std::size_t i = 1; i < component_count_; ++i)
+    {
+        if (!(keys[i] < keys[i - 1]))
+        {
+            continue;
+        }
+
+        // Find the insertion point shifting keys on the way
+        Key key = std::move(keys[i]);
+        std::size_t j = i;
+        do
+        {
+            keys[j] = std::move(keys[j - 1]);
+            --j;
+        } while (j > 0 && key < keys[j - 1]);
+        keys[j] = std::move(key);
+        moved = true;
+
+        // Rotate components and entity ids of [j, i] by one slot
+        std::uint8_t* first = pool_.data() + component_size_ * j;
+        std::memcpy(temp_component_.data(), pool_.data() + component_size_ * i, component_size_);
+        std::memmove(first + component_size_, first, component_size_ * (i - j));
+        std::memcpy(first, temp_component_.data(), component_size_);
+
+        EntityId id = pool_index_2_entity_id_[i];
+        std::move_backward(pool_index_2_entity_id_.begin() + j,
+            pool_index_2_entity_id_.begin() + i, pool_index_2_entity_id_.begin() + i + 1);
+        pool_index_2_entity_id_[j] = id;
+
+        bool enabled = IsEnabledByIndex(i);
+        for (std::size_t k = i; k > j; --k)
+        {
+            SetEnabledByIndex(k, IsEnabledByIndex(k - 1));
+        }
+        SetEnabledByIndex(j, enabled);
+
+        for (std::size_t k = j; k <= i; ++k)
+        {
+            entity_id_2_pool_index_[pool_index_2_entity_id_[k]] = k;
+        }
+    }
+
+    if (moved && recorder_)
+    {
+        recorder_->RecordOrder(*this);
+    }
+}
+
+template <class Func>
+void ComponentPool::ForEachEnabled(std::size_t begin_index, std::size_t end_index, Func func)
+{
+    end_index = std::min(end_index, component_count_);
+    if (begin_index >= end_index)
+    {
+        return;
+    }
+
+    std::size_t first_word = begin_index / 64;
+    std::size_t last_word = (end_index - 1) / 64;
+
+    for (std::size_t word = first_word; word <= last_word; ++word)
+    {
+        std::uint64_t mask = enabled_masks_[word];
+        if (word == first_word)
+        {
+            mask &= ~std::uint64_t(0) << (begin_index % 64);
+        }
+        if (word == last_word && end_index % 64 != 0)
+        {
+            mask &= (std::uint64_t(1) << (end_index % 64)) - 1;
+        }
+
+        while (mask)
+        {
+            std::size_t index = word * 64 + CountTrailingZeros(mask);
+            mask &= mask - 1;
+            func(pool_.data() + component_size_ * index, pool_index_2_entity_id_[index]);
+        }
+    }
+}
+
 template <class T>
 ComponentTypeId GetComponentTypeId()
 {
@@ -97,6 +403,20 @@ T* ComponentManager::CreateComponent(EntityId entity_id)
     auto & pool = it->second;
     T* component = static_cast<T*>(pool->AllocateComponent(entity_id));
     component->entity_id_ = entity_id;
+
+    if (recorder_)
+    {
+        recorder_->RecordWrite(*pool, entity_id);
+    }
+
+    return component;
+}
+
+template <class T>
+T* ComponentManager::CreateComponent(ComponentPool::BlockAllocator & allocator, EntityId entity_id)
+{
+    T* component = static_cast<T*>(allocator.AllocateComponent(entity_id));
+    component->entity_id_ = entity_id;
     return component;
 }
 
@@ -114,7 +434,92 @@ T* ComponentManager::GetComponent(EntityId entity_id)
     return static_cast<T*>(pool->GetComponent(entity_id));
 }
 
+template <class T>
+ComponentPool & ComponentManager::GetComponentPool()
+{
+    ComponentTypeId type_id = GetComponentTypeId<T>();
+    auto it = component_pools_.find(type_id);
+    if (it == component_pools_.end())
+    {
+        throw std::runtime_error("Failed to get component pool: component type is not registered");
+    }
+
+    return *it->second;
+}
+
+template <class T>
+void ComponentManager::MarkComponentWritten(EntityId entity_id)
+{
+    if (recorder_)
+    {
+        recorder_->RecordWrite(GetComponentPool<T>(), entity_id);
+    }
+}
+
+template <class T, class Func>
+void ComponentManager::ForEach(Func func)
+{
+    GetComponentPool<T>().ForEachEnabled([&func](void* component, EntityId)
+    {
+        func(*static_cast<T*>(component));
+    });
+}
+
+template <class T, class KeyFunc>
+void ComponentManager::SortComponents(KeyFunc key_func)
+{
+    auto & pool = GetComponentPool<T>();
+
+    using Key = std::decay_t<decltype(key_func(std::declval<T const&>()))>;
+    std::vector<Key> keys;
+    keys.reserve(pool.GetComponentCount());
+    for (std::size_t i = 0; i < pool.GetComponentCount(); ++i)
+    {
+        keys.push_back(key_func(*static_cast<T const*>(pool.GetComponentByIndex(i))));
+    }
+
+    pool.SortByKeys(keys);
+}
+
+template <class T>
+void ComponentManager::SetSharedComponent(EntityId entity_id, T const& value)
+{
+    GetSharedComponentPool<T>().SetValue(entity_id, value);
+}
+
+template <class T>
+T const& ComponentManager::GetSharedComponent(EntityId entity_id)
+{
+    return GetSharedComponentPool<T>().GetValue(entity_id);
+}
+
+template <class T>
+void ComponentManager::RemoveSharedComponent(EntityId entity_id)
+{
+    GetSharedComponentPool<T>().RemoveValue(entity_id);
+}
+
+template <class T, class Func>
+void ComponentManager::ForEachSharedGroup(Func func)
+{
+    GetSharedComponentPool<T>().ForEachGroup(func);
+}
+
+template <class T>
+SharedComponentPool<T> & ComponentManager::GetSharedComponentPool()
+{
+    ComponentTypeId type_id = GetComponentTypeId<T>();
+    auto it = shared_component_pools_.find(type_id);
+    if (it == shared_component_pools_.end())
+    {
+        throw std::runtime_error("Failed to get shared component pool: component type is not registered");
+    }
+
+    return *static_cast<SharedComponentPool<T>*>(it->second.get());
+}
+
 void RegisterComponentPoolFactory(char const* type_name, ComponentPool* (*factory_fun)());
+void RegisterSharedComponentPoolFactory(char const* type_name, SharedComponentPoolBase* (*factory_fun)());
 
 #define REGISTER_COMPONENT_CLASS(CLASS, NAME) \
     class CLASS##_registerer \
@@ -124,10 +529,24 @@ void RegisterComponentPoolFactory(char const* type_name, ComponentPool* (*factor
         { \
             RegisterComponentPoolFactory(#NAME, []() \
             { \
-                return new ComponentPool(reinterpret_cast<ComponentTypeId>(typeid(CLASS).name()), sizeof(CLASS)); \
+                return new ComponentPool(reinterpret_cast<ComponentTypeId>(typeid(CLASS).name()), sizeof(CLASS), #NAME); \
             }); \
         } \
     }; \
     static CLASS##_registerer g_##CLASS##_registerer;
 
+#define REGISTER_SHARED_COMPONENT_CLASS(CLASS, NAME) \
+    class CLASS##_shared_registerer \
+    { \
+    public: \
+        CLASS##_shared_registerer() \
+        { \
+            RegisterSharedComponentPoolFactory(#NAME, []() -> SharedComponentPoolBase* \
+            { \
+                return new SharedComponentPool<CLASS>(reinterpret_cast<ComponentTypeId>(typeid(CLASS).name()), #NAME); \
+            }); \
+        } \
+    }; \
+    static CLASS##_shared_registerer g_##CLASS##_shared_registerer;
+
 #endif // COMPONENT_MANAGER_HPP_
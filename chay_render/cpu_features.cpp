@@ -0,0 +1,126 @@
+#include "cpu_features.hpp"
+#include <cstdint>
+
+#if CHAY_SIMD_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+#if CHAY_SIMD_X86
+    void CpuId(std::uint32_t leaf, std::uint32_t subleaf, std::uint32_t regs[4])
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i)
+        {
+            regs[i] = static_cast<std::uint32_t>(info[i]);
+        }
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    std::uint64_t ReadXcr0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        std::uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#endif
+    }
+#endif
+
+    CpuFeatures DetectCpuFeatures()
+    {
+        CpuFeatures features;
+
+#if CHAY_SIMD_X86
+        std::uint32_t regs[4];
+        CpuId(0, 0, regs);
+        std::uint32_t max_leaf = regs[0];
+
+        CpuId(1, 0, regs);
+        features.sse41 = (regs[2] & (1u << 19)) != 0;
+        bool osxsave = (regs[2] & (1u << 27)) != 0;
+        bool avx = (regs[2] & (1u << 28)) != 0;
+        features.fma = (regs[2] & (1u << 12)) != 0;
+        features.f16c = (regs[2] & (1u << 29)) != 0;
+
+        // AVX state must be enabled by the OS, otherwise YMM/ZMM instructions fault
+        std::uint64_t xcr0 = osxsave ? ReadXcr0() : 0;
+        bool os_avx = (xcr0 & 0x6) == 0x6;
+        bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+        if (!avx || !os_avx)
+        {
+            features.fma = false;
+            features.f16c = false;
+            return features;
+        }
+
+        if (max_leaf >= 7)
+        {
+            CpuId(7, 0, regs);
+            features.avx2 = (regs[1] & (1u << 5)) != 0;
+            if (os_avx512)
+            {
+                features.avx512f = (regs[1] & (1u << 16)) != 0;
+                features.avx512dq = (regs[1] & (1u << 17)) != 0;
+                features.avx512bw = (regs[1] & (1u << 30)) != 0;
+                features.avx512vl = (regs[1] & (1u << 31)) != 0;
+            }
+        }
+#endif
+
+        return features;
+    }
+}
+
+CpuFeatures const& GetCpuFeatures()
+{
+    static CpuFeatures features = DetectCpuFeatures();
+    return features;
+}
+
+SimdLevel GetMaxSimdLevel()
+{
+    CpuFeatures const& features = GetCpuFeatures();
+
+    // AVX2 kernels are compiled with FMA and F16C, AVX-512 ones with the Skylake-X subset
+    bool avx2 = features.avx2 && features.fma && features.f16c;
+    if (avx2 && features.avx512f && features.avx512dq && features.avx512bw && features.avx512vl)
+    {
+        return SimdLevel::kAvx512;
+    }
+
+    if (avx2)
+    {
+        return SimdLevel::kAvx2;
+    }
+
+    return features.sse41 ? SimdLevel::kSse41 : SimdLevel::kScalar;
+}
+
+char const* GetSimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::kSse41:
+        return "sse41";
+    case SimdLevel::kAvx2:
+        return "avx2";
+    case SimdLevel::kAvx512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
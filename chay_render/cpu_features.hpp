@@ -0,0 +1,36 @@
+#ifndef CPU_FEATURES_HPP_
+#define CPU_FEATURES_HPP_
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CHAY_SIMD_X86 1
+#else
+#define CHAY_SIMD_X86 0
+#endif
+
+// Instruction set levels the math kernels are compiled for, each level implies the previous ones
+enum class SimdLevel
+{
+    kScalar,
+    kSse41,
+    kAvx2,
+    kAvx512
+};
+
+struct CpuFeatures
+{
+    bool sse41 = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool avx512f = false;
+    bool avx512dq = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+};
+
+// Detected once, includes the check that the OS saves AVX/AVX-512 registers
+CpuFeatures const& GetCpuFeatures();
+SimdLevel GetMaxSimdLevel();
+char const* GetSimdLevelName(SimdLevel level);
+
+#endif // CPU_FEATURES_HPP_
@@ -0,0 +1,122 @@
+#ifndef DYNAMIC_BUFFER_HPP_
+#define DYNAMIC_BUFFER_HPP_
+
+#include "buffer_arena.hpp"
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+// Variable-length array to be embedded into components.
+// Up to InlineCapacity elements live inside the component itself, larger buffers
+// overflow into the BufferArena of the owning pool (ComponentManager::GetBufferArena<T>()).
+// All-zero memory is a valid empty buffer, so it works with pool-allocated components,
+// and it holds no pointers into itself, so pools can move components freely.
+// Call Release before the component is destroyed to return overflow storage.
+template <class T, std::size_t InlineCapacity>
+class DynamicBuffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "DynamicBuffer elements must be trivially copyable");
+    static_assert(InlineCapacity > 0, "DynamicBuffer needs at least one inline element");
+
+public:
+    DynamicBuffer()
+        : size_(0)
+        , capacity_(0)
+    {}
+
+    std::size_t GetSize() const { return size_; }
+    std::size_t GetCapacity() const { return IsInline() ? InlineCapacity : capacity_; }
+    bool IsEmpty() const { return size_ == 0; }
+    bool IsInline() const { return capacity_ == 0; }
+
+    T* GetData() { return IsInline() ? reinterpret_cast<T*>(inline_storage_) : heap_data_; }
+    T const* GetData() const { return IsInline() ? reinterpret_cast<T const*>(inline_storage_) : heap_data_; }
+
+    T & operator[](std::size_t index) { return GetData()[index]; }
+    T const& operator[](std::size_t index) const { return GetData()[index]; }
+
+    T* begin() { return GetData(); }
+    T* end() { return GetData() + size_; }
+    T const* begin() const { return GetData(); }
+    T const* end() const { return GetData() + size_; }
+
+    void PushBack(BufferArena & arena, T const& value)
+    {
+        if (size_ == GetCapacity())
+        {
+            Reserve(arena, GetCapacity() * 2);
+        }
+
+        GetData()[size_++] = value;
+    }
+
+    void PopBack()
+    {
+        --size_;
+    }
+
+    // New elements are left uninitialized
+    void Resize(BufferArena & arena, std::size_t size)
+    {
+        Reserve(arena, size);
+        size_ = static_cast<std::uint32_t>(size);
+    }
+
+    void Reserve(BufferArena & arena, std::size_t capacity)
+    {
+        if (capacity <= GetCapacity())
+        {
+            return;
+        }
+
+        if (capacity > UINT32_MAX)
+        {
+            throw std::runtime_error("DynamicBuffer capacity overflow!");
+        }
+
+        // Use the whole arena block, it is rounded up to a power of two anyway
+        std::size_t new_capacity = BufferArena::GetBlockSize(capacity * sizeof(T)) / sizeof(T);
+        T* new_data = static_cast<T*>(arena.Allocate(new_capacity * sizeof(T)));
+        std::memcpy(new_data, GetData(), size_ * sizeof(T));
+
+        if (!IsInline())
+        {
+            arena.Free(heap_data_, capacity_ * sizeof(T));
+        }
+
+        heap_data_ = new_data;
+        capacity_ = static_cast<std::uint32_t>(new_capacity);
+    }
+
+    // Keeps the storage
+    void Clear()
+    {
+        size_ = 0;
+    }
+
+    // Returns overflow storage to the arena, the buffer becomes empty and inline again
+    void Release(BufferArena & arena)
+    {
+        if (!IsInline())
+        {
+            arena.Free(heap_data_, capacity_ * sizeof(T));
+        }
+
+        size_ = 0;
+        capacity_ = 0;
+    }
+
+private:
+    std::uint32_t size_;
+    // Zero means the elements are stored inline
+    std::uint32_t capacity_;
+    union
+    {
+        T* heap_data_;
+        alignas(T) std::uint8_t inline_storage_[sizeof(T) * InlineCapacity];
+    };
+
+};
+
+#endif // DYNAMIC_BUFFER_HPP_
@@ -7,6 +7,7 @@ class EntityManager;
 class ComponentManager;
 
 typedef std::uint64_t EntityId;
+constexpr EntityId kInvalidEntityId = ~EntityId(0);
 
 class Entity
 {
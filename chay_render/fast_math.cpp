@@ -0,0 +1,36 @@
+#include "fast_math.hpp"
+
+void FastSinCos(const float* x, float* sin, float* cos, std::size_t count)
+{
+    GetMathKernels().fast_sincos(x, sin, cos, count);
+}
+
+void FastRsqrt(const float* x, float* result, std::size_t count)
+{
+    GetMathKernels().fast_rsqrt(x, result, count);
+}
+
+void FastAtan2(const float* y, const float* x, float* result, std::size_t count)
+{
+    GetMathKernels().fast_atan2(y, x, result, count);
+}
+
+void FastExp(const float* x, float* result, std::size_t count)
+{
+    GetMathKernels().fast_exp(x, result, count);
+}
+
+void FastLog(const float* x, float* result, std::size_t count)
+{
+    GetMathKernels().fast_log(x, result, count);
+}
+
+void NormalizeVectors(const float3* vectors, float3* result, std::size_t count)
+{
+    GetMathKernels().normalize_vectors(&vectors->x, &result->x, count);
+}
+
+void RotationMatrices(const float3* axes, const float* angles, Matrix* result, std::size_t count)
+{
+    GetMathKernels().rotation_matrices(&axes->x, angles, &result->m[0][0], count);
+}
@@ -0,0 +1,143 @@
+#ifndef FAST_MATH_HPP_
+#define FAST_MATH_HPP_
+
+#include "mathlib.hpp"
+#include "math_kernels.hpp"
+#include <cstdint>
+
+// Polynomial approximations that avoid libm calls. Scalar versions are inline, array
+// versions run on the best SIMD kernel and give the same results up to rounding.
+// Error bounds were measured against double precision libm over the given ranges:
+//   FastSinCos  |x| <= 8192         absolute error <= 2e-7
+//   FastRsqrt   normal x > 0         relative error <= 3e-7 (exact 1 / sqrt without SSE)
+//   FastAtan2   finite x, y          absolute error <= 4e-7 rad, atan2(0, 0) = 0
+//   FastExp     -87.3 <= x <= 88     relative error <= 2e-7, inputs are clamped to the range
+//   FastLog     normal x > 0         absolute error <= 2e-7 where |log x| <= 1, relative elsewhere
+// Out of range inputs give unspecified results rather than NaN or infinity guarantees.
+
+inline void FastSinCos(float x, float& sin, float& cos)
+{
+    // Quadrant and Cody-Waite reduction to [-pi/4, pi/4]
+    float j = std::nearbyint(x * kFastTwoOverPi);
+    float r = x - j * kFastPiOverTwo[0];
+    r = r - j * kFastPiOverTwo[1];
+    r = r - j * kFastPiOverTwo[2];
+    std::int32_t quadrant = static_cast<std::int32_t>(j);
+
+    float r2 = r * r;
+    float s = r + r * r2 * ((kFastSin[0] * r2 + kFastSin[1]) * r2 + kFastSin[2]);
+    float c = 1.0f - 0.5f * r2 + r2 * r2 * ((kFastCos[0] * r2 + kFastCos[1]) * r2 + kFastCos[2]);
+
+    bool swap = (quadrant & 1) != 0;
+    sin = swap ? c : s;
+    cos = swap ? s : c;
+    sin = (quadrant & 2) != 0 ? -sin : sin;
+    cos = ((quadrant + 1) & 2) != 0 ? -cos : cos;
+}
+
+inline float FastSin(float x)
+{
+    float sin, cos;
+    FastSinCos(x, sin, cos);
+    return sin;
+}
+
+inline float FastCos(float x)
+{
+    float sin, cos;
+    FastSinCos(x, sin, cos);
+    return cos;
+}
+
+inline float FastRsqrt(float x)
+{
+#if CHAY_SIMD_X86
+    // 12-bit estimate refined with one Newton-Raphson step
+    float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    return y * (1.5f - 0.5f * x * y * y);
+#else
+    return 1.0f / std::sqrt(x);
+#endif
+}
+
+inline float FastAtan2(float y, float x)
+{
+    float ax = std::abs(x);
+    float ay = std::abs(y);
+    float a = std::fmin(ax, ay) / std::fmax(std::fmax(ax, ay), 1e-30f);
+    float s = a * a;
+
+    float p = kFastAtan[0];
+    for (int i = 1; i < 8; ++i)
+    {
+        p = p * s + kFastAtan[i];
+    }
+
+    float r = a + a * s * p;
+    r = ay > ax ? MATH_PIDIV2 - r : r;
+    r = x < 0.0f ? MATH_PI - r : r;
+    return std::copysign(r, y);
+}
+
+inline float FastExp(float x)
+{
+    x = std::fmin(std::fmax(x, kFastExpMin), kFastExpMax);
+    float n = std::nearbyint(x * kFastLog2E);
+    float r = x - n * kFastLn2[0] - n * kFastLn2[1];
+
+    float p = kFastExp[0];
+    for (int i = 1; i < 6; ++i)
+    {
+        p = p * r + kFastExp[i];
+    }
+
+    float y = p * r * r + r + 1.0f;
+    std::int32_t scale_bits = (static_cast<std::int32_t>(n) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &scale_bits, sizeof(scale));
+    return y * scale;
+}
+
+inline float FastLog(float x)
+{
+    // x = m * 2^e with m in [sqrt(0.5), sqrt(2))
+    std::uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    float e = static_cast<float>(static_cast<std::int32_t>(bits >> 23) - 126);
+    bits = (bits & 0x007fffffu) | 0x3f000000u;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    if (m < kFastSqrtHalf)
+    {
+        e -= 1.0f;
+        m = m + m - 1.0f;
+    }
+    else
+    {
+        m = m - 1.0f;
+    }
+
+    float z = m * m;
+    float p = kFastLog[0];
+    for (int i = 1; i < 9; ++i)
+    {
+        p = p * m + kFastLog[i];
+    }
+
+    float y = p * m * z + e * kFastLn2[1] - 0.5f * z;
+    return m + y + e * kFastLn2[0];
+}
+
+// Array versions, result arrays may alias the inputs
+void FastSinCos(const float* x, float* sin, float* cos, std::size_t count);
+void FastRsqrt(const float* x, float* result, std::size_t count);
+void FastAtan2(const float* y, const float* x, float* result, std::size_t count);
+void FastExp(const float* x, float* result, std::size_t count);
+void FastLog(const float* x, float* result, std::size_t count);
+
+// Batched float3::normalize with FastRsqrt, zero vectors give NaN
+void NormalizeVectors(const float3* vectors, float3* result, std::size_t count);
+// Batched Matrix::RotationAxis with FastSinCos and FastRsqrt
+void RotationMatrices(const float3* axes, const float* angles, Matrix* result, std::size_t count);
+
+#endif // FAST_MATH_HPP_
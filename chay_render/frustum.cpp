@@ -0,0 +1,73 @@
+#include "mathlib.hpp"
+#include "math_kernels.hpp"
+#include <stdexcept>
+
+Frustum Frustum::FromViewProjection(const Matrix& view_projection)
+{
+    // Gribb-Hartmann: with clip = p * M, column j of M gives clip component j
+    const auto& m = view_projection.m;
+    float4 column[4];
+    for (int j = 0; j < 4; ++j)
+    {
+        column[j] = float4(m[0][j], m[1][j], m[2][j], m[3][j]);
+    }
+
+    Frustum frustum;
+    frustum.planes[0] = column[3] + column[0];
+    frustum.planes[1] = column[3] - column[0];
+    frustum.planes[2] = column[3] + column[1];
+    frustum.planes[3] = column[3] - column[1];
+    frustum.planes[4] = column[2];
+    frustum.planes[5] = column[3] - column[2];
+
+    for (float4& plane : frustum.planes)
+    {
+        plane = plane * (1.0f / plane.xyz().length());
+    }
+
+    return frustum;
+}
+
+static_assert(sizeof(Frustum) == sizeof(float) * 24, "Culling kernels expect packed planes");
+
+namespace
+{
+    void CheckFrustumCount(std::size_t frustum_count)
+    {
+        if (frustum_count == 0 || frustum_count > kMaxCullViews)
+        {
+            throw std::runtime_error("Multi-view culling needs 1 to kMaxCullViews frusta!");
+        }
+    }
+}
+
+void CullSpheres(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius,
+                 std::uint8_t* result, std::size_t count)
+{
+    GetMathKernels().cull_spheres(&frustum.planes[0].x, x, y, z, radius, result, count);
+}
+
+void CullAabbs(const Frustum& frustum, const float* center_x, const float* center_y, const float* center_z,
+               const float* extent_x, const float* extent_y, const float* extent_z,
+               std::uint8_t* result, std::size_t count)
+{
+    GetMathKernels().cull_aabbs(&frustum.planes[0].x, center_x, center_y, center_z,
+                                extent_x, extent_y, extent_z, result, count);
+}
+
+void CullSpheres(const Frustum* frusta, std::size_t frustum_count, const float* x, const float* y, const float* z,
+                 const float* radius, std::uint32_t* visibility, std::size_t count)
+{
+    CheckFrustumCount(frustum_count);
+    GetMathKernels().cull_spheres_multi(&frusta->planes[0].x, frustum_count, x, y, z, radius, visibility, count);
+}
+
+void CullAabbs(const Frustum* frusta, std::size_t frustum_count,
+               const float* center_x, const float* center_y, const float* center_z,
+               const float* extent_x, const float* extent_y, const float* extent_z,
+               std::uint32_t* visibility, std::size_t count)
+{
+    CheckFrustumCount(frustum_count);
+    GetMathKernels().cull_aabbs_multi(&frusta->planes[0].x, frustum_count, center_x, center_y, center_z,
+                                      extent_x, extent_y, extent_z, visibility, count);
+}
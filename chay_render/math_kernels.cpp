@@ -0,0 +1,48 @@
+#include "math_kernels.hpp"
+
+namespace
+{
+    MathKernels CreateMathKernels(SimdLevel level)
+    {
+        MathKernels kernels;
+        FillMathKernelsScalar(kernels);
+
+#if CHAY_SIMD_X86
+        if (level >= SimdLevel::kSse41)
+        {
+            FillMathKernelsSse41(kernels);
+        }
+
+        if (level >= SimdLevel::kAvx2)
+        {
+            FillMathKernelsAvx2(kernels);
+        }
+
+        if (level >= SimdLevel::kAvx512)
+        {
+            FillMathKernelsAvx512(kernels);
+        }
+#endif
+
+        return kernels;
+    }
+}
+
+MathKernels const& GetMathKernels()
+{
+    static MathKernels kernels = CreateMathKernels(GetMaxSimdLevel());
+    return kernels;
+}
+
+MathKernels const& GetMathKernels(SimdLevel level)
+{
+    static MathKernels const kernels[] =
+    {
+        CreateMathKernels(SimdLevel::kScalar),
+        CreateMathKernels(GetMaxSimdLevel() >= SimdLevel::kSse41 ? SimdLevel::kSse41 : SimdLevel::kScalar),
+        CreateMathKernels(GetMaxSimdLevel() >= SimdLevel::kAvx2 ? SimdLevel::kAvx2 : GetMaxSimdLevel()),
+        CreateMathKernels(GetMaxSimdLevel())
+    };
+
+    return kernels[static_cast<int>(level)];
+}
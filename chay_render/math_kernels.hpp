@@ -0,0 +1,208 @@
+#ifndef MATH_KERNELS_HPP_
+#define MATH_KERNELS_HPP_
+
+#include "cpu_features.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Per-object results of the culling kernels
+constexpr std::uint8_t kCullOutside = 0;
+constexpr std::uint8_t kCullIntersect = 1;
+constexpr std::uint8_t kCullInside = 2;
+// Views a multi-view culling kernel tests at once, one bit of a std::uint32_t each
+constexpr std::size_t kMaxCullViews = 32;
+
+// Hit distance written by the ray kernels for misses
+constexpr float kRayMiss = 3.402823466e+38f;
+
+// Structure-of-arrays inputs of the ray kernels, every array has the count passed to the kernel
+struct RayArrays
+{
+    float const* origin[3];
+    float const* direction[3];
+    // 1 / direction, only read by the box kernels
+    float const* inv_direction[3];
+    float const* t_max;
+};
+
+struct AabbArrays
+{
+    float const* min_point[3];
+    float const* max_point[3];
+};
+
+struct TriangleArrays
+{
+    float const* v0[3];
+    float const* v1[3];
+    float const* v2[3];
+};
+
+// Normalized integer formats of the conversion kernels. snorm maps [-1, 1] to [-127, 127]
+// or [-32767, 32767], unorm maps [0, 1] to [0, 255] or [0, 65535]
+enum class NormFormat
+{
+    kSnorm8,
+    kUnorm8,
+    kSnorm16,
+    kUnorm16
+};
+
+// Lattice noise flavours of the noise kernel: value noise interpolates random lattice values,
+// gradient noise is improved Perlin noise and simplex noise is Gustavson's 3D variant
+enum class NoiseType
+{
+    kValue,
+    kGradient,
+    kSimplex
+};
+
+// Number of interleaved xoshiro128** streams in a random state of 4 x kRandomStreams words
+constexpr std::size_t kRandomStreams = 8;
+
+// Polynomial coefficients shared by fast_math.hpp and the kernels, Cephes for sin, cos,
+// exp and log, Abramowitz-Stegun 4.4.49 for atan on [0, 1]
+constexpr float kFastTwoOverPi = 0.636619772f;
+constexpr float kFastPiOverTwo[3] = { 1.5703125f, 4.837512969970703125e-4f, 7.54978995489188216e-8f };
+constexpr float kFastSin[3] = { -1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f };
+constexpr float kFastCos[3] = { 2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f };
+constexpr float kFastAtan[8] = { 0.0028662257f, -0.0161657367f, 0.0429096138f, -0.0752896400f,
+                                 0.1065626393f, -0.1420889944f, 0.1999355085f, -0.3333314528f };
+constexpr float kFastLog2E = 1.44269504088896341f;
+constexpr float kFastLn2[2] = { 0.693359375f, -2.12194440e-4f };
+constexpr float kFastExpMin = -87.3365479f;
+constexpr float kFastExpMax = 88.0f;
+constexpr float kFastExp[6] = { 1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+                                4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f };
+constexpr float kFastSqrtHalf = 0.707106781186547524f;
+constexpr float kFastLog[9] = { 7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f, -1.2420140846e-1f,
+                                1.4249322787e-1f, -1.6668057665e-1f, 2.0000714765e-1f, -2.4999993993e-1f,
+                                3.3333331174e-1f };
+
+// Table of math kernels for one instruction set level. Matrices are float[16] in
+// Matrix::m row-major layout. Every level starts from the table of the previous
+// level and overrides the kernels it has a faster version of.
+//
+// Kernel translation units are compiled with their own ISA flags, so they must only
+// include this header and intrinsics: inline functions from other headers would be
+// emitted with AVX code and the linker may pick that copy for the whole program.
+// The scalar unit has no extra flags and may use the regular headers.
+struct MathKernels
+{
+    // result = a * b, result may alias a or b
+    void (*multiply_matrix)(float const* a, float const* b, float* result);
+    // General inverse via cofactors, singular matrices produce infinities.
+    // result may alias m for all inverse kernels
+    void (*invert_matrix)(float const* m, float* result);
+    // Inverse of [A c; r 1] where either the translation column c or row r is zero,
+    // which covers both Translation() style and LookAt*() style matrices
+    void (*invert_affine)(float const* m, float* result);
+    // Same as invert_affine but A must be a pure rotation, so its inverse is the transpose
+    void (*invert_rigid)(float const* m, float* result);
+
+    // Batches, result may alias the input. Points and normals are packed float3 (AoS)
+    // or separate x, y, z arrays (SoA) and use the Matrix * float3 convention
+    void (*transform_points)(float const* m, float const* points, float* result, std::size_t count);
+    // Like transform_points but without translation
+    void (*transform_vectors)(float const* m, float const* vectors, float* result, std::size_t count);
+    void (*transform_points_soa)(float const* m, float const* x, float const* y, float const* z,
+                                 float* result_x, float* result_y, float* result_z, std::size_t count);
+    // result[i] = a[i] * b[i]
+    void (*multiply_matrices)(float const* a, float const* b, float* result, std::size_t count);
+
+    // Frustum classification of SoA bounds into kCull* values. planes is 6 x (nx, ny, nz, d)
+    // with normals pointing inside, a point p is inside a plane when dot(n, p) + d >= 0
+    void (*cull_spheres)(float const* planes, float const* x, float const* y, float const* z,
+                         float const* radius, std::uint8_t* result, std::size_t count);
+    // Boxes are given by center and half extents
+    void (*cull_aabbs)(float const* planes, float const* center_x, float const* center_y, float const* center_z,
+                       float const* extent_x, float const* extent_y, float const* extent_z,
+                       std::uint8_t* result, std::size_t count);
+    // Multi-view variants that read every bound once: planes is view_count x 6 x 4, at most
+    // kMaxCullViews, and bit v of visibility[i] is set unless bound i is outside view v
+    void (*cull_spheres_multi)(float const* planes, std::size_t view_count, float const* x, float const* y, float const* z,
+                               float const* radius, std::uint32_t* visibility, std::size_t count);
+    void (*cull_aabbs_multi)(float const* planes, std::size_t view_count,
+                             float const* center_x, float const* center_y, float const* center_z,
+                             float const* extent_x, float const* extent_y, float const* extent_z,
+                             std::uint32_t* visibility, std::size_t count);
+
+    // Bounds of count float3 positions that are stride floats apart (stride >= 3),
+    // so interleaved vertex data and arrays of boxes work without copies
+    void (*compute_bounds)(float const* points, std::size_t stride, std::size_t count, float* min, float* max);
+    // Largest squared distance from center to the points, same layout as compute_bounds
+    float (*max_distance_sq)(float const* points, std::size_t stride, std::size_t count, float const* center);
+    // Arvo's method on boxes stored as (min xyz, max xyz), Matrix * float3 convention
+    void (*transform_aabbs)(float const* m, float const* boxes, float* result, std::size_t count);
+
+    // Ray queries. A single ray is 7 floats: origin, direction, t_max. Hits are within [0, t_max],
+    // t is the entry distance or kRayMiss. Box slab tests give NaN-free results only when
+    // the origin doesn't lie exactly on a slab plane of an axis the ray is parallel to
+    void (*intersect_ray_aabbs)(float const* ray, AabbArrays const& boxes, std::size_t count, float* t);
+    // Packet of rays against one box given as (min xyz, max xyz)
+    void (*intersect_rays_aabb)(RayArrays const& rays, std::size_t count, float const* box, float* t);
+    // Two-sided Moller-Trumbore, u and v are the barycentrics of v1 and v2 and are
+    // only meaningful for hits
+    void (*intersect_ray_triangles)(float const* ray, TriangleArrays const& triangles, std::size_t count,
+                                    float* t, float* u, float* v);
+    // Packet of rays against one triangle given as v0, v1, v2
+    void (*intersect_rays_triangle)(RayArrays const& rays, std::size_t count, float const* triangle,
+                                    float* t, float* u, float* v);
+
+    // Fast approximations over arrays, see fast_math.hpp for ranges and error bounds
+    void (*fast_sincos)(float const* x, float* sin, float* cos, std::size_t count);
+    void (*fast_rsqrt)(float const* x, float* result, std::size_t count);
+    void (*fast_atan2)(float const* y, float const* x, float* result, std::size_t count);
+    void (*fast_exp)(float const* x, float* result, std::size_t count);
+    void (*fast_log)(float const* x, float* result, std::size_t count);
+    // Packed float3, result may alias vectors
+    void (*normalize_vectors)(float const* vectors, float* result, std::size_t count);
+    // Matrix::RotationAxis for each packed float3 axis and angle, axes need not be unit length
+    void (*rotation_matrices)(float const* axes, float const* angles, float* result, std::size_t count);
+
+    // IEEE half precision with round to nearest even, overflow gives infinity
+    void (*float_to_half)(float const* src, std::uint16_t* dst, std::size_t count);
+    void (*half_to_float)(std::uint16_t const* src, float* dst, std::size_t count);
+    // Inputs are clamped to the format range and rounded to nearest, NaN maps to the lower bound
+    void (*float_to_norm)(NormFormat format, float const* src, void* dst, std::size_t count);
+    void (*norm_to_float)(NormFormat format, void const* src, float* dst, std::size_t count);
+    // Unit vectors stride floats apart to two snorm16 octahedral coordinates each, and back
+    void (*encode_octahedral)(float const* vectors, std::size_t stride, std::int16_t* dst, std::size_t count);
+    void (*decode_octahedral)(std::int16_t const* src, float* vectors, std::size_t stride, std::size_t count);
+
+    // 4x4 matrices to 3x4 rows, dropping the last row or, with transpose, the last column
+    void (*pack_affine)(float const* matrices, float* result, std::size_t count, bool transpose);
+    // Translation, rotation quaternion (xyzw) and scale, each stride floats apart, to 3x4 rows
+    void (*pack_trs)(float const* translation, float const* rotation, float const* scale, std::size_t stride,
+                     float* result, std::size_t count);
+
+    // Value i comes from stream i % kRandomStreams, state is stored as [4][kRandomStreams]. Streams
+    // always advance in whole rounds, values past count are dropped. Floats are uniform in [min, max]
+    // with 24 random bits
+    void (*random_uint32)(std::uint32_t* state, std::uint32_t* result, std::size_t count);
+    void (*random_float)(std::uint32_t* state, float* result, std::size_t count, float min, float max);
+    // Noise roughly in [-1, 1] over SoA coordinates, which must fit in int32 after floor
+    void (*noise)(NoiseType type, float const* x, float const* y, float const* z, std::uint32_t seed,
+                  float* result, std::size_t count);
+
+    // Depth-only rasterization for software occlusion. triangles holds count x 3 screen space
+    // vertices (x, y, z) with pixel centers at integer + 0.5 and y pointing down. depth is a
+    // row-major width x height buffer that keeps the nearest z, width must be a multiple of 8.
+    // Both windings are drawn, a pixel is covered when its center is inside or on an edge
+    void (*rasterize_depth)(float const* triangles, std::size_t count, float* depth, std::uint32_t width, std::uint32_t height);
+};
+
+// Kernels for the best level supported by this CPU
+MathKernels const& GetMathKernels();
+// Kernels for a particular level, for tests and benchmarks.
+// Levels the CPU doesn't support fall back to the best supported one
+MathKernels const& GetMathKernels(SimdLevel level);
+
+void FillMathKernelsScalar(MathKernels & kernels);
+#if CHAY_SIMD_X86
+void FillMathKernelsSse41(MathKernels & kernels);
+void FillMathKernelsAvx2(MathKernels & kernels);
+void FillMathKernelsAvx512(MathKernels & kernels);
+#endif
+
+#endif // MATH_KERNELS_HPP_
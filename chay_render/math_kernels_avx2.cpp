@@ -0,0 +1,1492 @@
+#include "math_kernels.hpp"
+
+#if CHAY_SIMD_X86
+#include <immintrin.h>
+
+namespace
+{
+    // Rows of b duplicated into both 128-bit lanes
+    void LoadMatrixRows(float const* b, __m256 & b0, __m256 & b1, __m256 & b2, __m256 & b3)
+    {
+        b0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(b + 0));
+        b1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(b + 4));
+        b2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(b + 8));
+        b3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(b + 12));
+    }
+
+    // Two rows of a per register, in-lane shuffles broadcast a[i][k] and a[i + 1][k]
+    __m256 MultiplyRowPair(__m256 a, __m256 b0, __m256 b1, __m256 b2, __m256 b3)
+    {
+        __m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0x00), b0);
+        r = _mm256_fmadd_ps(_mm256_shuffle_ps(a, a, 0x55), b1, r);
+        r = _mm256_fmadd_ps(_mm256_shuffle_ps(a, a, 0xaa), b2, r);
+        return _mm256_fmadd_ps(_mm256_shuffle_ps(a, a, 0xff), b3, r);
+    }
+
+    void MultiplyMatrix(float const* a, float const* b, float* result)
+    {
+        __m256 b0, b1, b2, b3;
+        LoadMatrixRows(b, b0, b1, b2, b3);
+        _mm256_storeu_ps(result + 0, MultiplyRowPair(_mm256_loadu_ps(a + 0), b0, b1, b2, b3));
+        _mm256_storeu_ps(result + 8, MultiplyRowPair(_mm256_loadu_ps(a + 8), b0, b1, b2, b3));
+    }
+
+    // Eight packed float3 to x, y, z registers, StoreFloat3x8 applies the inverse permutation
+    void LoadFloat3x8(float const* p, __m256 & x, __m256 & y, __m256 & z)
+    {
+        __m256 m03 = _mm256_castps128_ps256(_mm_loadu_ps(p + 0));
+        __m256 m14 = _mm256_castps128_ps256(_mm_loadu_ps(p + 4));
+        __m256 m25 = _mm256_castps128_ps256(_mm_loadu_ps(p + 8));
+        m03 = _mm256_insertf128_ps(m03, _mm_loadu_ps(p + 12), 1);
+        m14 = _mm256_insertf128_ps(m14, _mm_loadu_ps(p + 16), 1);
+        m25 = _mm256_insertf128_ps(m25, _mm_loadu_ps(p + 20), 1);
+
+        __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+        __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+        x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+        y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+        z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+    }
+
+    void StoreFloat3x8(float* p, __m256 x, __m256 y, __m256 z)
+    {
+        __m256 rxy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 ryz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 rzx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+        __m256 r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+        __m256 r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+
+        _mm_storeu_ps(p + 0, _mm256_castps256_ps128(r03));
+        _mm_storeu_ps(p + 4, _mm256_castps256_ps128(r14));
+        _mm_storeu_ps(p + 8, _mm256_castps256_ps128(r25));
+        _mm_storeu_ps(p + 12, _mm256_extractf128_ps(r03, 1));
+        _mm_storeu_ps(p + 16, _mm256_extractf128_ps(r14, 1));
+        _mm_storeu_ps(p + 20, _mm256_extractf128_ps(r25, 1));
+    }
+
+    template <bool kTranslate>
+    void Transform8(__m256 const mm[12], __m256 x, __m256 y, __m256 z, __m256 & rx, __m256 & ry, __m256 & rz)
+    {
+        rx = _mm256_fmadd_ps(mm[0], x, _mm256_fmadd_ps(mm[1], y, _mm256_mul_ps(mm[2], z)));
+        ry = _mm256_fmadd_ps(mm[4], x, _mm256_fmadd_ps(mm[5], y, _mm256_mul_ps(mm[6], z)));
+        rz = _mm256_fmadd_ps(mm[8], x, _mm256_fmadd_ps(mm[9], y, _mm256_mul_ps(mm[10], z)));
+        if (kTranslate)
+        {
+            rx = _mm256_add_ps(rx, mm[3]);
+            ry = _mm256_add_ps(ry, mm[7]);
+            rz = _mm256_add_ps(rz, mm[11]);
+        }
+    }
+
+    template <bool kTranslate>
+    void TransformFloat3(float const* m, float const* points, float* result, std::size_t count)
+    {
+        __m256 mm[12];
+        for (int i = 0; i < 12; ++i)
+        {
+            mm[i] = _mm256_set1_ps(m[i]);
+        }
+
+        std::size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 x, y, z, rx, ry, rz;
+            LoadFloat3x8(points + i * 3, x, y, z);
+            Transform8<kTranslate>(mm, x, y, z, rx, ry, rz);
+            StoreFloat3x8(result + i * 3, rx, ry, rz);
+        }
+
+        for (; i < count; ++i)
+        {
+            float px = points[i * 3 + 0];
+            float py = points[i * 3 + 1];
+            float pz = points[i * 3 + 2];
+            float w = kTranslate ? 1.0f : 0.0f;
+            result[i * 3 + 0] = m[0] * px + m[1] * py + m[2] * pz + m[3] * w;
+            result[i * 3 + 1] = m[4] * px + m[5] * py + m[6] * pz + m[7] * w;
+            result[i * 3 + 2] = m[8] * px + m[9] * py + m[10] * pz + m[11] * w;
+        }
+    }
+
+    void TransformPoints(float const* m, float const* points, float* result, std::size_t count)
+    {
+        TransformFloat3<true>(m, points, result, count);
+    }
+
+    void TransformVectors(float const* m, float const* vectors, float* result, std::size_t count)
+    {
+        TransformFloat3<false>(m, vectors, result, count);
+    }
+
+    void TransformPointsSoa(float const* m, float const* x, float const* y, float const* z,
+                            float* result_x, float* result_y, float* result_z, std::size_t count)
+    {
+        __m256 mm[12];
+        for (int i = 0; i < 12; ++i)
+        {
+            mm[i] = _mm256_set1_ps(m[i]);
+        }
+
+        std::size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 rx, ry, rz;
+            Transform8<true>(mm, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), _mm256_loadu_ps(z + i), rx, ry, rz);
+            _mm256_storeu_ps(result_x + i, rx);
+            _mm256_storeu_ps(result_y + i, ry);
+            _mm256_storeu_ps(result_z + i, rz);
+        }
+
+        for (; i < count; ++i)
+        {
+            float px = x[i];
+            float py = y[i];
+            float pz = z[i];
+            result_x[i] = m[0] * px + m[1] * py + m[2] * pz + m[3];
+            result_y[i] = m[4] * px + m[5] * py + m[6] * pz + m[7];
+            result_z[i] = m[8] * px + m[9] * py + m[10] * pz + m[11];
+        }
+    }
+
+    void MultiplyMatrices(float const* a, float const* b, float* result, std::size_t count)
+    {
+        // Two products per iteration give four independent FMA chains instead of two
+        std::size_t i = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            float const* a0 = a + i * 16;
+            float const* a1 = a0 + 16;
+            __m256 b00, b01, b02, b03, b10, b11, b12, b13;
+            LoadMatrixRows(b + i * 16, b00, b01, b02, b03);
+            LoadMatrixRows(b + i * 16 + 16, b10, b11, b12, b13);
+
+            __m256 r001 = MultiplyRowPair(_mm256_loadu_ps(a0 + 0), b00, b01, b02, b03);
+            __m256 r023 = MultiplyRowPair(_mm256_loadu_ps(a0 + 8), b00, b01, b02, b03);
+            __m256 r101 = MultiplyRowPair(_mm256_loadu_ps(a1 + 0), b10, b11, b12, b13);
+            __m256 r123 = MultiplyRowPair(_mm256_loadu_ps(a1 + 8), b10, b11, b12, b13);
+
+            _mm256_storeu_ps(result + i * 16 + 0, r001);
+            _mm256_storeu_ps(result + i * 16 + 8, r023);
+            _mm256_storeu_ps(result + i * 16 + 16, r101);
+            _mm256_storeu_ps(result + i * 16 + 24, r123);
+        }
+
+        if (i < count)
+        {
+            MultiplyMatrix(a + i * 16, b + i * 16, result + i * 16);
+        }
+    }
+
+    // Local instead of std::abs, see the note on kernel includes in math_kernels.hpp
+    float Abs(float value)
+    {
+        return value < 0.0f ? -value : value;
+    }
+
+    std::uint8_t CullSphere(float const* planes, float x, float y, float z, float radius)
+    {
+        std::uint8_t result = kCullInside;
+        for (int i = 0; i < 6; ++i)
+        {
+            float const* plane = planes + i * 4;
+            float distance = plane[0] * x + plane[1] * y + plane[2] * z + plane[3];
+            if (distance < -radius)
+            {
+                return kCullOutside;
+            }
+
+            if (distance < radius)
+            {
+                result = kCullIntersect;
+            }
+        }
+
+        return result;
+    }
+
+    std::uint8_t CullAabb(float const* planes, float x, float y, float z, float ex, float ey, float ez)
+    {
+        // Projected radius of the box onto the plane normal
+        std::uint8_t result = kCullInside;
+        for (int i = 0; i < 6; ++i)
+        {
+            float const* plane = planes + i * 4;
+            float distance = plane[0] * x + plane[1] * y + plane[2] * z + plane[3];
+            float radius = Abs(plane[0]) * ex + Abs(plane[1]) * ey + Abs(plane[2]) * ez;
+            if (distance < -radius)
+            {
+                return kCullOutside;
+            }
+
+            if (distance < radius)
+            {
+                result = kCullIntersect;
+            }
+        }
+
+        return result;
+    }
+
+    template <typename RadiusFunc>
+    void ClassifyPlanes8(float const* planes, __m256 x, __m256 y, __m256 z, RadiusFunc radius, int & outside, int & intersect)
+    {
+        __m256 outside_mask = _mm256_setzero_ps();
+        __m256 intersect_mask = _mm256_setzero_ps();
+        for (int i = 0; i < 6; ++i)
+        {
+            float const* plane = planes + i * 4;
+            __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(plane[0]), x,
+                              _mm256_fmadd_ps(_mm256_set1_ps(plane[1]), y,
+                              _mm256_fmadd_ps(_mm256_set1_ps(plane[2]), z, _mm256_set1_ps(plane[3]))));
+            __m256 r = radius(plane);
+            outside_mask = _mm256_or_ps(outside_mask, _mm256_cmp_ps(_mm256_add_ps(distance, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+            intersect_mask = _mm256_or_ps(intersect_mask, _mm256_cmp_ps(distance, r, _CMP_LT_OQ));
+        }
+
+        outside = _mm256_movemask_ps(outside_mask);
+        intersect = _mm256_movemask_ps(intersect_mask);
+    }
+
+    void StoreCullResults(std::uint8_t* result, int outside, int intersect, int lane_count)
+    {
+        for (int lane = 0; lane < lane_count; ++lane)
+        {
+            result[lane] = static_cast<std::uint8_t>(kCullInside - ((intersect >> lane) & 1) - ((outside >> lane) & 1));
+        }
+    }
+
+    void CullSpheres(float const* planes, float const* x, float const* y, float const* z,
+                     float const* radius, std::uint8_t* result, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 r = _mm256_loadu_ps(radius + i);
+            int outside, intersect;
+            ClassifyPlanes8(planes, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), _mm256_loadu_ps(z + i),
+                            [r](float const*) { return r; }, outside, intersect);
+            StoreCullResults(result + i, outside, intersect, 8);
+        }
+
+        for (; i < count; ++i)
+        {
+            result[i] = CullSphere(planes, x[i], y[i], z[i], radius[i]);
+        }
+    }
+
+    void CullAabbs(float const* planes, float const* center_x, float const* center_y, float const* center_z,
+                   float const* extent_x, float const* extent_y, float const* extent_z,
+                   std::uint8_t* result, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 ex = _mm256_loadu_ps(extent_x + i);
+            __m256 ey = _mm256_loadu_ps(extent_y + i);
+            __m256 ez = _mm256_loadu_ps(extent_z + i);
+            auto radius = [ex, ey, ez](float const* plane)
+            {
+                return _mm256_fmadd_ps(_mm256_set1_ps(Abs(plane[0])), ex,
+                       _mm256_fmadd_ps(_mm256_set1_ps(Abs(plane[1])), ey, _mm256_mul_ps(_mm256_set1_ps(Abs(plane[2])), ez)));
+            };
+
+            int outside, intersect;
+            ClassifyPlanes8(planes, _mm256_loadu_ps(center_x + i), _mm256_loadu_ps(center_y + i), _mm256_loadu_ps(center_z + i),
+                            radius, outside, intersect);
+            StoreCullResults(result + i, outside, intersect, 8);
+        }
+
+        for (; i < count; ++i)
+        {
+            result[i] = CullAabb(planes, center_x[i], center_y[i], center_z[i], extent_x[i], extent_y[i], extent_z[i]);
+        }
+    }
+
+    // Tail bounds of the multi-view kernels
+    std::uint32_t SphereVisibility(float const* planes, std::size_t view_count, float x, float y, float z, float radius)
+    {
+        std::uint32_t mask = 0;
+        for (std::size_t view = 0; view < view_count; ++view)
+        {
+            mask |= CullSphere(planes + view * 24, x, y, z, radius) != kCullOutside ? 1u << view : 0u;
+        }
+        return mask;
+    }
+
+    std::uint32_t AabbVisibility(float const* planes, std::size_t view_count, float x, float y, float z, float ex, float ey, float ez)
+    {
+        std::uint32_t mask = 0;
+        for (std::size_t view = 0; view < view_count; ++view)
+        {
+            mask |= CullAabb(planes + view * 24, x, y, z, ex, ey, ez) != kCullOutside ? 1u << view : 0u;
+        }
+        return mask;
+    }
+
+    // Visibility bits of eight bounds against every view, the bounds stay in registers
+    // while the planes of all views stream past them
+    template <typename RadiusFunc>
+    __m256i Visibility8(float const* planes, std::size_t view_count, __m256 x, __m256 y, __m256 z, RadiusFunc radius)
+    {
+        __m256i visibility = _mm256_setzero_si256();
+        for (std::size_t view = 0; view < view_count; ++view)
+        {
+            __m256 outside_mask = _mm256_setzero_ps();
+            for (int i = 0; i < 6; ++i)
+            {
+                float const* plane = planes + view * 24 + i * 4;
+                __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(plane[0]), x,
+                                  _mm256_fmadd_ps(_mm256_set1_ps(plane[1]), y,
+                                  _mm256_fmadd_ps(_mm256_set1_ps(plane[2]), z, _mm256_set1_ps(plane[3]))));
+                outside_mask = _mm256_or_ps(outside_mask, _mm256_cmp_ps(_mm256_add_ps(distance, radius(plane)), _mm256_setzero_ps(), _CMP_LT_OQ));
+            }
+
+            visibility = _mm256_or_si256(visibility, _mm256_andnot_si256(_mm256_castps_si256(outside_mask),
+                                                                         _mm256_set1_epi32(static_cast<int>(1u << view))));
+        }
+
+        return visibility;
+    }
+
+    void CullSpheresMulti(float const* planes, std::size_t view_count, float const* x, float const* y, float const* z,
+                          float const* radius, std::uint32_t* visibility, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 r = _mm256_loadu_ps(radius + i);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(visibility + i),
+                                Visibility8(planes, view_count, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), _mm256_loadu_ps(z + i),
+                                            [r](float const*) { return r; }));
+        }
+
+        for (; i < count; ++i)
+        {
+            visibility[i] = SphereVisibility(planes, view_count, x[i], y[i], z[i], radius[i]);
+        }
+    }
+
+    void CullAabbsMulti(float const* planes, std::size_t view_count,
+                        float const* center_x, float const* center_y, float const* center_z,
+                        float const* extent_x, float const* extent_y, float const* extent_z,
+                        std::uint32_t* visibility, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 ex = _mm256_loadu_ps(extent_x + i);
+            __m256 ey = _mm256_loadu_ps(extent_y + i);
+            __m256 ez = _mm256_loadu_ps(extent_z + i);
+            auto radius = [ex, ey, ez](float const* plane)
+            {
+                return _mm256_fmadd_ps(_mm256_set1_ps(Abs(plane[0])), ex,
+                       _mm256_fmadd_ps(_mm256_set1_ps(Abs(plane[1])), ey, _mm256_mul_ps(_mm256_set1_ps(Abs(plane[2])), ez)));
+            };
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(visibility + i),
+                                Visibility8(planes, view_count, _mm256_loadu_ps(center_x + i), _mm256_loadu_ps(center_y + i),
+                                            _mm256_loadu_ps(center_z + i), radius));
+        }
+
+        for (; i < count; ++i)
+        {
+            visibility[i] = AabbVisibility(planes, view_count, center_x[i], center_y[i], center_z[i],
+                                           extent_x[i], extent_y[i], extent_z[i]);
+        }
+    }
+
+    __m128 LoadFloat3(float const* p)
+    {
+        return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<__m64 const*>(p)), _mm_load_ss(p + 2));
+    }
+
+    float HorizontalMin(__m256 v)
+    {
+        __m128 r = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        r = _mm_min_ps(r, _mm_movehl_ps(r, r));
+        return _mm_cvtss_f32(_mm_min_ss(r, _mm_shuffle_ps(r, r, 0x55)));
+    }
+
+    float HorizontalMax(__m256 v)
+    {
+        __m128 r = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        r = _mm_max_ps(r, _mm_movehl_ps(r, r));
+        return _mm_cvtss_f32(_mm_max_ss(r, _mm_shuffle_ps(r, r, 0x55)));
+    }
+
+    // Tightly packed float3 run eight points per iteration, other strides one point per iteration
+    void ComputeBounds(float const* points, std::size_t stride, std::size_t count, float* min, float* max)
+    {
+        std::size_t i = 0;
+        __m128 lower = _mm_set1_ps(3.402823466e+38f);
+        __m128 upper = _mm_set1_ps(-3.402823466e+38f);
+        if (stride == 3)
+        {
+            __m256 lower_x = _mm256_set1_ps(3.402823466e+38f), lower_y = lower_x, lower_z = lower_x;
+            __m256 upper_x = _mm256_set1_ps(-3.402823466e+38f), upper_y = upper_x, upper_z = upper_x;
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256 x, y, z;
+                LoadFloat3x8(points + i * 3, x, y, z);
+                lower_x = _mm256_min_ps(lower_x, x);
+                lower_y = _mm256_min_ps(lower_y, y);
+                lower_z = _mm256_min_ps(lower_z, z);
+                upper_x = _mm256_max_ps(upper_x, x);
+                upper_y = _mm256_max_ps(upper_y, y);
+                upper_z = _mm256_max_ps(upper_z, z);
+            }
+
+            lower = _mm_setr_ps(HorizontalMin(lower_x), HorizontalMin(lower_y), HorizontalMin(lower_z), 0.0f);
+            upper = _mm_setr_ps(HorizontalMax(upper_x), HorizontalMax(upper_y), HorizontalMax(upper_z), 0.0f);
+        }
+
+        for (; i < count; ++i)
+        {
+            __m128 p = LoadFloat3(points + i * stride);
+            lower = _mm_min_ps(lower, p);
+            upper = _mm_max_ps(upper, p);
+        }
+
+        _mm_storel_pi(reinterpret_cast<__m64*>(min), lower);
+        _mm_store_ss(min + 2, _mm_movehl_ps(lower, lower));
+        _mm_storel_pi(reinterpret_cast<__m64*>(max), upper);
+        _mm_store_ss(max + 2, _mm_movehl_ps(upper, upper));
+    }
+
+    float MaxDistanceSq(float const* points, std::size_t stride, std::size_t count, float const* center)
+    {
+        std::size_t i = 0;
+        float result = 0.0f;
+        if (stride == 3)
+        {
+            __m256 cx = _mm256_set1_ps(center[0]);
+            __m256 cy = _mm256_set1_ps(center[1]);
+            __m256 cz = _mm256_set1_ps(center[2]);
+            __m256 result8 = _mm256_setzero_ps();
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256 x, y, z;
+                LoadFloat3x8(points + i * 3, x, y, z);
+                __m256 dx = _mm256_sub_ps(x, cx);
+                __m256 dy = _mm256_sub_ps(y, cy);
+                __m256 dz = _mm256_sub_ps(z, cz);
+                __m256 distance_sq = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+                result8 = _mm256_max_ps(result8, distance_sq);
+            }
+
+            result = HorizontalMax(result8);
+        }
+
+        __m128 c = LoadFloat3(center);
+        __m128 result4 = _mm_set_ss(result);
+        for (; i < count; ++i)
+        {
+            __m128 d = _mm_sub_ps(LoadFloat3(points + i * stride), c);
+            result4 = _mm_max_ss(result4, _mm_dp_ps(d, d, 0x71));
+        }
+
+        return _mm_cvtss_f32(result4);
+    }
+
+    constexpr float kParallelEpsilon = 1e-12f;
+
+    __m256 CmpLe(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    __m256 CmpGe(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    __m256 CmpGt(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+
+    // 8 lanes starting at i, count - i may be less than 8 at the tail
+    __m256 LoadLanes(float const* data, std::size_t i, std::size_t lanes)
+    {
+        if (lanes == 8)
+        {
+            return _mm256_loadu_ps(data + i);
+        }
+
+        float padded[8] = {};
+        for (std::size_t k = 0; k < lanes; ++k)
+        {
+            padded[k] = data[i + k];
+        }
+
+        return _mm256_loadu_ps(padded);
+    }
+
+    void StoreLanes(float* data, std::size_t i, std::size_t lanes, __m256 value)
+    {
+        if (lanes == 8)
+        {
+            _mm256_storeu_ps(data + i, value);
+            return;
+        }
+
+        float padded[8];
+        _mm256_storeu_ps(padded, value);
+        for (std::size_t k = 0; k < lanes; ++k)
+        {
+            data[i + k] = padded[k];
+        }
+    }
+
+    __m256 SlabTest(__m256 const o[3], __m256 const inv[3], __m256 t_max, __m256 const lo[3], __m256 const hi[3])
+    {
+        __m256 t_near = _mm256_setzero_ps();
+        __m256 t_far = t_max;
+        for (int c = 0; c < 3; ++c)
+        {
+            __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(lo[c], o[c]), inv[c]);
+            __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(hi[c], o[c]), inv[c]);
+            t_near = _mm256_max_ps(t_near, _mm256_min_ps(t0, t1));
+            t_far = _mm256_min_ps(t_far, _mm256_max_ps(t0, t1));
+        }
+
+        return _mm256_blendv_ps(_mm256_set1_ps(kRayMiss), t_near, CmpLe(t_near, t_far));
+    }
+
+    void Cross(__m256 const a[3], __m256 const b[3], __m256 r[3])
+    {
+        r[0] = _mm256_sub_ps(_mm256_mul_ps(a[1], b[2]), _mm256_mul_ps(a[2], b[1]));
+        r[1] = _mm256_sub_ps(_mm256_mul_ps(a[2], b[0]), _mm256_mul_ps(a[0], b[2]));
+        r[2] = _mm256_sub_ps(_mm256_mul_ps(a[0], b[1]), _mm256_mul_ps(a[1], b[0]));
+    }
+
+    __m256 Dot(__m256 const a[3], __m256 const b[3])
+    {
+        return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a[0], b[0]), _mm256_mul_ps(a[1], b[1])), _mm256_mul_ps(a[2], b[2]));
+    }
+
+    __m256 MollerTrumbore(__m256 const o[3], __m256 const d[3], __m256 t_max, __m256 const v0[3], __m256 const v1[3], __m256 const v2[3], __m256 & u, __m256 & v)
+    {
+        __m256 e1[3], e2[3], s[3], p[3], q[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            e1[c] = _mm256_sub_ps(v1[c], v0[c]);
+            e2[c] = _mm256_sub_ps(v2[c], v0[c]);
+            s[c] = _mm256_sub_ps(o[c], v0[c]);
+        }
+
+        Cross(d, e2, p);
+        __m256 det = Dot(e1, p);
+        __m256 inv_det = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+        u = _mm256_mul_ps(Dot(s, p), inv_det);
+        Cross(s, e1, q);
+        v = _mm256_mul_ps(Dot(d, q), inv_det);
+        __m256 t = _mm256_mul_ps(Dot(e2, q), inv_det);
+
+        __m256 zero = _mm256_setzero_ps();
+        __m256 abs_det = _mm256_and_ps(det, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+        __m256 hit = _mm256_and_ps(CmpGt(abs_det, _mm256_set1_ps(kParallelEpsilon)), _mm256_and_ps(CmpGe(u, zero), CmpGe(v, zero)));
+        hit = _mm256_and_ps(hit, _mm256_and_ps(CmpLe(_mm256_add_ps(u, v), _mm256_set1_ps(1.0f)), _mm256_and_ps(CmpGe(t, zero), CmpLe(t, t_max))));
+        return _mm256_blendv_ps(_mm256_set1_ps(kRayMiss), t, hit);
+    }
+
+    void IntersectRayAabbs(float const* ray, AabbArrays const& boxes, std::size_t count, float* t)
+    {
+        __m256 o[3], inv[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            o[c] = _mm256_set1_ps(ray[c]);
+            inv[c] = _mm256_set1_ps(1.0f / ray[3 + c]);
+        }
+        __m256 t_max = _mm256_set1_ps(ray[6]);
+
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            __m256 lo[3], hi[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                lo[c] = LoadLanes(boxes.min_point[c], i, lanes);
+                hi[c] = LoadLanes(boxes.max_point[c], i, lanes);
+            }
+            StoreLanes(t, i, lanes, SlabTest(o, inv, t_max, lo, hi));
+        }
+    }
+
+    void IntersectRaysAabb(RayArrays const& rays, std::size_t count, float const* box, float* t)
+    {
+        __m256 lo[3], hi[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            lo[c] = _mm256_set1_ps(box[c]);
+            hi[c] = _mm256_set1_ps(box[3 + c]);
+        }
+
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            __m256 o[3], inv[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                o[c] = LoadLanes(rays.origin[c], i, lanes);
+                inv[c] = LoadLanes(rays.inv_direction[c], i, lanes);
+            }
+            StoreLanes(t, i, lanes, SlabTest(o, inv, LoadLanes(rays.t_max, i, lanes), lo, hi));
+        }
+    }
+
+    void IntersectRayTriangles(float const* ray, TriangleArrays const& triangles, std::size_t count,
+                               float* t, float* u, float* v)
+    {
+        __m256 o[3], d[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            o[c] = _mm256_set1_ps(ray[c]);
+            d[c] = _mm256_set1_ps(ray[3 + c]);
+        }
+        __m256 t_max = _mm256_set1_ps(ray[6]);
+
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            __m256 v0[3], v1[3], v2[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                v0[c] = LoadLanes(triangles.v0[c], i, lanes);
+                v1[c] = LoadLanes(triangles.v1[c], i, lanes);
+                v2[c] = LoadLanes(triangles.v2[c], i, lanes);
+            }
+
+            __m256 hit_u, hit_v;
+            StoreLanes(t, i, lanes, MollerTrumbore(o, d, t_max, v0, v1, v2, hit_u, hit_v));
+            StoreLanes(u, i, lanes, hit_u);
+            StoreLanes(v, i, lanes, hit_v);
+        }
+    }
+
+    void IntersectRaysTriangle(RayArrays const& rays, std::size_t count, float const* triangle,
+                               float* t, float* u, float* v)
+    {
+        __m256 v0[3], v1[3], v2[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            v0[c] = _mm256_set1_ps(triangle[c]);
+            v1[c] = _mm256_set1_ps(triangle[3 + c]);
+            v2[c] = _mm256_set1_ps(triangle[6 + c]);
+        }
+
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            __m256 o[3], d[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                o[c] = LoadLanes(rays.origin[c], i, lanes);
+                d[c] = LoadLanes(rays.direction[c], i, lanes);
+            }
+
+            __m256 hit_u, hit_v;
+            StoreLanes(t, i, lanes, MollerTrumbore(o, d, LoadLanes(rays.t_max, i, lanes), v0, v1, v2, hit_u, hit_v));
+            StoreLanes(u, i, lanes, hit_u);
+            StoreLanes(v, i, lanes, hit_v);
+        }
+    }
+
+    constexpr float kPi = 3.141592654f;
+    constexpr float kHalfPi = 1.570796327f;
+
+    __m256 CmpLt(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+
+    __m256 Round(__m256 x)
+    {
+        return _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    }
+
+    void SinCos(__m256 x, __m256 & sin, __m256 & cos)
+    {
+        __m256 j = Round(_mm256_mul_ps(x, _mm256_set1_ps(kFastTwoOverPi)));
+        __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(j, _mm256_set1_ps(kFastPiOverTwo[0])));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(kFastPiOverTwo[1])));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(kFastPiOverTwo[2])));
+        __m256i quadrant = _mm256_cvtps_epi32(j);
+
+        __m256 r2 = _mm256_mul_ps(r, r);
+        __m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kFastSin[0]), r2), _mm256_set1_ps(kFastSin[1])), r2), _mm256_set1_ps(kFastSin[2]));
+        s = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(r, r2), s));
+        __m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kFastCos[0]), r2), _mm256_set1_ps(kFastCos[1])), r2), _mm256_set1_ps(kFastCos[2]));
+        c = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(_mm256_set1_ps(0.5f), r2)), _mm256_mul_ps(_mm256_mul_ps(r2, r2), c));
+
+        // Odd quadrants swap sin and cos, bit 1 of the quadrant flips the signs
+        __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+        sin = _mm256_blendv_ps(s, c, swap);
+        cos = _mm256_blendv_ps(c, s, swap);
+        sin = _mm256_xor_ps(sin, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30)));
+        cos = _mm256_xor_ps(cos, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30)));
+    }
+
+    __m256 Rsqrt(__m256 x)
+    {
+        __m256 y = _mm256_rsqrt_ps(x);
+        return _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), x), _mm256_mul_ps(y, y))));
+    }
+
+    __m256 Atan2(__m256 y, __m256 x)
+    {
+        __m256 sign_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+        __m256 ax = _mm256_andnot_ps(sign_mask, x);
+        __m256 ay = _mm256_andnot_ps(sign_mask, y);
+        __m256 a = _mm256_div_ps(_mm256_min_ps(ax, ay), _mm256_max_ps(_mm256_max_ps(ax, ay), _mm256_set1_ps(1e-30f)));
+        __m256 s = _mm256_mul_ps(a, a);
+
+        __m256 p = _mm256_set1_ps(kFastAtan[0]);
+        for (int i = 1; i < 8; ++i)
+        {
+            p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(kFastAtan[i]));
+        }
+
+        __m256 r = _mm256_add_ps(a, _mm256_mul_ps(_mm256_mul_ps(a, s), p));
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(kHalfPi), r), CmpGt(ay, ax));
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(kPi), r), CmpLt(x, _mm256_setzero_ps()));
+        return _mm256_or_ps(r, _mm256_and_ps(y, sign_mask));
+    }
+
+    __m256 Exp(__m256 x)
+    {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(kFastExpMin)), _mm256_set1_ps(kFastExpMax));
+        __m256 n = Round(_mm256_mul_ps(x, _mm256_set1_ps(kFastLog2E)));
+        __m256 r = _mm256_sub_ps(_mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(kFastLn2[0]))), _mm256_mul_ps(n, _mm256_set1_ps(kFastLn2[1])));
+
+        __m256 p = _mm256_set1_ps(kFastExp[0]);
+        for (int i = 1; i < 6; ++i)
+        {
+            p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kFastExp[i]));
+        }
+
+        __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, r), r), r), _mm256_set1_ps(1.0f));
+        __m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23));
+        return _mm256_mul_ps(y, scale);
+    }
+
+    __m256 Log(__m256 x)
+    {
+        __m256i bits = _mm256_castps_si256(x);
+        __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+        __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f000000)));
+
+        __m256 small = CmpLt(m, _mm256_set1_ps(kFastSqrtHalf));
+        e = _mm256_sub_ps(e, _mm256_and_ps(small, _mm256_set1_ps(1.0f)));
+        m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), _mm256_set1_ps(1.0f));
+
+        __m256 z = _mm256_mul_ps(m, m);
+        __m256 p = _mm256_set1_ps(kFastLog[0]);
+        for (int i = 1; i < 9; ++i)
+        {
+            p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(kFastLog[i]));
+        }
+
+        __m256 y = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, m), z), _mm256_mul_ps(e, _mm256_set1_ps(kFastLn2[1])));
+        y = _mm256_sub_ps(y, _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+        return _mm256_add_ps(_mm256_add_ps(m, y), _mm256_mul_ps(e, _mm256_set1_ps(kFastLn2[0])));
+    }
+
+    void FastSinCosArray(float const* x, float* sin, float* cos, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            __m256 s, c;
+            SinCos(LoadLanes(x, i, lanes), s, c);
+            StoreLanes(sin, i, lanes, s);
+            StoreLanes(cos, i, lanes, c);
+        }
+    }
+
+    void FastRsqrtArray(float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            StoreLanes(result, i, lanes, Rsqrt(LoadLanes(x, i, lanes)));
+        }
+    }
+
+    void FastAtan2Array(float const* y, float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            StoreLanes(result, i, lanes, Atan2(LoadLanes(y, i, lanes), LoadLanes(x, i, lanes)));
+        }
+    }
+
+    void FastExpArray(float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            StoreLanes(result, i, lanes, Exp(LoadLanes(x, i, lanes)));
+        }
+    }
+
+    void FastLogArray(float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            // Padding lanes are 0, which is outside the log domain but never stored
+            StoreLanes(result, i, lanes, Log(LoadLanes(x, i, lanes)));
+        }
+    }
+
+    void NormalizeVectors(float const* vectors, float* result, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 x, y, z;
+            LoadFloat3x8(vectors + i * 3, x, y, z);
+            __m256 inv_length = Rsqrt(_mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_mul_ps(z, z))));
+            StoreFloat3x8(result + i * 3, _mm256_mul_ps(x, inv_length), _mm256_mul_ps(y, inv_length), _mm256_mul_ps(z, inv_length));
+        }
+
+        for (; i < count; ++i)
+        {
+            __m128 v = LoadFloat3(vectors + i * 3);
+            __m128 length_sq = _mm_dp_ps(v, v, 0x7f);
+            __m128 inv_length = _mm_rsqrt_ps(length_sq);
+            inv_length = _mm_mul_ps(inv_length, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), length_sq), _mm_mul_ps(inv_length, inv_length))));
+            v = _mm_mul_ps(v, inv_length);
+            _mm_storel_pi(reinterpret_cast<__m64*>(result + i * 3), v);
+            _mm_store_ss(result + i * 3 + 2, _mm_movehl_ps(v, v));
+        }
+    }
+
+    void RotationMatrices(float const* axes, float const* angles, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            float axis[3][8] = {};
+            for (std::size_t k = 0; k < lanes; ++k)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    axis[c][k] = axes[(i + k) * 3 + c];
+                }
+            }
+
+            __m256 x = _mm256_loadu_ps(axis[0]);
+            __m256 y = _mm256_loadu_ps(axis[1]);
+            __m256 z = _mm256_loadu_ps(axis[2]);
+            __m256 inv_length = Rsqrt(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+            x = _mm256_mul_ps(x, inv_length);
+            y = _mm256_mul_ps(y, inv_length);
+            z = _mm256_mul_ps(z, inv_length);
+
+            __m256 s, c;
+            SinCos(LoadLanes(angles, i, lanes), s, c);
+            __m256 t = _mm256_sub_ps(_mm256_set1_ps(1.0f), c);
+            __m256 xt = _mm256_mul_ps(x, t);
+            __m256 yt = _mm256_mul_ps(y, t);
+            __m256 zt = _mm256_mul_ps(z, t);
+
+            // Upper 3x3 in SoA, written out as full matrices per lane
+            float m[9][8];
+            _mm256_storeu_ps(m[0], _mm256_add_ps(_mm256_mul_ps(xt, x), c));
+            _mm256_storeu_ps(m[1], _mm256_sub_ps(_mm256_mul_ps(xt, y), _mm256_mul_ps(z, s)));
+            _mm256_storeu_ps(m[2], _mm256_add_ps(_mm256_mul_ps(xt, z), _mm256_mul_ps(y, s)));
+            _mm256_storeu_ps(m[3], _mm256_add_ps(_mm256_mul_ps(xt, y), _mm256_mul_ps(z, s)));
+            _mm256_storeu_ps(m[4], _mm256_add_ps(_mm256_mul_ps(yt, y), c));
+            _mm256_storeu_ps(m[5], _mm256_sub_ps(_mm256_mul_ps(yt, z), _mm256_mul_ps(x, s)));
+            _mm256_storeu_ps(m[6], _mm256_sub_ps(_mm256_mul_ps(xt, z), _mm256_mul_ps(y, s)));
+            _mm256_storeu_ps(m[7], _mm256_add_ps(_mm256_mul_ps(yt, z), _mm256_mul_ps(x, s)));
+            _mm256_storeu_ps(m[8], _mm256_add_ps(_mm256_mul_ps(zt, z), c));
+
+            for (std::size_t k = 0; k < lanes; ++k)
+            {
+                float* out = result + (i + k) * 16;
+                out[0] = m[0][k]; out[1] = m[1][k]; out[2] = m[2][k];  out[3] = 0.0f;
+                out[4] = m[3][k]; out[5] = m[4][k]; out[6] = m[5][k];  out[7] = 0.0f;
+                out[8] = m[6][k]; out[9] = m[7][k]; out[10] = m[8][k]; out[11] = 0.0f;
+                out[12] = 0.0f;   out[13] = 0.0f;   out[14] = 0.0f;    out[15] = 1.0f;
+            }
+        }
+    }
+
+    void FloatToHalfArray(float const* src, std::uint16_t* dst, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), half);
+        }
+
+        if (i < count)
+        {
+            alignas(16) std::uint16_t padded[8];
+            std::size_t lanes = count - i;
+            __m128i half = _mm256_cvtps_ph(LoadLanes(src, i, lanes), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            _mm_store_si128(reinterpret_cast<__m128i*>(padded), half);
+            for (std::size_t k = 0; k < lanes; ++k)
+            {
+                dst[i + k] = padded[k];
+            }
+        }
+    }
+
+    void HalfToFloatArray(std::uint16_t const* src, float* dst, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i))));
+        }
+
+        if (i < count)
+        {
+            alignas(16) std::uint16_t padded[8] = {};
+            std::size_t lanes = count - i;
+            for (std::size_t k = 0; k < lanes; ++k)
+            {
+                padded[k] = src[i + k];
+            }
+            StoreLanes(dst, i, lanes, _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<__m128i const*>(padded))));
+        }
+    }
+
+    // x >= 0 ? a : -a, matching the scalar select so that -0 counts as positive
+    __m256 SelectSign(__m256 x, __m256 a)
+    {
+        return _mm256_blendv_ps(_mm256_sub_ps(_mm256_setzero_ps(), a), a, CmpGe(x, _mm256_setzero_ps()));
+    }
+
+    void EncodeOctahedral(float const* vectors, std::size_t stride, std::int16_t* dst, std::size_t count)
+    {
+        __m256 const sign_mask = _mm256_set1_ps(-0.0f);
+        __m256 const one = _mm256_set1_ps(1.0f);
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            __m256 x, y, z;
+            if (stride == 3 && lanes == 8)
+            {
+                LoadFloat3x8(vectors + i * 3, x, y, z);
+            }
+            else
+            {
+                // Padding lanes get +z so the projection stays finite
+                float v[3][8] = { {}, {}, { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f } };
+                for (std::size_t k = 0; k < lanes; ++k)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        v[c][k] = vectors[(i + k) * stride + c];
+                    }
+                }
+                x = _mm256_loadu_ps(v[0]);
+                y = _mm256_loadu_ps(v[1]);
+                z = _mm256_loadu_ps(v[2]);
+            }
+
+            __m256 l1 = _mm256_add_ps(_mm256_add_ps(_mm256_andnot_ps(sign_mask, x), _mm256_andnot_ps(sign_mask, y)), _mm256_andnot_ps(sign_mask, z));
+            __m256 inv_l1 = _mm256_div_ps(one, l1);
+            x = _mm256_mul_ps(x, inv_l1);
+            y = _mm256_mul_ps(y, inv_l1);
+
+            __m256 lower = CmpLt(z, _mm256_setzero_ps());
+            __m256 folded_x = SelectSign(x, _mm256_sub_ps(one, _mm256_andnot_ps(sign_mask, y)));
+            __m256 folded_y = SelectSign(y, _mm256_sub_ps(one, _mm256_andnot_ps(sign_mask, x)));
+            x = _mm256_blendv_ps(x, folded_x, lower);
+            y = _mm256_blendv_ps(y, folded_y, lower);
+
+            __m256 scale = _mm256_set1_ps(32767.0f);
+            __m256i qx = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-1.0f)), one), scale));
+            __m256i qy = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(y, _mm256_set1_ps(-1.0f)), one), scale));
+            // One (x, y) pair of int16 per 32-bit lane
+            __m256i packed = _mm256_or_si256(_mm256_and_si256(qx, _mm256_set1_epi32(0xffff)), _mm256_slli_epi32(qy, 16));
+
+            if (lanes == 8)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 2), packed);
+            }
+            else
+            {
+                alignas(32) std::int16_t padded[16];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(padded), packed);
+                for (std::size_t k = 0; k < lanes * 2; ++k)
+                {
+                    dst[i * 2 + k] = padded[k];
+                }
+            }
+        }
+    }
+
+    void DecodeOctahedral(std::int16_t const* src, float* vectors, std::size_t stride, std::size_t count)
+    {
+        __m256 const sign_mask = _mm256_set1_ps(-0.0f);
+        __m256 const minus_one = _mm256_set1_ps(-1.0f);
+        __m256 const inv_scale = _mm256_set1_ps(1.0f / 32767.0f);
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            __m256i packed;
+            if (lanes == 8)
+            {
+                packed = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i * 2));
+            }
+            else
+            {
+                alignas(32) std::int16_t padded[16] = {};
+                for (std::size_t k = 0; k < lanes * 2; ++k)
+                {
+                    padded[k] = src[i * 2 + k];
+                }
+                packed = _mm256_load_si256(reinterpret_cast<__m256i const*>(padded));
+            }
+
+            __m256 x = _mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(packed, 16), 16)), inv_scale), minus_one);
+            __m256 y = _mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(packed, 16)), inv_scale), minus_one);
+            __m256 z = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_andnot_ps(sign_mask, x)), _mm256_andnot_ps(sign_mask, y));
+            __m256 t = _mm256_max_ps(_mm256_sub_ps(_mm256_setzero_ps(), z), _mm256_setzero_ps());
+            x = _mm256_sub_ps(x, SelectSign(x, t));
+            y = _mm256_sub_ps(y, SelectSign(y, t));
+
+            __m256 length_sq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+            __m256 inv_length = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(length_sq));
+            x = _mm256_mul_ps(x, inv_length);
+            y = _mm256_mul_ps(y, inv_length);
+            z = _mm256_mul_ps(z, inv_length);
+
+            if (stride == 3 && lanes == 8)
+            {
+                StoreFloat3x8(vectors + i * 3, x, y, z);
+            }
+            else
+            {
+                float v[3][8];
+                _mm256_storeu_ps(v[0], x);
+                _mm256_storeu_ps(v[1], y);
+                _mm256_storeu_ps(v[2], z);
+                for (std::size_t k = 0; k < lanes; ++k)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        vectors[(i + k) * stride + c] = v[c][k];
+                    }
+                }
+            }
+        }
+    }
+
+    // Quaternion::ToMatrix with the scale applied to the columns, 8 lanes at a time
+    void PackTrs(float const* translation, float const* rotation, float const* scale, std::size_t stride,
+                 float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            // Translation, rotation and scale components in SoA
+            float trs[10][8] = {};
+            for (std::size_t k = 0; k < lanes; ++k)
+            {
+                std::size_t offset = (i + k) * stride;
+                for (int c = 0; c < 3; ++c)
+                {
+                    trs[c][k] = translation[offset + c];
+                    trs[7 + c][k] = scale[offset + c];
+                }
+                for (int c = 0; c < 4; ++c)
+                {
+                    trs[3 + c][k] = rotation[offset + c];
+                }
+            }
+
+            __m256 x = _mm256_loadu_ps(trs[3]), y = _mm256_loadu_ps(trs[4]), z = _mm256_loadu_ps(trs[5]), w = _mm256_loadu_ps(trs[6]);
+            __m256 sx = _mm256_loadu_ps(trs[7]), sy = _mm256_loadu_ps(trs[8]), sz = _mm256_loadu_ps(trs[9]);
+            __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+            __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+            __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f);
+
+            float m[12][8];
+            _mm256_storeu_ps(m[0], _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx));
+            _mm256_storeu_ps(m[1], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy));
+            _mm256_storeu_ps(m[2], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz));
+            _mm256_storeu_ps(m[4], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx));
+            _mm256_storeu_ps(m[5], _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy));
+            _mm256_storeu_ps(m[6], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz));
+            _mm256_storeu_ps(m[8], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx));
+            _mm256_storeu_ps(m[9], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy));
+            _mm256_storeu_ps(m[10], _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz));
+
+            for (std::size_t k = 0; k < lanes; ++k)
+            {
+                float* out = result + (i + k) * 12;
+                out[0] = m[0][k]; out[1] = m[1][k]; out[2] = m[2][k];  out[3] = trs[0][k];
+                out[4] = m[4][k]; out[5] = m[5][k]; out[6] = m[6][k];  out[7] = trs[1][k];
+                out[8] = m[8][k]; out[9] = m[9][k]; out[10] = m[10][k]; out[11] = trs[2][k];
+            }
+        }
+    }
+
+    template <int kBits>
+    __m256i RotlLanes(__m256i x)
+    {
+        return _mm256_or_si256(_mm256_slli_epi32(x, kBits), _mm256_srli_epi32(x, 32 - kBits));
+    }
+
+    // One xoshiro128** step of every stream, 8 streams per register
+    void NextRandomRound(std::uint32_t* state, std::uint32_t* result)
+    {
+        for (std::size_t k = 0; k < kRandomStreams; k += 8)
+        {
+            __m256i* s0 = reinterpret_cast<__m256i*>(state + k);
+            __m256i* s1 = reinterpret_cast<__m256i*>(state + kRandomStreams + k);
+            __m256i* s2 = reinterpret_cast<__m256i*>(state + kRandomStreams * 2 + k);
+            __m256i* s3 = reinterpret_cast<__m256i*>(state + kRandomStreams * 3 + k);
+            __m256i a = _mm256_loadu_si256(s0), b = _mm256_loadu_si256(s1), c = _mm256_loadu_si256(s2), d = _mm256_loadu_si256(s3);
+
+            __m256i r = _mm256_mullo_epi32(RotlLanes<7>(_mm256_mullo_epi32(b, _mm256_set1_epi32(5))), _mm256_set1_epi32(9));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(result + k), r);
+
+            __m256i t = _mm256_slli_epi32(b, 9);
+            c = _mm256_xor_si256(c, a);
+            d = _mm256_xor_si256(d, b);
+            b = _mm256_xor_si256(b, c);
+            a = _mm256_xor_si256(a, d);
+            c = _mm256_xor_si256(c, t);
+            d = RotlLanes<11>(d);
+
+            _mm256_storeu_si256(s0, a);
+            _mm256_storeu_si256(s1, b);
+            _mm256_storeu_si256(s2, c);
+            _mm256_storeu_si256(s3, d);
+        }
+    }
+
+    void RandomUint32(std::uint32_t* state, std::uint32_t* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += kRandomStreams)
+        {
+            if (i + kRandomStreams <= count)
+            {
+                NextRandomRound(state, result + i);
+                continue;
+            }
+
+            std::uint32_t round[kRandomStreams];
+            NextRandomRound(state, round);
+            for (std::size_t k = 0; i + k < count; ++k)
+            {
+                result[i + k] = round[k];
+            }
+        }
+    }
+
+    void RandomFloat(std::uint32_t* state, float* result, std::size_t count, float min, float max)
+    {
+        __m256 base = _mm256_set1_ps(min);
+        __m256 range = _mm256_set1_ps(max - min);
+        for (std::size_t i = 0; i < count; i += kRandomStreams)
+        {
+            std::uint32_t round[kRandomStreams];
+            NextRandomRound(state, round);
+            for (std::size_t k = 0; k < kRandomStreams; k += 8)
+            {
+                std::size_t lanes = i + k >= count ? 0 : (count - i - k < 8 ? count - i - k : 8);
+                __m256i bits = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(round + k)), 8);
+                __m256 unit = _mm256_mul_ps(_mm256_cvtepi32_ps(bits), _mm256_set1_ps(1.0f / 16777216.0f));
+                StoreLanes(result, i + k, lanes, _mm256_add_ps(base, _mm256_mul_ps(range, unit)));
+            }
+        }
+    }
+
+    __m256i HashLattice(__m256i x, __m256i y, __m256i z, __m256i seed)
+    {
+        __m256i h = _mm256_add_epi32(seed, _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x8da6b343u))));
+        h = _mm256_add_epi32(h, _mm256_mullo_epi32(y, _mm256_set1_epi32(static_cast<int>(0xd8163841u))));
+        h = _mm256_add_epi32(h, _mm256_mullo_epi32(z, _mm256_set1_epi32(static_cast<int>(0xcb1ab31fu))));
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+        h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x7feb352d));
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+        h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(0x846ca68bu)));
+        return _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    }
+
+    __m256 Fade(__m256 t)
+    {
+        __m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))), _mm256_set1_ps(10.0f));
+        return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+    }
+
+    __m256 LerpLanes(__m256 a, __m256 b, __m256 t)
+    {
+        return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+    }
+
+    // Same gradient selection as the scalar version, negation is a sign flip
+    __m256 Gradient(__m256i h, __m256 x, __m256 y, __m256 z)
+    {
+        h = _mm256_and_si256(h, _mm256_set1_epi32(15));
+        __m256 u = _mm256_blendv_ps(y, x, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h)));
+        __m256i use_x = _mm256_or_si256(_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)), _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14)));
+        __m256 v = _mm256_blendv_ps(z, x, _mm256_castsi256_ps(use_x));
+        v = _mm256_blendv_ps(v, y, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h)));
+        u = _mm256_xor_ps(u, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31)));
+        v = _mm256_xor_ps(v, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30)));
+        return _mm256_add_ps(u, v);
+    }
+
+    template <bool kGradient>
+    __m256 LatticeNoise(__m256 x, __m256 y, __m256 z, __m256i seed)
+    {
+        __m256 fx = _mm256_floor_ps(x), fy = _mm256_floor_ps(y), fz = _mm256_floor_ps(z);
+        __m256i ix = _mm256_cvttps_epi32(fx), iy = _mm256_cvttps_epi32(fy), iz = _mm256_cvttps_epi32(fz);
+        __m256 tx = _mm256_sub_ps(x, fx), ty = _mm256_sub_ps(y, fy), tz = _mm256_sub_ps(z, fz);
+
+        __m256 corner[8];
+        for (int c = 0; c < 8; ++c)
+        {
+            int dx = c & 1, dy = (c >> 1) & 1, dz = c >> 2;
+            __m256i h = HashLattice(_mm256_add_epi32(ix, _mm256_set1_epi32(dx)), _mm256_add_epi32(iy, _mm256_set1_epi32(dy)), _mm256_add_epi32(iz, _mm256_set1_epi32(dz)), seed);
+            if (kGradient)
+            {
+                corner[c] = Gradient(h, _mm256_sub_ps(tx, _mm256_set1_ps(static_cast<float>(dx))), _mm256_sub_ps(ty, _mm256_set1_ps(static_cast<float>(dy))),
+                    _mm256_sub_ps(tz, _mm256_set1_ps(static_cast<float>(dz))));
+            }
+            else
+            {
+                corner[c] = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8)), _mm256_set1_ps(1.0f / 8388608.0f)), _mm256_set1_ps(1.0f));
+            }
+        }
+
+        __m256 u = Fade(tx), v = Fade(ty), w = Fade(tz);
+        __m256 x00 = LerpLanes(corner[0], corner[1], u);
+        __m256 x10 = LerpLanes(corner[2], corner[3], u);
+        __m256 x01 = LerpLanes(corner[4], corner[5], u);
+        __m256 x11 = LerpLanes(corner[6], corner[7], u);
+        return LerpLanes(LerpLanes(x00, x10, v), LerpLanes(x01, x11, v), w);
+    }
+
+    __m256 SimplexCorner(__m256 x, __m256 y, __m256 z, __m256i h)
+    {
+        __m256 t = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(x, x)), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+        t = _mm256_max_ps(t, _mm256_setzero_ps());
+        t = _mm256_mul_ps(t, t);
+        return _mm256_mul_ps(_mm256_mul_ps(t, t), Gradient(h, x, y, z));
+    }
+
+    __m256 SimplexNoise(__m256 x, __m256 y, __m256 z, __m256i seed)
+    {
+        __m256 const skew = _mm256_set1_ps(1.0f / 3.0f);
+        __m256 const unskew = _mm256_set1_ps(1.0f / 6.0f);
+        __m256 const one = _mm256_set1_ps(1.0f);
+
+        __m256 s = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(x, y), z), skew);
+        __m256 fi = _mm256_floor_ps(_mm256_add_ps(x, s)), fj = _mm256_floor_ps(_mm256_add_ps(y, s)), fk = _mm256_floor_ps(_mm256_add_ps(z, s));
+        __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(fi, fj), fk), unskew);
+        __m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(fi, t)), y0 = _mm256_sub_ps(y, _mm256_sub_ps(fj, t)), z0 = _mm256_sub_ps(z, _mm256_sub_ps(fk, t));
+
+        // Traversal order as masks, see the scalar version for the case analysis
+        __m256 xy = CmpGe(x0, y0), yz = CmpGe(y0, z0), xz = CmpGe(x0, z0);
+        __m256 i1 = _mm256_and_ps(_mm256_and_ps(xy, xz), one);
+        __m256 j1 = _mm256_and_ps(_mm256_andnot_ps(xy, yz), one);
+        __m256 k1 = _mm256_sub_ps(_mm256_sub_ps(one, i1), j1);
+        __m256 i2 = _mm256_and_ps(_mm256_or_ps(xy, xz), one);
+        __m256 j2 = _mm256_andnot_ps(_mm256_andnot_ps(yz, xy), one);
+        __m256 k2 = _mm256_andnot_ps(_mm256_and_ps(yz, xz), one);
+
+        __m256i i = _mm256_cvttps_epi32(fi), j = _mm256_cvttps_epi32(fj), k = _mm256_cvttps_epi32(fk);
+        __m256 offset2 = _mm256_set1_ps(2.0f * (1.0f / 6.0f));
+        __m256 offset3 = _mm256_set1_ps(3.0f * (1.0f / 6.0f));
+        __m256 n = SimplexCorner(x0, y0, z0, HashLattice(i, j, k, seed));
+        n = _mm256_add_ps(n, SimplexCorner(_mm256_add_ps(_mm256_sub_ps(x0, i1), unskew), _mm256_add_ps(_mm256_sub_ps(y0, j1), unskew), _mm256_add_ps(_mm256_sub_ps(z0, k1), unskew),
+            HashLattice(_mm256_add_epi32(i, _mm256_cvttps_epi32(i1)), _mm256_add_epi32(j, _mm256_cvttps_epi32(j1)), _mm256_add_epi32(k, _mm256_cvttps_epi32(k1)), seed)));
+        n = _mm256_add_ps(n, SimplexCorner(_mm256_add_ps(_mm256_sub_ps(x0, i2), offset2), _mm256_add_ps(_mm256_sub_ps(y0, j2), offset2), _mm256_add_ps(_mm256_sub_ps(z0, k2), offset2),
+            HashLattice(_mm256_add_epi32(i, _mm256_cvttps_epi32(i2)), _mm256_add_epi32(j, _mm256_cvttps_epi32(j2)), _mm256_add_epi32(k, _mm256_cvttps_epi32(k2)), seed)));
+        __m256i one_i = _mm256_set1_epi32(1);
+        n = _mm256_add_ps(n, SimplexCorner(_mm256_add_ps(_mm256_sub_ps(x0, one), offset3), _mm256_add_ps(_mm256_sub_ps(y0, one), offset3), _mm256_add_ps(_mm256_sub_ps(z0, one), offset3),
+            HashLattice(_mm256_add_epi32(i, one_i), _mm256_add_epi32(j, one_i), _mm256_add_epi32(k, one_i), seed)));
+        return _mm256_mul_ps(_mm256_set1_ps(76.0f), n);
+    }
+
+    void Noise(NoiseType type, float const* x, float const* y, float const* z, std::uint32_t seed, float* result, std::size_t count)
+    {
+        __m256i seed_lanes = _mm256_set1_epi32(static_cast<int>(seed));
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            __m256 px = LoadLanes(x, i, lanes), py = LoadLanes(y, i, lanes), pz = LoadLanes(z, i, lanes);
+            __m256 value;
+            switch (type)
+            {
+            case NoiseType::kValue: value = LatticeNoise<false>(px, py, pz, seed_lanes); break;
+            case NoiseType::kGradient: value = LatticeNoise<true>(px, py, pz, seed_lanes); break;
+            default: value = SimplexNoise(px, py, pz, seed_lanes); break;
+            }
+            StoreLanes(result, i, lanes, value);
+        }
+    }
+
+    // Screen space triangle ready for rasterization. Edge i covers the pixel centers where
+    // edge_a[i] * (px - edge_x[i]) + edge_b[i] * (py - edge_y[i]) >= 0, depth is a plane through v0
+    struct DepthTriangle
+    {
+        float edge_a[3];
+        float edge_b[3];
+        float edge_x[3];
+        float edge_y[3];
+        float x0, y0, z0;
+        float dzdx, dzdy;
+        std::uint32_t min_x, max_x, min_y, max_y;
+    };
+
+    // Smallest integer >= value for value >= 0
+    std::uint32_t CeilToUint(float value)
+    {
+        std::uint32_t result = static_cast<std::uint32_t>(value);
+        return static_cast<float>(result) < value ? result + 1 : result;
+    }
+
+    // false for degenerate, NaN and off-screen triangles
+    bool SetupDepthTriangle(float const* v, std::uint32_t width, std::uint32_t height, DepthTriangle & t)
+    {
+        float x[3] = { v[0], v[3], v[6] };
+        float y[3] = { v[1], v[4], v[7] };
+        float z[3] = { v[2], v[5], v[8] };
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+        if (area < 0.0f)
+        {
+            // Flip to counter-clockwise in y-down coordinates so that inside is positive
+            float swap_x = x[1], swap_y = y[1], swap_z = z[1];
+            x[1] = x[2]; y[1] = y[2]; z[1] = z[2];
+            x[2] = swap_x; y[2] = swap_y; z[2] = swap_z;
+            area = -area;
+        }
+
+        if (!(area > 0.0f))
+        {
+            return false;
+        }
+
+        // Pixel centers in the bounding box, clamped to the buffer
+        float min_x = x[0] < x[1] ? (x[0] < x[2] ? x[0] : x[2]) : (x[1] < x[2] ? x[1] : x[2]);
+        float max_x = x[0] > x[1] ? (x[0] > x[2] ? x[0] : x[2]) : (x[1] > x[2] ? x[1] : x[2]);
+        float min_y = y[0] < y[1] ? (y[0] < y[2] ? y[0] : y[2]) : (y[1] < y[2] ? y[1] : y[2]);
+        float max_y = y[0] > y[1] ? (y[0] > y[2] ? y[0] : y[2]) : (y[1] > y[2] ? y[1] : y[2]);
+        float last_x = static_cast<float>(width - 1);
+        float last_y = static_cast<float>(height - 1);
+        min_x -= 0.5f; max_x -= 0.5f; min_y -= 0.5f; max_y -= 0.5f;
+        if (!(max_x >= 0.0f && max_y >= 0.0f && min_x <= last_x && min_y <= last_y))
+        {
+            return false;
+        }
+
+        t.min_x = CeilToUint(min_x > 0.0f ? min_x : 0.0f);
+        t.min_y = CeilToUint(min_y > 0.0f ? min_y : 0.0f);
+        t.max_x = static_cast<std::uint32_t>(max_x < last_x ? max_x : last_x);
+        t.max_y = static_cast<std::uint32_t>(max_y < last_y ? max_y : last_y);
+        if (t.min_x > t.max_x || t.min_y > t.max_y)
+        {
+            return false;
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            int j = i == 2 ? 0 : i + 1;
+            t.edge_a[i] = y[i] - y[j];
+            t.edge_b[i] = x[j] - x[i];
+            t.edge_x[i] = x[i];
+            t.edge_y[i] = y[i];
+        }
+
+        // Edge 2 is the barycentric of v1, edge 0 the one of v2
+        float inv_area = 1.0f / area;
+        t.x0 = x[0];
+        t.y0 = y[0];
+        t.z0 = z[0];
+        t.dzdx = (t.edge_a[2] * (z[1] - z[0]) + t.edge_a[0] * (z[2] - z[0])) * inv_area;
+        t.dzdy = (t.edge_b[2] * (z[1] - z[0]) + t.edge_b[0] * (z[2] - z[0])) * inv_area;
+        return true;
+    }
+
+    // Eight pixels per step, the steps are aligned to eight pixels so they never cross a row
+    void RasterizeDepth(float const* triangles, std::size_t count, float* depth, std::uint32_t width, std::uint32_t height)
+    {
+        __m256 lane_offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            DepthTriangle t;
+            if (!SetupDepthTriangle(triangles + i * 9, width, height, t))
+            {
+                continue;
+            }
+
+            __m256 edge_a[3], edge_x[3];
+            for (int e = 0; e < 3; ++e)
+            {
+                edge_a[e] = _mm256_set1_ps(t.edge_a[e]);
+                edge_x[e] = _mm256_set1_ps(t.edge_x[e]);
+            }
+            __m256 dzdx = _mm256_set1_ps(t.dzdx);
+            __m256 x0 = _mm256_set1_ps(t.x0);
+            __m256 box_min = _mm256_set1_ps(static_cast<float>(t.min_x) + 0.5f);
+            __m256 box_max = _mm256_set1_ps(static_cast<float>(t.max_x) + 0.5f);
+
+            for (std::uint32_t y = t.min_y; y <= t.max_y; ++y)
+            {
+                float py = static_cast<float>(y) + 0.5f;
+                __m256 row_edge[3];
+                for (int e = 0; e < 3; ++e)
+                {
+                    row_edge[e] = _mm256_set1_ps(t.edge_b[e] * (py - t.edge_y[e]));
+                }
+                __m256 row_z = _mm256_set1_ps(t.z0 + t.dzdy * (py - t.y0));
+
+                float* row = depth + static_cast<std::size_t>(y) * width;
+                for (std::uint32_t x = t.min_x & ~7u; x <= t.max_x; x += 8)
+                {
+                    __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lane_offsets);
+                    __m256 inside = _mm256_and_ps(_mm256_cmp_ps(px, box_min, _CMP_GE_OQ), _mm256_cmp_ps(px, box_max, _CMP_LE_OQ));
+                    for (int e = 0; e < 3; ++e)
+                    {
+                        __m256 edge = _mm256_fmadd_ps(edge_a[e], _mm256_sub_ps(px, edge_x[e]), row_edge[e]);
+                        inside = _mm256_and_ps(inside, _mm256_cmp_ps(edge, _mm256_setzero_ps(), _CMP_GE_OQ));
+                    }
+
+                    __m256 z = _mm256_fmadd_ps(dzdx, _mm256_sub_ps(px, x0), row_z);
+                    __m256 old = _mm256_loadu_ps(row + x);
+                    _mm256_storeu_ps(row + x, _mm256_blendv_ps(old, _mm256_min_ps(z, old), inside));
+                }
+            }
+        }
+    }
+}
+
+void FillMathKernelsAvx2(MathKernels & kernels)
+{
+    kernels.multiply_matrix = MultiplyMatrix;
+    kernels.transform_points = TransformPoints;
+    kernels.transform_vectors = TransformVectors;
+    kernels.transform_points_soa = TransformPointsSoa;
+    kernels.multiply_matrices = MultiplyMatrices;
+    kernels.cull_spheres = CullSpheres;
+    kernels.cull_aabbs = CullAabbs;
+    kernels.cull_spheres_multi = CullSpheresMulti;
+    kernels.cull_aabbs_multi = CullAabbsMulti;
+    kernels.compute_bounds = ComputeBounds;
+    kernels.max_distance_sq = MaxDistanceSq;
+    kernels.intersect_ray_aabbs = IntersectRayAabbs;
+    kernels.intersect_rays_aabb = IntersectRaysAabb;
+    kernels.intersect_ray_triangles = IntersectRayTriangles;
+    kernels.intersect_rays_triangle = IntersectRaysTriangle;
+    kernels.fast_sincos = FastSinCosArray;
+    kernels.fast_rsqrt = FastRsqrtArray;
+    kernels.fast_atan2 = FastAtan2Array;
+    kernels.fast_exp = FastExpArray;
+    kernels.fast_log = FastLogArray;
+    kernels.normalize_vectors = NormalizeVectors;
+    kernels.rotation_matrices = RotationMatrices;
+    kernels.float_to_half = FloatToHalfArray;
+    kernels.half_to_float = HalfToFloatArray;
+    kernels.encode_octahedral = EncodeOctahedral;
+    kernels.decode_octahedral = DecodeOctahedral;
+    kernels.pack_trs = PackTrs;
+    kernels.random_uint32 = RandomUint32;
+    kernels.random_float = RandomFloat;
+    kernels.noise = Noise;
+    kernels.rasterize_depth = RasterizeDepth;
+}
+
+#endif // CHAY_SIMD_X86
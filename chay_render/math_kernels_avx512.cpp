@@ -0,0 +1,224 @@
+#include "math_kernels.hpp"
+
+#if CHAY_SIMD_X86
+#include <immintrin.h>
+
+namespace
+{
+    void TransformPointsSoa(float const* m, float const* x, float const* y, float const* z,
+                            float* result_x, float* result_y, float* result_z, std::size_t count)
+    {
+        __m512 mm[12];
+        for (int i = 0; i < 12; ++i)
+        {
+            mm[i] = _mm512_set1_ps(m[i]);
+        }
+
+        // The tail is handled with a masked iteration
+        for (std::size_t i = 0; i < count; i += 16)
+        {
+            std::size_t remaining = count - i;
+            __mmask16 mask = remaining >= 16 ? __mmask16(0xffff) : __mmask16((1u << remaining) - 1);
+            __m512 px = _mm512_maskz_loadu_ps(mask, x + i);
+            __m512 py = _mm512_maskz_loadu_ps(mask, y + i);
+            __m512 pz = _mm512_maskz_loadu_ps(mask, z + i);
+            __m512 rx = _mm512_fmadd_ps(mm[0], px, _mm512_fmadd_ps(mm[1], py, _mm512_fmadd_ps(mm[2], pz, mm[3])));
+            __m512 ry = _mm512_fmadd_ps(mm[4], px, _mm512_fmadd_ps(mm[5], py, _mm512_fmadd_ps(mm[6], pz, mm[7])));
+            __m512 rz = _mm512_fmadd_ps(mm[8], px, _mm512_fmadd_ps(mm[9], py, _mm512_fmadd_ps(mm[10], pz, mm[11])));
+            _mm512_mask_storeu_ps(result_x + i, mask, rx);
+            _mm512_mask_storeu_ps(result_y + i, mask, ry);
+            _mm512_mask_storeu_ps(result_z + i, mask, rz);
+        }
+    }
+
+    void MultiplyMatrices(float const* a, float const* b, float* result, std::size_t count)
+    {
+        // One product per register, rows of b are duplicated into all four 128-bit lanes
+        // and in-lane shuffles broadcast a[i][k] within each row of a. GCC's headers build the
+        // broadcast, permute and unmasked lane shuffle on an undefined register, which trips
+        // -Wmaybe-uninitialized; the all-ones zero-masked shuffle compiles to the same vshuff32x4
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            __m512 bi = _mm512_loadu_ps(b + i * 16);
+            __m512 b0 = _mm512_maskz_shuffle_f32x4(0xffff, bi, bi, 0x00);
+            __m512 b1 = _mm512_maskz_shuffle_f32x4(0xffff, bi, bi, 0x55);
+            __m512 b2 = _mm512_maskz_shuffle_f32x4(0xffff, bi, bi, 0xaa);
+            __m512 b3 = _mm512_maskz_shuffle_f32x4(0xffff, bi, bi, 0xff);
+            __m512 ai = _mm512_loadu_ps(a + i * 16);
+
+            __m512 r = _mm512_mul_ps(_mm512_shuffle_ps(ai, ai, 0x00), b0);
+            r = _mm512_fmadd_ps(_mm512_shuffle_ps(ai, ai, 0x55), b1, r);
+            r = _mm512_fmadd_ps(_mm512_shuffle_ps(ai, ai, 0xaa), b2, r);
+            r = _mm512_fmadd_ps(_mm512_shuffle_ps(ai, ai, 0xff), b3, r);
+            _mm512_storeu_ps(result + i * 16, r);
+        }
+    }
+
+    float Abs(float value)
+    {
+        return value < 0.0f ? -value : value;
+    }
+
+    __mmask16 TailMask(std::size_t remaining)
+    {
+        return remaining >= 16 ? __mmask16(0xffff) : __mmask16((1u << remaining) - 1);
+    }
+
+    template <typename RadiusFunc>
+    void ClassifyPlanes16(float const* planes, __m512 x, __m512 y, __m512 z, RadiusFunc radius,
+                          __mmask16 & outside, __mmask16 & intersect)
+    {
+        outside = 0;
+        intersect = 0;
+        for (int i = 0; i < 6; ++i)
+        {
+            float const* plane = planes + i * 4;
+            __m512 distance = _mm512_fmadd_ps(_mm512_set1_ps(plane[0]), x,
+                              _mm512_fmadd_ps(_mm512_set1_ps(plane[1]), y,
+                              _mm512_fmadd_ps(_mm512_set1_ps(plane[2]), z, _mm512_set1_ps(plane[3]))));
+            __m512 r = radius(plane);
+            outside |= _mm512_cmp_ps_mask(_mm512_add_ps(distance, r), _mm512_setzero_ps(), _CMP_LT_OQ);
+            intersect |= _mm512_cmp_ps_mask(distance, r, _CMP_LT_OQ);
+        }
+    }
+
+    // Mask-to-byte moves give -1 per set lane, so inside + both masks is the result
+    void StoreCullResults(std::uint8_t* result, __mmask16 outside, __mmask16 intersect, __mmask16 store_mask)
+    {
+        __m128i bytes = _mm_add_epi8(_mm_set1_epi8(kCullInside), _mm_add_epi8(_mm_movm_epi8(outside), _mm_movm_epi8(intersect)));
+        _mm_mask_storeu_epi8(result, store_mask, bytes);
+    }
+
+    void CullSpheres(float const* planes, float const* x, float const* y, float const* z,
+                     float const* radius, std::uint8_t* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 16)
+        {
+            __mmask16 mask = TailMask(count - i);
+            __m512 r = _mm512_maskz_loadu_ps(mask, radius + i);
+            __mmask16 outside, intersect;
+            ClassifyPlanes16(planes, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), _mm512_maskz_loadu_ps(mask, z + i),
+                             [r](float const*) { return r; }, outside, intersect);
+            StoreCullResults(result + i, outside, intersect, mask);
+        }
+    }
+
+    void CullAabbs(float const* planes, float const* center_x, float const* center_y, float const* center_z,
+                   float const* extent_x, float const* extent_y, float const* extent_z,
+                   std::uint8_t* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 16)
+        {
+            __mmask16 mask = TailMask(count - i);
+            __m512 ex = _mm512_maskz_loadu_ps(mask, extent_x + i);
+            __m512 ey = _mm512_maskz_loadu_ps(mask, extent_y + i);
+            __m512 ez = _mm512_maskz_loadu_ps(mask, extent_z + i);
+            auto radius = [ex, ey, ez](float const* plane)
+            {
+                return _mm512_fmadd_ps(_mm512_set1_ps(Abs(plane[0])), ex,
+                       _mm512_fmadd_ps(_mm512_set1_ps(Abs(plane[1])), ey, _mm512_mul_ps(_mm512_set1_ps(Abs(plane[2])), ez)));
+            };
+
+            __mmask16 outside, intersect;
+            ClassifyPlanes16(planes, _mm512_maskz_loadu_ps(mask, center_x + i), _mm512_maskz_loadu_ps(mask, center_y + i),
+                             _mm512_maskz_loadu_ps(mask, center_z + i), radius, outside, intersect);
+            StoreCullResults(result + i, outside, intersect, mask);
+        }
+    }
+
+    // Visibility bits of sixteen bounds against every view, tails are masked
+    template <typename RadiusFunc>
+    __m512i Visibility16(float const* planes, std::size_t view_count, __m512 x, __m512 y, __m512 z, RadiusFunc radius)
+    {
+        __m512i visibility = _mm512_setzero_si512();
+        for (std::size_t view = 0; view < view_count; ++view)
+        {
+            __mmask16 outside = 0;
+            for (int i = 0; i < 6; ++i)
+            {
+                float const* plane = planes + view * 24 + i * 4;
+                __m512 distance = _mm512_fmadd_ps(_mm512_set1_ps(plane[0]), x,
+                                  _mm512_fmadd_ps(_mm512_set1_ps(plane[1]), y,
+                                  _mm512_fmadd_ps(_mm512_set1_ps(plane[2]), z, _mm512_set1_ps(plane[3]))));
+                outside |= _mm512_cmp_ps_mask(_mm512_add_ps(distance, radius(plane)), _mm512_setzero_ps(), _CMP_LT_OQ);
+            }
+
+            visibility = _mm512_mask_or_epi32(visibility, static_cast<__mmask16>(~outside), visibility,
+                                              _mm512_set1_epi32(static_cast<int>(1u << view)));
+        }
+
+        return visibility;
+    }
+
+    void CullSpheresMulti(float const* planes, std::size_t view_count, float const* x, float const* y, float const* z,
+                          float const* radius, std::uint32_t* visibility, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 16)
+        {
+            __mmask16 mask = TailMask(count - i);
+            __m512 r = _mm512_maskz_loadu_ps(mask, radius + i);
+            _mm512_mask_storeu_epi32(visibility + i, mask,
+                                     Visibility16(planes, view_count, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i),
+                                                  _mm512_maskz_loadu_ps(mask, z + i), [r](float const*) { return r; }));
+        }
+    }
+
+    void CullAabbsMulti(float const* planes, std::size_t view_count,
+                        float const* center_x, float const* center_y, float const* center_z,
+                        float const* extent_x, float const* extent_y, float const* extent_z,
+                        std::uint32_t* visibility, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 16)
+        {
+            __mmask16 mask = TailMask(count - i);
+            __m512 ex = _mm512_maskz_loadu_ps(mask, extent_x + i);
+            __m512 ey = _mm512_maskz_loadu_ps(mask, extent_y + i);
+            __m512 ez = _mm512_maskz_loadu_ps(mask, extent_z + i);
+            auto radius = [ex, ey, ez](float const* plane)
+            {
+                return _mm512_fmadd_ps(_mm512_set1_ps(Abs(plane[0])), ex,
+                       _mm512_fmadd_ps(_mm512_set1_ps(Abs(plane[1])), ey, _mm512_mul_ps(_mm512_set1_ps(Abs(plane[2])), ez)));
+            };
+
+            _mm512_mask_storeu_epi32(visibility + i, mask,
+                                     Visibility16(planes, view_count, _mm512_maskz_loadu_ps(mask, center_x + i),
+                                                  _mm512_maskz_loadu_ps(mask, center_y + i), _mm512_maskz_loadu_ps(mask, center_z + i), radius));
+        }
+    }
+
+    void FloatToHalfArray(float const* src, std::uint16_t* dst, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 16)
+        {
+            __mmask16 mask = TailMask(count - i);
+            // Zero-masked conversions, the unmasked ones convert into an undefined register
+            __m256i half = _mm512_maskz_cvtps_ph(mask, _mm512_maskz_loadu_ps(mask, src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            _mm256_mask_storeu_epi16(dst + i, mask, half);
+        }
+    }
+
+    void HalfToFloatArray(std::uint16_t const* src, float* dst, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 16)
+        {
+            __mmask16 mask = TailMask(count - i);
+            _mm512_mask_storeu_ps(dst + i, mask, _mm512_maskz_cvtph_ps(mask, _mm256_maskz_loadu_epi16(mask, src + i)));
+        }
+    }
+}
+
+void FillMathKernelsAvx512(MathKernels & kernels)
+{
+    // A single 4x4 product is too small for 512-bit registers, AVX2 kernels are kept for it
+    // and for AoS points whose float3 layout does not split into 512-bit loads
+    kernels.transform_points_soa = TransformPointsSoa;
+    kernels.multiply_matrices = MultiplyMatrices;
+    kernels.cull_spheres = CullSpheres;
+    kernels.cull_aabbs = CullAabbs;
+    kernels.cull_spheres_multi = CullSpheresMulti;
+    kernels.cull_aabbs_multi = CullAabbsMulti;
+    kernels.float_to_half = FloatToHalfArray;
+    kernels.half_to_float = HalfToFloatArray;
+}
+
+#endif // CHAY_SIMD_X86
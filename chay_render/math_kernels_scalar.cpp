@@ -0,0 +1,1049 @@
+#include "math_kernels.hpp"
+#include "fast_math.hpp"
+
+namespace
+{
+    void MultiplyMatrix(float const* a, float const* b, float* result)
+    {
+        float r[16];
+        for (int i = 0; i < 4; ++i)
+        {
+            float x = a[i * 4 + 0];
+            float y = a[i * 4 + 1];
+            float z = a[i * 4 + 2];
+            float w = a[i * 4 + 3];
+            for (int j = 0; j < 4; ++j)
+            {
+                r[i * 4 + j] = (b[0 * 4 + j] * x) + (b[1 * 4 + j] * y) + (b[2 * 4 + j] * z) + (b[3 * 4 + j] * w);
+            }
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            result[i] = r[i];
+        }
+    }
+
+    void InvertMatrix(float const* m, float* result)
+    {
+        // 2x2 sub-determinants of the two upper and the two lower rows
+        float s0 = m[0] * m[5] - m[4] * m[1];
+        float s1 = m[0] * m[6] - m[4] * m[2];
+        float s2 = m[0] * m[7] - m[4] * m[3];
+        float s3 = m[1] * m[6] - m[5] * m[2];
+        float s4 = m[1] * m[7] - m[5] * m[3];
+        float s5 = m[2] * m[7] - m[6] * m[3];
+
+        float c5 = m[10] * m[15] - m[14] * m[11];
+        float c4 = m[9] * m[15] - m[13] * m[11];
+        float c3 = m[9] * m[14] - m[13] * m[10];
+        float c2 = m[8] * m[15] - m[12] * m[11];
+        float c1 = m[8] * m[14] - m[12] * m[10];
+        float c0 = m[8] * m[13] - m[12] * m[9];
+
+        float inv_det = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+        float r[16];
+        r[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * inv_det;
+        r[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * inv_det;
+        r[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * inv_det;
+        r[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * inv_det;
+
+        r[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * inv_det;
+        r[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * inv_det;
+        r[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * inv_det;
+        r[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * inv_det;
+
+        r[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * inv_det;
+        r[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * inv_det;
+        r[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * inv_det;
+        r[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * inv_det;
+
+        r[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * inv_det;
+        r[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * inv_det;
+        r[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * inv_det;
+        r[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * inv_det;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            result[i] = r[i];
+        }
+    }
+
+    // a is the inverse of the upper-left 3x3 block, row-major with a stride of 3
+    void CompleteAffineInverse(float const* m, float const* a, float* result)
+    {
+        // Translation column c and translation row r, one of them is zero
+        float c[3] = { m[3], m[7], m[11] };
+        float r[3] = { m[12], m[13], m[14] };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            result[i * 4 + 0] = a[i * 3 + 0];
+            result[i * 4 + 1] = a[i * 3 + 1];
+            result[i * 4 + 2] = a[i * 3 + 2];
+            result[i * 4 + 3] = -(a[i * 3 + 0] * c[0] + a[i * 3 + 1] * c[1] + a[i * 3 + 2] * c[2]);
+        }
+
+        for (int j = 0; j < 3; ++j)
+        {
+            result[12 + j] = -(r[0] * a[0 * 3 + j] + r[1] * a[1 * 3 + j] + r[2] * a[2 * 3 + j]);
+        }
+
+        result[15] = 1.0f;
+    }
+
+    void InvertAffine(float const* m, float* result)
+    {
+        // Adjugate of the 3x3 block: rows of the inverse are the cross products of its columns
+        float a[9];
+        a[0] = m[5] * m[10] - m[6] * m[9];
+        a[1] = m[2] * m[9] - m[1] * m[10];
+        a[2] = m[1] * m[6] - m[2] * m[5];
+        a[3] = m[6] * m[8] - m[4] * m[10];
+        a[4] = m[0] * m[10] - m[2] * m[8];
+        a[5] = m[2] * m[4] - m[0] * m[6];
+        a[6] = m[4] * m[9] - m[5] * m[8];
+        a[7] = m[1] * m[8] - m[0] * m[9];
+        a[8] = m[0] * m[5] - m[1] * m[4];
+
+        float inv_det = 1.0f / (m[0] * a[0] + m[1] * a[3] + m[2] * a[6]);
+        for (int i = 0; i < 9; ++i)
+        {
+            a[i] *= inv_det;
+        }
+
+        CompleteAffineInverse(m, a, result);
+    }
+
+    void InvertRigid(float const* m, float* result)
+    {
+        float a[9] =
+        {
+            m[0], m[4], m[8],
+            m[1], m[5], m[9],
+            m[2], m[6], m[10]
+        };
+
+        CompleteAffineInverse(m, a, result);
+    }
+
+    void TransformPoints(float const* m, float const* points, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float x = points[i * 3 + 0];
+            float y = points[i * 3 + 1];
+            float z = points[i * 3 + 2];
+            result[i * 3 + 0] = m[0] * x + m[1] * y + m[2] * z + m[3];
+            result[i * 3 + 1] = m[4] * x + m[5] * y + m[6] * z + m[7];
+            result[i * 3 + 2] = m[8] * x + m[9] * y + m[10] * z + m[11];
+        }
+    }
+
+    void TransformVectors(float const* m, float const* vectors, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float x = vectors[i * 3 + 0];
+            float y = vectors[i * 3 + 1];
+            float z = vectors[i * 3 + 2];
+            result[i * 3 + 0] = m[0] * x + m[1] * y + m[2] * z;
+            result[i * 3 + 1] = m[4] * x + m[5] * y + m[6] * z;
+            result[i * 3 + 2] = m[8] * x + m[9] * y + m[10] * z;
+        }
+    }
+
+    void TransformPointsSoa(float const* m, float const* x, float const* y, float const* z,
+                            float* result_x, float* result_y, float* result_z, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float px = x[i];
+            float py = y[i];
+            float pz = z[i];
+            result_x[i] = m[0] * px + m[1] * py + m[2] * pz + m[3];
+            result_y[i] = m[4] * px + m[5] * py + m[6] * pz + m[7];
+            result_z[i] = m[8] * px + m[9] * py + m[10] * pz + m[11];
+        }
+    }
+
+    void MultiplyMatrices(float const* a, float const* b, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            MultiplyMatrix(a + i * 16, b + i * 16, result + i * 16);
+        }
+    }
+
+    // Local instead of std::abs, see the note on kernel includes in math_kernels.hpp
+    float Abs(float value)
+    {
+        return value < 0.0f ? -value : value;
+    }
+
+    std::uint8_t CullSphere(float const* planes, float x, float y, float z, float radius)
+    {
+        std::uint8_t result = kCullInside;
+        for (int i = 0; i < 6; ++i)
+        {
+            float const* plane = planes + i * 4;
+            float distance = plane[0] * x + plane[1] * y + plane[2] * z + plane[3];
+            if (distance < -radius)
+            {
+                return kCullOutside;
+            }
+
+            if (distance < radius)
+            {
+                result = kCullIntersect;
+            }
+        }
+
+        return result;
+    }
+
+    std::uint8_t CullAabb(float const* planes, float x, float y, float z, float ex, float ey, float ez)
+    {
+        // Projected radius of the box onto the plane normal
+        std::uint8_t result = kCullInside;
+        for (int i = 0; i < 6; ++i)
+        {
+            float const* plane = planes + i * 4;
+            float distance = plane[0] * x + plane[1] * y + plane[2] * z + plane[3];
+            float radius = Abs(plane[0]) * ex + Abs(plane[1]) * ey + Abs(plane[2]) * ez;
+            if (distance < -radius)
+            {
+                return kCullOutside;
+            }
+
+            if (distance < radius)
+            {
+                result = kCullIntersect;
+            }
+        }
+
+        return result;
+    }
+
+    void CullSpheres(float const* planes, float const* x, float const* y, float const* z,
+                     float const* radius, std::uint8_t* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            result[i] = CullSphere(planes, x[i], y[i], z[i], radius[i]);
+        }
+    }
+
+    void CullAabbs(float const* planes, float const* center_x, float const* center_y, float const* center_z,
+                   float const* extent_x, float const* extent_y, float const* extent_z,
+                   std::uint8_t* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            result[i] = CullAabb(planes, center_x[i], center_y[i], center_z[i], extent_x[i], extent_y[i], extent_z[i]);
+        }
+    }
+
+    void CullSpheresMulti(float const* planes, std::size_t view_count, float const* x, float const* y, float const* z,
+                          float const* radius, std::uint32_t* visibility, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::uint32_t mask = 0;
+            for (std::size_t view = 0; view < view_count; ++view)
+            {
+                mask |= CullSphere(planes + view * 24, x[i], y[i], z[i], radius[i]) != kCullOutside ? 1u << view : 0u;
+            }
+            visibility[i] = mask;
+        }
+    }
+
+    void CullAabbsMulti(float const* planes, std::size_t view_count,
+                        float const* center_x, float const* center_y, float const* center_z,
+                        float const* extent_x, float const* extent_y, float const* extent_z,
+                        std::uint32_t* visibility, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::uint32_t mask = 0;
+            for (std::size_t view = 0; view < view_count; ++view)
+            {
+                mask |= CullAabb(planes + view * 24, center_x[i], center_y[i], center_z[i],
+                                 extent_x[i], extent_y[i], extent_z[i]) != kCullOutside ? 1u << view : 0u;
+            }
+            visibility[i] = mask;
+        }
+    }
+
+    void ComputeBounds(float const* points, std::size_t stride, std::size_t count, float* min, float* max)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            min[c] = 3.402823466e+38f;
+            max[c] = -3.402823466e+38f;
+        }
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float const* p = points + i * stride;
+            for (int c = 0; c < 3; ++c)
+            {
+                min[c] = p[c] < min[c] ? p[c] : min[c];
+                max[c] = p[c] > max[c] ? p[c] : max[c];
+            }
+        }
+    }
+
+    float MaxDistanceSq(float const* points, std::size_t stride, std::size_t count, float const* center)
+    {
+        float result = 0.0f;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float const* p = points + i * stride;
+            float dx = p[0] - center[0];
+            float dy = p[1] - center[1];
+            float dz = p[2] - center[2];
+            float distance_sq = dx * dx + dy * dy + dz * dz;
+            result = distance_sq > result ? distance_sq : result;
+        }
+
+        return result;
+    }
+
+    void TransformAabbs(float const* m, float const* boxes, float* result, std::size_t count)
+    {
+        // Center goes through the full transform, half extents through |M|
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float const* box = boxes + i * 6;
+            float center[3], extent[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                center[c] = (box[c] + box[c + 3]) * 0.5f;
+                extent[c] = (box[c + 3] - box[c]) * 0.5f;
+            }
+
+            float* out = result + i * 6;
+            for (int r = 0; r < 3; ++r)
+            {
+                float const* row = m + r * 4;
+                float c = row[0] * center[0] + row[1] * center[1] + row[2] * center[2] + row[3];
+                float e = Abs(row[0]) * extent[0] + Abs(row[1]) * extent[1] + Abs(row[2]) * extent[2];
+                out[r] = c - e;
+                out[r + 3] = c + e;
+            }
+        }
+    }
+
+    // Determinants below this are treated as rays parallel to the triangle
+    constexpr float kParallelEpsilon = 1e-12f;
+
+    float SlabTest(float const o[3], float const inv[3], float t_max, float const lo[3], float const hi[3])
+    {
+        float t_near = 0.0f;
+        float t_far = t_max;
+        for (int c = 0; c < 3; ++c)
+        {
+            float t0 = (lo[c] - o[c]) * inv[c];
+            float t1 = (hi[c] - o[c]) * inv[c];
+            t_near = t_near > (t0 < t1 ? t0 : t1) ? t_near : (t0 < t1 ? t0 : t1);
+            t_far = t_far < (t0 > t1 ? t0 : t1) ? t_far : (t0 > t1 ? t0 : t1);
+        }
+
+        return t_near <= t_far ? t_near : kRayMiss;
+    }
+
+    void Cross(float const a[3], float const b[3], float r[3])
+    {
+        r[0] = a[1] * b[2] - a[2] * b[1];
+        r[1] = a[2] * b[0] - a[0] * b[2];
+        r[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    float Dot(float const a[3], float const b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    float MollerTrumbore(float const o[3], float const d[3], float t_max,
+                         float const v0[3], float const v1[3], float const v2[3], float & u, float & v)
+    {
+        float e1[3], e2[3], s[3], p[3], q[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            e1[c] = v1[c] - v0[c];
+            e2[c] = v2[c] - v0[c];
+            s[c] = o[c] - v0[c];
+        }
+
+        Cross(d, e2, p);
+        float det = Dot(e1, p);
+        if (Abs(det) <= kParallelEpsilon)
+        {
+            return kRayMiss;
+        }
+
+        float inv_det = 1.0f / det;
+        u = Dot(s, p) * inv_det;
+        Cross(s, e1, q);
+        v = Dot(d, q) * inv_det;
+        float t = Dot(e2, q) * inv_det;
+        bool hit = u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t <= t_max;
+        return hit ? t : kRayMiss;
+    }
+
+    void IntersectRayAabbs(float const* ray, AabbArrays const& boxes, std::size_t count, float* t)
+    {
+        float inv[3] = { 1.0f / ray[3], 1.0f / ray[4], 1.0f / ray[5] };
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float lo[3] = { boxes.min_point[0][i], boxes.min_point[1][i], boxes.min_point[2][i] };
+            float hi[3] = { boxes.max_point[0][i], boxes.max_point[1][i], boxes.max_point[2][i] };
+            t[i] = SlabTest(ray, inv, ray[6], lo, hi);
+        }
+    }
+
+    void IntersectRaysAabb(RayArrays const& rays, std::size_t count, float const* box, float* t)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float o[3] = { rays.origin[0][i], rays.origin[1][i], rays.origin[2][i] };
+            float inv[3] = { rays.inv_direction[0][i], rays.inv_direction[1][i], rays.inv_direction[2][i] };
+            t[i] = SlabTest(o, inv, rays.t_max[i], box, box + 3);
+        }
+    }
+
+    void IntersectRayTriangles(float const* ray, TriangleArrays const& triangles, std::size_t count,
+                               float* t, float* u, float* v)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float v0[3] = { triangles.v0[0][i], triangles.v0[1][i], triangles.v0[2][i] };
+            float v1[3] = { triangles.v1[0][i], triangles.v1[1][i], triangles.v1[2][i] };
+            float v2[3] = { triangles.v2[0][i], triangles.v2[1][i], triangles.v2[2][i] };
+            u[i] = 0.0f;
+            v[i] = 0.0f;
+            t[i] = MollerTrumbore(ray, ray + 3, ray[6], v0, v1, v2, u[i], v[i]);
+        }
+    }
+
+    void IntersectRaysTriangle(RayArrays const& rays, std::size_t count, float const* triangle,
+                               float* t, float* u, float* v)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float o[3] = { rays.origin[0][i], rays.origin[1][i], rays.origin[2][i] };
+            float d[3] = { rays.direction[0][i], rays.direction[1][i], rays.direction[2][i] };
+            u[i] = 0.0f;
+            v[i] = 0.0f;
+            t[i] = MollerTrumbore(o, d, rays.t_max[i], triangle, triangle + 3, triangle + 6, u[i], v[i]);
+        }
+    }
+
+    void FastSinCosArray(float const* x, float* sin, float* cos, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float s, c;
+            FastSinCos(x[i], s, c);
+            sin[i] = s;
+            cos[i] = c;
+        }
+    }
+
+    void FastRsqrtArray(float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            result[i] = FastRsqrt(x[i]);
+        }
+    }
+
+    void FastAtan2Array(float const* y, float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            result[i] = FastAtan2(y[i], x[i]);
+        }
+    }
+
+    void FastExpArray(float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            result[i] = FastExp(x[i]);
+        }
+    }
+
+    void FastLogArray(float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            result[i] = FastLog(x[i]);
+        }
+    }
+
+    void NormalizeVectors(float const* vectors, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float const* v = vectors + i * 3;
+            float inv_length = FastRsqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            result[i * 3 + 0] = v[0] * inv_length;
+            result[i * 3 + 1] = v[1] * inv_length;
+            result[i * 3 + 2] = v[2] * inv_length;
+        }
+    }
+
+    void RotationMatrices(float const* axes, float const* angles, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float const* axis = axes + i * 3;
+            float inv_length = FastRsqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            float x = axis[0] * inv_length;
+            float y = axis[1] * inv_length;
+            float z = axis[2] * inv_length;
+            float s, c;
+            FastSinCos(angles[i], s, c);
+            float t = 1.0f - c;
+
+            float* m = result + i * 16;
+            m[0] = x * x * t + c;     m[1] = x * y * t - z * s; m[2] = x * z * t + y * s;  m[3] = 0.0f;
+            m[4] = x * y * t + z * s; m[5] = y * y * t + c;     m[6] = y * z * t - x * s;  m[7] = 0.0f;
+            m[8] = x * z * t - y * s; m[9] = y * z * t + x * s; m[10] = z * z * t + c;    m[11] = 0.0f;
+            m[12] = 0.0f;             m[13] = 0.0f;             m[14] = 0.0f;             m[15] = 1.0f;
+        }
+    }
+
+    // Branchy but exact conversions, denormals included
+    std::uint16_t FloatToHalf(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        std::uint32_t sign = (bits >> 16) & 0x8000u;
+        bits &= 0x7fffffffu;
+
+        std::uint32_t result;
+        if (bits >= 0x47800000u)
+        {
+            // 65536 and above, infinity or NaN
+            result = bits > 0x7f800000u ? 0x7e00u : 0x7c00u;
+        }
+        else if (bits < 0x38800000u)
+        {
+            // Half denormal or zero, the float add rounds the mantissa into place
+            float magic_value;
+            std::uint32_t magic = 126u << 23;
+            std::memcpy(&magic_value, &magic, sizeof(magic_value));
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            f += magic_value;
+            std::memcpy(&result, &f, sizeof(result));
+            result -= magic;
+        }
+        else
+        {
+            std::uint32_t mantissa_odd = (bits >> 13) & 1u;
+            bits += (static_cast<std::uint32_t>(15 - 127) << 23) + 0xfffu + mantissa_odd;
+            result = bits >> 13;
+        }
+
+        return static_cast<std::uint16_t>(result | sign);
+    }
+
+    float HalfToFloat(std::uint16_t value)
+    {
+        std::uint32_t bits = (value & 0x7fffu) << 13;
+        std::uint32_t exponent = bits & (0x7c00u << 13);
+        bits += static_cast<std::uint32_t>(127 - 15) << 23;
+
+        float result;
+        if (exponent == (0x7c00u << 13))
+        {
+            bits += static_cast<std::uint32_t>(128 - 16) << 23;
+            std::memcpy(&result, &bits, sizeof(result));
+        }
+        else if (exponent == 0)
+        {
+            // Denormal, renormalize through a float subtraction
+            bits += 1u << 23;
+            std::memcpy(&result, &bits, sizeof(result));
+            result -= 6.10351562e-05f;
+        }
+        else
+        {
+            std::memcpy(&result, &bits, sizeof(result));
+        }
+
+        return (value & 0x8000u) != 0 ? -result : result;
+    }
+
+    void FloatToHalfArray(float const* src, std::uint16_t* dst, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            dst[i] = FloatToHalf(src[i]);
+        }
+    }
+
+    void HalfToFloatArray(std::uint16_t const* src, float* dst, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            dst[i] = HalfToFloat(src[i]);
+        }
+    }
+
+    template <typename T>
+    void FloatToNormT(float const* src, T* dst, std::size_t count, float lower, float scale)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float clamped = std::fmin(std::fmax(src[i], lower), 1.0f);
+            dst[i] = static_cast<T>(std::nearbyint(clamped * scale));
+        }
+    }
+
+    template <typename T>
+    void NormToFloatT(T const* src, float* dst, std::size_t count, float lower, float scale)
+    {
+        // snorm has one more negative code than positive ones, it decodes to -1 as well
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            dst[i] = std::fmax(static_cast<float>(src[i]) * (1.0f / scale), lower);
+        }
+    }
+
+    void FloatToNorm(NormFormat format, float const* src, void* dst, std::size_t count)
+    {
+        switch (format)
+        {
+        case NormFormat::kSnorm8: FloatToNormT(src, static_cast<std::int8_t*>(dst), count, -1.0f, 127.0f); break;
+        case NormFormat::kUnorm8: FloatToNormT(src, static_cast<std::uint8_t*>(dst), count, 0.0f, 255.0f); break;
+        case NormFormat::kSnorm16: FloatToNormT(src, static_cast<std::int16_t*>(dst), count, -1.0f, 32767.0f); break;
+        case NormFormat::kUnorm16: FloatToNormT(src, static_cast<std::uint16_t*>(dst), count, 0.0f, 65535.0f); break;
+        }
+    }
+
+    void NormToFloat(NormFormat format, void const* src, float* dst, std::size_t count)
+    {
+        switch (format)
+        {
+        case NormFormat::kSnorm8: NormToFloatT(static_cast<std::int8_t const*>(src), dst, count, -1.0f, 127.0f); break;
+        case NormFormat::kUnorm8: NormToFloatT(static_cast<std::uint8_t const*>(src), dst, count, 0.0f, 255.0f); break;
+        case NormFormat::kSnorm16: NormToFloatT(static_cast<std::int16_t const*>(src), dst, count, -1.0f, 32767.0f); break;
+        case NormFormat::kUnorm16: NormToFloatT(static_cast<std::uint16_t const*>(src), dst, count, 0.0f, 65535.0f); break;
+        }
+    }
+
+    void EncodeOctahedral(float const* vectors, std::size_t stride, std::int16_t* dst, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            // Project onto the octahedron, fold the lower hemisphere over the diagonals
+            float const* v = vectors + i * stride;
+            float inv_l1 = 1.0f / (std::abs(v[0]) + std::abs(v[1]) + std::abs(v[2]));
+            float x = v[0] * inv_l1;
+            float y = v[1] * inv_l1;
+            if (v[2] < 0.0f)
+            {
+                float folded_x = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+                float folded_y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+                x = folded_x;
+                y = folded_y;
+            }
+
+            dst[i * 2 + 0] = static_cast<std::int16_t>(std::nearbyint(std::fmin(std::fmax(x, -1.0f), 1.0f) * 32767.0f));
+            dst[i * 2 + 1] = static_cast<std::int16_t>(std::nearbyint(std::fmin(std::fmax(y, -1.0f), 1.0f) * 32767.0f));
+        }
+    }
+
+    void DecodeOctahedral(std::int16_t const* src, float* vectors, std::size_t stride, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float x = std::fmax(src[i * 2 + 0] * (1.0f / 32767.0f), -1.0f);
+            float y = std::fmax(src[i * 2 + 1] * (1.0f / 32767.0f), -1.0f);
+            float z = 1.0f - std::abs(x) - std::abs(y);
+            float t = std::fmax(-z, 0.0f);
+            x += x >= 0.0f ? -t : t;
+            y += y >= 0.0f ? -t : t;
+
+            float inv_length = 1.0f / std::sqrt(x * x + y * y + z * z);
+            float* v = vectors + i * stride;
+            v[0] = x * inv_length;
+            v[1] = y * inv_length;
+            v[2] = z * inv_length;
+        }
+    }
+
+    void PackAffine(float const* matrices, float* result, std::size_t count, bool transpose)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float const* m = matrices + i * 16;
+            float* out = result + i * 12;
+            for (int r = 0; r < 3; ++r)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    out[r * 4 + c] = transpose ? m[c * 4 + r] : m[r * 4 + c];
+                }
+            }
+        }
+    }
+
+    void PackTrs(float const* translation, float const* rotation, float const* scale, std::size_t stride,
+                 float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            // Quaternion::ToMatrix with the scale applied to the columns
+            float const* t = translation + i * stride;
+            float const* q = rotation + i * stride;
+            float const* s = scale + i * stride;
+            float xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+            float xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+            float wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2];
+
+            float* out = result + i * 12;
+            out[0] = (1.0f - 2.0f * (yy + zz)) * s[0];
+            out[1] = 2.0f * (xy - wz) * s[1];
+            out[2] = 2.0f * (xz + wy) * s[2];
+            out[3] = t[0];
+            out[4] = 2.0f * (xy + wz) * s[0];
+            out[5] = (1.0f - 2.0f * (xx + zz)) * s[1];
+            out[6] = 2.0f * (yz - wx) * s[2];
+            out[7] = t[1];
+            out[8] = 2.0f * (xz - wy) * s[0];
+            out[9] = 2.0f * (yz + wx) * s[1];
+            out[10] = (1.0f - 2.0f * (xx + yy)) * s[2];
+            out[11] = t[2];
+        }
+    }
+
+    std::uint32_t Rotl(std::uint32_t x, int k)
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    // One xoshiro128** step of every stream
+    void NextRandomRound(std::uint32_t* state, std::uint32_t* result)
+    {
+        std::uint32_t* s0 = state;
+        std::uint32_t* s1 = state + kRandomStreams;
+        std::uint32_t* s2 = state + kRandomStreams * 2;
+        std::uint32_t* s3 = state + kRandomStreams * 3;
+        for (std::size_t k = 0; k < kRandomStreams; ++k)
+        {
+            result[k] = Rotl(s1[k] * 5u, 7) * 9u;
+            std::uint32_t t = s1[k] << 9;
+            s2[k] ^= s0[k];
+            s3[k] ^= s1[k];
+            s1[k] ^= s2[k];
+            s0[k] ^= s3[k];
+            s2[k] ^= t;
+            s3[k] = Rotl(s3[k], 11);
+        }
+    }
+
+    void RandomUint32(std::uint32_t* state, std::uint32_t* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += kRandomStreams)
+        {
+            std::uint32_t round[kRandomStreams];
+            NextRandomRound(state, round);
+            for (std::size_t k = 0; k < kRandomStreams && i + k < count; ++k)
+            {
+                result[i + k] = round[k];
+            }
+        }
+    }
+
+    void RandomFloat(std::uint32_t* state, float* result, std::size_t count, float min, float max)
+    {
+        float range = max - min;
+        for (std::size_t i = 0; i < count; i += kRandomStreams)
+        {
+            std::uint32_t round[kRandomStreams];
+            NextRandomRound(state, round);
+            for (std::size_t k = 0; k < kRandomStreams && i + k < count; ++k)
+            {
+                float unit = static_cast<float>(round[k] >> 8) * (1.0f / 16777216.0f);
+                result[i + k] = min + range * unit;
+            }
+        }
+    }
+
+    // Lattice hash without permutation tables so that SIMD versions don't need gathers
+    std::uint32_t HashLattice(std::int32_t x, std::int32_t y, std::int32_t z, std::uint32_t seed)
+    {
+        std::uint32_t h = seed + static_cast<std::uint32_t>(x) * 0x8da6b343u + static_cast<std::uint32_t>(y) * 0xd8163841u
+            + static_cast<std::uint32_t>(z) * 0xcb1ab31fu;
+        h ^= h >> 16;
+        h *= 0x7feb352du;
+        h ^= h >> 15;
+        h *= 0x846ca68bu;
+        h ^= h >> 16;
+        return h;
+    }
+
+    float Fade(float t)
+    {
+        return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+    }
+
+    float Lerp(float a, float b, float t)
+    {
+        return a + (b - a) * t;
+    }
+
+    // Perlin's 12 cube edge gradients, the last 4 hash values repeat some of them
+    float Gradient(std::uint32_t h, float x, float y, float z)
+    {
+        h &= 15u;
+        float u = h < 8u ? x : y;
+        float v = h < 4u ? y : (h == 12u || h == 14u ? x : z);
+        return ((h & 1u) != 0 ? -u : u) + ((h & 2u) != 0 ? -v : v);
+    }
+
+    template <bool kGradient>
+    float LatticeNoise(float x, float y, float z, std::uint32_t seed)
+    {
+        float fx = std::floor(x), fy = std::floor(y), fz = std::floor(z);
+        std::int32_t ix = static_cast<std::int32_t>(fx), iy = static_cast<std::int32_t>(fy), iz = static_cast<std::int32_t>(fz);
+        float tx = x - fx, ty = y - fy, tz = z - fz;
+
+        float corner[8];
+        for (int c = 0; c < 8; ++c)
+        {
+            int dx = c & 1, dy = (c >> 1) & 1, dz = c >> 2;
+            std::uint32_t h = HashLattice(ix + dx, iy + dy, iz + dz, seed);
+            corner[c] = kGradient ? Gradient(h, tx - dx, ty - dy, tz - dz) : static_cast<float>(h >> 8) * (1.0f / 8388608.0f) - 1.0f;
+        }
+
+        float u = Fade(tx), v = Fade(ty), w = Fade(tz);
+        float x00 = Lerp(corner[0], corner[1], u);
+        float x10 = Lerp(corner[2], corner[3], u);
+        float x01 = Lerp(corner[4], corner[5], u);
+        float x11 = Lerp(corner[6], corner[7], u);
+        return Lerp(Lerp(x00, x10, v), Lerp(x01, x11, v), w);
+    }
+
+    // Radius 0.5 instead of Gustavson's 0.6 keeps the kernels inside the neighbouring simplices,
+    // so the noise is continuous and ties in the traversal order don't change the result
+    float SimplexCorner(float x, float y, float z, std::uint32_t h)
+    {
+        float t = 0.5f - x * x - y * y - z * z;
+        t = t < 0.0f ? 0.0f : t;
+        t = t * t;
+        return t * t * Gradient(h, x, y, z);
+    }
+
+    float SimplexNoise(float x, float y, float z, std::uint32_t seed)
+    {
+        constexpr float kSkew = 1.0f / 3.0f;
+        constexpr float kUnskew = 1.0f / 6.0f;
+
+        float s = (x + y + z) * kSkew;
+        float fi = std::floor(x + s), fj = std::floor(y + s), fk = std::floor(z + s);
+        float t = (fi + fj + fk) * kUnskew;
+        float x0 = x - (fi - t), y0 = y - (fj - t), z0 = z - (fk - t);
+
+        // Branch free simplex traversal order, same cases as Gustavson's nested ifs
+        bool xy = x0 >= y0, yz = y0 >= z0, xz = x0 >= z0;
+        float i1 = xy && xz ? 1.0f : 0.0f;
+        float j1 = !xy && yz ? 1.0f : 0.0f;
+        float k1 = 1.0f - i1 - j1;
+        float i2 = xy || xz ? 1.0f : 0.0f;
+        float j2 = !xy || yz ? 1.0f : 0.0f;
+        float k2 = !yz || !xz ? 1.0f : 0.0f;
+
+        std::int32_t i = static_cast<std::int32_t>(fi), j = static_cast<std::int32_t>(fj), k = static_cast<std::int32_t>(fk);
+        float n = SimplexCorner(x0, y0, z0, HashLattice(i, j, k, seed));
+        n += SimplexCorner(x0 - i1 + kUnskew, y0 - j1 + kUnskew, z0 - k1 + kUnskew,
+            HashLattice(i + static_cast<std::int32_t>(i1), j + static_cast<std::int32_t>(j1), k + static_cast<std::int32_t>(k1), seed));
+        n += SimplexCorner(x0 - i2 + 2.0f * kUnskew, y0 - j2 + 2.0f * kUnskew, z0 - k2 + 2.0f * kUnskew,
+            HashLattice(i + static_cast<std::int32_t>(i2), j + static_cast<std::int32_t>(j2), k + static_cast<std::int32_t>(k2), seed));
+        n += SimplexCorner(x0 - 1.0f + 3.0f * kUnskew, y0 - 1.0f + 3.0f * kUnskew, z0 - 1.0f + 3.0f * kUnskew,
+            HashLattice(i + 1, j + 1, k + 1, seed));
+        // Measured maximum of the sum is about 0.013, scaled to roughly [-1, 1]
+        return 76.0f * n;
+    }
+
+    void Noise(NoiseType type, float const* x, float const* y, float const* z, std::uint32_t seed, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            switch (type)
+            {
+            case NoiseType::kValue: result[i] = LatticeNoise<false>(x[i], y[i], z[i], seed); break;
+            case NoiseType::kGradient: result[i] = LatticeNoise<true>(x[i], y[i], z[i], seed); break;
+            case NoiseType::kSimplex: result[i] = SimplexNoise(x[i], y[i], z[i], seed); break;
+            }
+        }
+    }
+
+    // Screen space triangle ready for rasterization. Edge i covers the pixel centers where
+    // edge_a[i] * (px - edge_x[i]) + edge_b[i] * (py - edge_y[i]) >= 0, depth is a plane through v0
+    struct DepthTriangle
+    {
+        float edge_a[3];
+        float edge_b[3];
+        float edge_x[3];
+        float edge_y[3];
+        float x0, y0, z0;
+        float dzdx, dzdy;
+        std::uint32_t min_x, max_x, min_y, max_y;
+    };
+
+    // Smallest integer >= value for value >= 0
+    std::uint32_t CeilToUint(float value)
+    {
+        std::uint32_t result = static_cast<std::uint32_t>(value);
+        return static_cast<float>(result) < value ? result + 1 : result;
+    }
+
+    // false for degenerate, NaN and off-screen triangles
+    bool SetupDepthTriangle(float const* v, std::uint32_t width, std::uint32_t height, DepthTriangle & t)
+    {
+        float x[3] = { v[0], v[3], v[6] };
+        float y[3] = { v[1], v[4], v[7] };
+        float z[3] = { v[2], v[5], v[8] };
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+        if (area < 0.0f)
+        {
+            // Flip to counter-clockwise in y-down coordinates so that inside is positive
+            float swap_x = x[1], swap_y = y[1], swap_z = z[1];
+            x[1] = x[2]; y[1] = y[2]; z[1] = z[2];
+            x[2] = swap_x; y[2] = swap_y; z[2] = swap_z;
+            area = -area;
+        }
+
+        if (!(area > 0.0f))
+        {
+            return false;
+        }
+
+        // Pixel centers in the bounding box, clamped to the buffer
+        float min_x = x[0] < x[1] ? (x[0] < x[2] ? x[0] : x[2]) : (x[1] < x[2] ? x[1] : x[2]);
+        float max_x = x[0] > x[1] ? (x[0] > x[2] ? x[0] : x[2]) : (x[1] > x[2] ? x[1] : x[2]);
+        float min_y = y[0] < y[1] ? (y[0] < y[2] ? y[0] : y[2]) : (y[1] < y[2] ? y[1] : y[2]);
+        float max_y = y[0] > y[1] ? (y[0] > y[2] ? y[0] : y[2]) : (y[1] > y[2] ? y[1] : y[2]);
+        float last_x = static_cast<float>(width - 1);
+        float last_y = static_cast<float>(height - 1);
+        min_x -= 0.5f; max_x -= 0.5f; min_y -= 0.5f; max_y -= 0.5f;
+        if (!(max_x >= 0.0f && max_y >= 0.0f && min_x <= last_x && min_y <= last_y))
+        {
+            return false;
+        }
+
+        t.min_x = CeilToUint(min_x > 0.0f ? min_x : 0.0f);
+        t.min_y = CeilToUint(min_y > 0.0f ? min_y : 0.0f);
+        t.max_x = static_cast<std::uint32_t>(max_x < last_x ? max_x : last_x);
+        t.max_y = static_cast<std::uint32_t>(max_y < last_y ? max_y : last_y);
+        if (t.min_x > t.max_x || t.min_y > t.max_y)
+        {
+            return false;
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            int j = i == 2 ? 0 : i + 1;
+            t.edge_a[i] = y[i] - y[j];
+            t.edge_b[i] = x[j] - x[i];
+            t.edge_x[i] = x[i];
+            t.edge_y[i] = y[i];
+        }
+
+        // Edge 2 is the barycentric of v1, edge 0 the one of v2
+        float inv_area = 1.0f / area;
+        t.x0 = x[0];
+        t.y0 = y[0];
+        t.z0 = z[0];
+        t.dzdx = (t.edge_a[2] * (z[1] - z[0]) + t.edge_a[0] * (z[2] - z[0])) * inv_area;
+        t.dzdy = (t.edge_b[2] * (z[1] - z[0]) + t.edge_b[0] * (z[2] - z[0])) * inv_area;
+        return true;
+    }
+
+    void RasterizeDepth(float const* triangles, std::size_t count, float* depth, std::uint32_t width, std::uint32_t height)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            DepthTriangle t;
+            if (!SetupDepthTriangle(triangles + i * 9, width, height, t))
+            {
+                continue;
+            }
+
+            for (std::uint32_t y = t.min_y; y <= t.max_y; ++y)
+            {
+                float py = static_cast<float>(y) + 0.5f;
+                float row_edge[3];
+                for (int e = 0; e < 3; ++e)
+                {
+                    row_edge[e] = t.edge_b[e] * (py - t.edge_y[e]);
+                }
+                float row_z = t.z0 + t.dzdy * (py - t.y0);
+
+                float* row = depth + static_cast<std::size_t>(y) * width;
+                for (std::uint32_t x = t.min_x; x <= t.max_x; ++x)
+                {
+                    float px = static_cast<float>(x) + 0.5f;
+                    bool inside = true;
+                    for (int e = 0; e < 3; ++e)
+                    {
+                        inside = inside && t.edge_a[e] * (px - t.edge_x[e]) + row_edge[e] >= 0.0f;
+                    }
+
+                    float z = row_z + t.dzdx * (px - t.x0);
+                    row[x] = inside && z < row[x] ? z : row[x];
+                }
+            }
+        }
+    }
+}
+
+void FillMathKernelsScalar(MathKernels & kernels)
+{
+    kernels.multiply_matrix = MultiplyMatrix;
+    kernels.invert_matrix = InvertMatrix;
+    kernels.invert_affine = InvertAffine;
+    kernels.invert_rigid = InvertRigid;
+    kernels.transform_points = TransformPoints;
+    kernels.transform_vectors = TransformVectors;
+    kernels.transform_points_soa = TransformPointsSoa;
+    kernels.multiply_matrices = MultiplyMatrices;
+    kernels.cull_spheres = CullSpheres;
+    kernels.cull_aabbs = CullAabbs;
+    kernels.cull_spheres_multi = CullSpheresMulti;
+    kernels.cull_aabbs_multi = CullAabbsMulti;
+    kernels.compute_bounds = ComputeBounds;
+    kernels.max_distance_sq = MaxDistanceSq;
+    kernels.transform_aabbs = TransformAabbs;
+    kernels.intersect_ray_aabbs = IntersectRayAabbs;
+    kernels.intersect_rays_aabb = IntersectRaysAabb;
+    kernels.intersect_ray_triangles = IntersectRayTriangles;
+    kernels.intersect_rays_triangle = IntersectRaysTriangle;
+    kernels.fast_sincos = FastSinCosArray;
+    kernels.fast_rsqrt = FastRsqrtArray;
+    kernels.fast_atan2 = FastAtan2Array;
+    kernels.fast_exp = FastExpArray;
+    kernels.fast_log = FastLogArray;
+    kernels.normalize_vectors = NormalizeVectors;
+    kernels.rotation_matrices = RotationMatrices;
+    kernels.float_to_half = FloatToHalfArray;
+    kernels.half_to_float = HalfToFloatArray;
+    kernels.float_to_norm = FloatToNorm;
+    kernels.norm_to_float = NormToFloat;
+    kernels.encode_octahedral = EncodeOctahedral;
+    kernels.decode_octahedral = DecodeOctahedral;
+    kernels.pack_affine = PackAffine;
+    kernels.pack_trs = PackTrs;
+    kernels.random_uint32 = RandomUint32;
+    kernels.random_float = RandomFloat;
+    kernels.noise = Noise;
+    kernels.rasterize_depth = RasterizeDepth;
+}
@@ -0,0 +1,1635 @@
+#include "math_kernels.hpp"
+
+#if CHAY_SIMD_X86
+#include <immintrin.h>
+
+namespace
+{
+    void MultiplyMatrix(float const* a, float const* b, float* result)
+    {
+        __m128 b0 = _mm_loadu_ps(b + 0);
+        __m128 b1 = _mm_loadu_ps(b + 4);
+        __m128 b2 = _mm_loadu_ps(b + 8);
+        __m128 b3 = _mm_loadu_ps(b + 12);
+
+        // Row i of the result is a linear combination of the rows of b
+        __m128 rows[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            __m128 row = _mm_mul_ps(_mm_set1_ps(a[i * 4 + 0]), b0);
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i * 4 + 1]), b1));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i * 4 + 2]), b2));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i * 4 + 3]), b3));
+            rows[i] = row;
+        }
+
+        for (int i = 0; i < 4; ++i)
+        {
+            _mm_storeu_ps(result + i * 4, rows[i]);
+        }
+    }
+
+    template <int X, int Y, int Z, int W>
+    __m128 Swizzle(__m128 v)
+    {
+        return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X));
+    }
+
+    template <int X, int Y, int Z, int W>
+    __m128 Shuffle(__m128 a, __m128 b)
+    {
+        return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+    }
+
+    // 2x2 row-major blocks stored as (m00, m01, m10, m11)
+    __m128 Mat2Mul(__m128 a, __m128 b)
+    {
+        return _mm_add_ps(_mm_mul_ps(a, Swizzle<0, 3, 0, 3>(b)),
+                          _mm_mul_ps(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+    }
+
+    // adj(a) * b
+    __m128 Mat2AdjMul(__m128 a, __m128 b)
+    {
+        return _mm_sub_ps(_mm_mul_ps(Swizzle<3, 3, 0, 0>(a), b),
+                          _mm_mul_ps(Swizzle<1, 1, 2, 2>(a), Swizzle<2, 3, 0, 1>(b)));
+    }
+
+    // a * adj(b)
+    __m128 Mat2MulAdj(__m128 a, __m128 b)
+    {
+        return _mm_sub_ps(_mm_mul_ps(a, Swizzle<3, 0, 3, 0>(b)),
+                          _mm_mul_ps(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+    }
+
+    // Block-wise cofactor inverse: M = [A B; C D] with 2x2 blocks, no branches or pivoting
+    void InvertMatrix(float const* m, float* result)
+    {
+        __m128 row0 = _mm_loadu_ps(m + 0);
+        __m128 row1 = _mm_loadu_ps(m + 4);
+        __m128 row2 = _mm_loadu_ps(m + 8);
+        __m128 row3 = _mm_loadu_ps(m + 12);
+
+        __m128 a = _mm_movelh_ps(row0, row1);
+        __m128 b = _mm_movehl_ps(row1, row0);
+        __m128 c = _mm_movelh_ps(row2, row3);
+        __m128 d = _mm_movehl_ps(row3, row2);
+
+        // (|A|, |B|, |C|, |D|)
+        __m128 det_sub = _mm_sub_ps(
+            _mm_mul_ps(Shuffle<0, 2, 0, 2>(row0, row2), Shuffle<1, 3, 1, 3>(row1, row3)),
+            _mm_mul_ps(Shuffle<1, 3, 1, 3>(row0, row2), Shuffle<0, 2, 0, 2>(row1, row3)));
+        __m128 det_a = Swizzle<0, 0, 0, 0>(det_sub);
+        __m128 det_b = Swizzle<1, 1, 1, 1>(det_sub);
+        __m128 det_c = Swizzle<2, 2, 2, 2>(det_sub);
+        __m128 det_d = Swizzle<3, 3, 3, 3>(det_sub);
+
+        __m128 d_c = Mat2AdjMul(d, c);
+        __m128 a_b = Mat2AdjMul(a, b);
+
+        // Adjugates of the blocks of the inverse
+        __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), Mat2Mul(b, d_c));
+        __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), Mat2Mul(c, a_b));
+        __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), Mat2MulAdj(d, a_b));
+        __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), Mat2MulAdj(a, d_c));
+
+        // |M| = |A||D| + |B||C| - tr(adj(A) B adj(D) C)
+        __m128 det_m = _mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c));
+        __m128 trace = _mm_mul_ps(a_b, Swizzle<0, 2, 1, 3>(d_c));
+        trace = _mm_hadd_ps(trace, trace);
+        trace = _mm_hadd_ps(trace, trace);
+        det_m = _mm_sub_ps(det_m, trace);
+
+        __m128 inv_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det_m);
+        x = _mm_mul_ps(x, inv_det);
+        y = _mm_mul_ps(y, inv_det);
+        z = _mm_mul_ps(z, inv_det);
+        w = _mm_mul_ps(w, inv_det);
+
+        // Adjugate swizzle folded into the store
+        _mm_storeu_ps(result + 0, Shuffle<3, 1, 3, 1>(x, y));
+        _mm_storeu_ps(result + 4, Shuffle<2, 0, 2, 0>(x, y));
+        _mm_storeu_ps(result + 8, Shuffle<3, 1, 3, 1>(z, w));
+        _mm_storeu_ps(result + 12, Shuffle<2, 0, 2, 0>(z, w));
+    }
+
+    // col0..col2 are the columns of the inverted 3x3 block with zero in w. Only muls,
+    // adds and shuffles: dot products would serialize on the high latency dpps
+    void CompleteAffineInverse(__m128 row0, __m128 row1, __m128 row2, __m128 row3,
+                               __m128 col0, __m128 col1, __m128 col2, float* result)
+    {
+        // -A^-1 c for the translation column c, which sits in w of the first three rows
+        __m128 t = _mm_mul_ps(Swizzle<3, 3, 3, 3>(row0), col0);
+        t = _mm_add_ps(t, _mm_mul_ps(Swizzle<3, 3, 3, 3>(row1), col1));
+        t = _mm_add_ps(t, _mm_mul_ps(Swizzle<3, 3, 3, 3>(row2), col2));
+        __m128 sign = _mm_set1_ps(-0.0f);
+        t = _mm_xor_ps(t, sign);
+        _MM_TRANSPOSE4_PS(col0, col1, col2, t);
+
+        // -r A^-1 for the translation row r. One of c and r is zero, so the rows above
+        // can be used as they are
+        __m128 last = _mm_mul_ps(Swizzle<0, 0, 0, 0>(row3), col0);
+        last = _mm_add_ps(last, _mm_mul_ps(Swizzle<1, 1, 1, 1>(row3), col1));
+        last = _mm_add_ps(last, _mm_mul_ps(Swizzle<2, 2, 2, 2>(row3), col2));
+        last = _mm_blend_ps(_mm_xor_ps(last, sign), _mm_set1_ps(1.0f), 0x8);
+
+        _mm_storeu_ps(result + 0, col0);
+        _mm_storeu_ps(result + 4, col1);
+        _mm_storeu_ps(result + 8, col2);
+        _mm_storeu_ps(result + 12, last);
+    }
+
+    // cross(a, b) from a, b and their yzx swizzles, so that the three cross products of
+    // a 3x3 block share the swizzles. w of the result is zero whatever the w of the inputs
+    __m128 CrossYzx(__m128 a, __m128 a_yzx, __m128 b, __m128 b_yzx)
+    {
+        __m128 zxy = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+        return Swizzle<1, 2, 0, 3>(zxy);
+    }
+
+    void InvertAffine(float const* m, float* result)
+    {
+        __m128 row0 = _mm_loadu_ps(m + 0);
+        __m128 row1 = _mm_loadu_ps(m + 4);
+        __m128 row2 = _mm_loadu_ps(m + 8);
+        __m128 row3 = _mm_loadu_ps(m + 12);
+
+        // Columns of the inverse are the cross products of the rows over the determinant
+        __m128 row0_yzx = Swizzle<1, 2, 0, 3>(row0);
+        __m128 row1_yzx = Swizzle<1, 2, 0, 3>(row1);
+        __m128 row2_yzx = Swizzle<1, 2, 0, 3>(row2);
+        __m128 col0 = CrossYzx(row1, row1_yzx, row2, row2_yzx);
+        __m128 col1 = CrossYzx(row2, row2_yzx, row0, row0_yzx);
+        __m128 col2 = CrossYzx(row0, row0_yzx, row1, row1_yzx);
+
+        // det = dot(row0, col0), the w product is zero
+        __m128 det = _mm_mul_ps(row0, col0);
+        det = _mm_add_ps(det, _mm_movehl_ps(det, det));
+        det = _mm_add_ss(det, Swizzle<1, 1, 1, 1>(det));
+        __m128 inv_det = Swizzle<0, 0, 0, 0>(_mm_div_ss(_mm_set_ss(1.0f), det));
+        col0 = _mm_mul_ps(col0, inv_det);
+        col1 = _mm_mul_ps(col1, inv_det);
+        col2 = _mm_mul_ps(col2, inv_det);
+
+        CompleteAffineInverse(row0, row1, row2, row3, col0, col1, col2, result);
+    }
+
+    void InvertRigid(float const* m, float* result)
+    {
+        __m128 row0 = _mm_loadu_ps(m + 0);
+        __m128 row1 = _mm_loadu_ps(m + 4);
+        __m128 row2 = _mm_loadu_ps(m + 8);
+        __m128 row3 = _mm_loadu_ps(m + 12);
+
+        // The inverse rotation is the transpose, so its columns are the rows
+        __m128 xyz_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        CompleteAffineInverse(row0, row1, row2, row3, _mm_and_ps(row0, xyz_mask), _mm_and_ps(row1, xyz_mask),
+                              _mm_and_ps(row2, xyz_mask), result);
+    }
+
+    // Columns of the upper 3x4 part of m, w is zero
+    void LoadColumns(float const* m, __m128 columns[4])
+    {
+        __m128 row0 = _mm_loadu_ps(m + 0);
+        __m128 row1 = _mm_loadu_ps(m + 4);
+        __m128 row2 = _mm_loadu_ps(m + 8);
+        __m128 row3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+        columns[0] = row0;
+        columns[1] = row1;
+        columns[2] = row2;
+        columns[3] = row3;
+    }
+
+    template <bool kTranslate>
+    void TransformFloat3(__m128 const columns[4], float const* points, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            __m128 r = _mm_mul_ps(columns[0], _mm_set1_ps(points[i * 3 + 0]));
+            r = _mm_add_ps(r, _mm_mul_ps(columns[1], _mm_set1_ps(points[i * 3 + 1])));
+            r = _mm_add_ps(r, _mm_mul_ps(columns[2], _mm_set1_ps(points[i * 3 + 2])));
+            if (kTranslate)
+            {
+                r = _mm_add_ps(r, columns[3]);
+            }
+
+            // Three floats, a full store would run past the end of the array
+            _mm_storel_pi(reinterpret_cast<__m64*>(result + i * 3), r);
+            _mm_store_ss(result + i * 3 + 2, _mm_movehl_ps(r, r));
+        }
+    }
+
+    void TransformPoints(float const* m, float const* points, float* result, std::size_t count)
+    {
+        __m128 columns[4];
+        LoadColumns(m, columns);
+        TransformFloat3<true>(columns, points, result, count);
+    }
+
+    void TransformVectors(float const* m, float const* vectors, float* result, std::size_t count)
+    {
+        __m128 columns[4];
+        LoadColumns(m, columns);
+        TransformFloat3<false>(columns, vectors, result, count);
+    }
+
+    void TransformPointsSoa(float const* m, float const* x, float const* y, float const* z,
+                            float* result_x, float* result_y, float* result_z, std::size_t count)
+    {
+        __m128 mm[12];
+        for (int i = 0; i < 12; ++i)
+        {
+            mm[i] = _mm_set1_ps(m[i]);
+        }
+
+        std::size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 px = _mm_loadu_ps(x + i);
+            __m128 py = _mm_loadu_ps(y + i);
+            __m128 pz = _mm_loadu_ps(z + i);
+            __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(mm[0], px), _mm_mul_ps(mm[1], py)), _mm_add_ps(_mm_mul_ps(mm[2], pz), mm[3]));
+            __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(mm[4], px), _mm_mul_ps(mm[5], py)), _mm_add_ps(_mm_mul_ps(mm[6], pz), mm[7]));
+            __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(mm[8], px), _mm_mul_ps(mm[9], py)), _mm_add_ps(_mm_mul_ps(mm[10], pz), mm[11]));
+            _mm_storeu_ps(result_x + i, rx);
+            _mm_storeu_ps(result_y + i, ry);
+            _mm_storeu_ps(result_z + i, rz);
+        }
+
+        for (; i < count; ++i)
+        {
+            float px = x[i];
+            float py = y[i];
+            float pz = z[i];
+            result_x[i] = m[0] * px + m[1] * py + m[2] * pz + m[3];
+            result_y[i] = m[4] * px + m[5] * py + m[6] * pz + m[7];
+            result_z[i] = m[8] * px + m[9] * py + m[10] * pz + m[11];
+        }
+    }
+
+    void MultiplyMatrices(float const* a, float const* b, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            MultiplyMatrix(a + i * 16, b + i * 16, result + i * 16);
+        }
+    }
+
+    // Local instead of std::abs, see the note on kernel includes in math_kernels.hpp
+    float Abs(float value)
+    {
+        return value < 0.0f ? -value : value;
+    }
+
+    std::uint8_t CullSphere(float const* planes, float x, float y, float z, float radius)
+    {
+        std::uint8_t result = kCullInside;
+        for (int i = 0; i < 6; ++i)
+        {
+            float const* plane = planes + i * 4;
+            float distance = plane[0] * x + plane[1] * y + plane[2] * z + plane[3];
+            if (distance < -radius)
+            {
+                return kCullOutside;
+            }
+
+            if (distance < radius)
+            {
+                result = kCullIntersect;
+            }
+        }
+
+        return result;
+    }
+
+    std::uint8_t CullAabb(float const* planes, float x, float y, float z, float ex, float ey, float ez)
+    {
+        // Projected radius of the box onto the plane normal
+        std::uint8_t result = kCullInside;
+        for (int i = 0; i < 6; ++i)
+        {
+            float const* plane = planes + i * 4;
+            float distance = plane[0] * x + plane[1] * y + plane[2] * z + plane[3];
+            float radius = Abs(plane[0]) * ex + Abs(plane[1]) * ey + Abs(plane[2]) * ez;
+            if (distance < -radius)
+            {
+                return kCullOutside;
+            }
+
+            if (distance < radius)
+            {
+                result = kCullIntersect;
+            }
+        }
+
+        return result;
+    }
+
+    // Outside and intersect lane masks of four bounds against all planes, radius is per lane
+    // for spheres and computed from the absolute plane normal for boxes
+    template <typename RadiusFunc>
+    void ClassifyPlanes4(float const* planes, __m128 x, __m128 y, __m128 z, RadiusFunc radius, int & outside, int & intersect)
+    {
+        __m128 outside_mask = _mm_setzero_ps();
+        __m128 intersect_mask = _mm_setzero_ps();
+        for (int i = 0; i < 6; ++i)
+        {
+            float const* plane = planes + i * 4;
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), x), _mm_mul_ps(_mm_set1_ps(plane[1]), y)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[2]), z), _mm_set1_ps(plane[3])));
+            __m128 r = radius(plane);
+            outside_mask = _mm_or_ps(outside_mask, _mm_cmplt_ps(_mm_add_ps(distance, r), _mm_setzero_ps()));
+            intersect_mask = _mm_or_ps(intersect_mask, _mm_cmplt_ps(distance, r));
+        }
+
+        outside = _mm_movemask_ps(outside_mask);
+        intersect = _mm_movemask_ps(intersect_mask);
+    }
+
+    // Outside lanes are also intersecting ones, so the result is inside minus both bits
+    void StoreCullResults(std::uint8_t* result, int outside, int intersect, int lane_count)
+    {
+        for (int lane = 0; lane < lane_count; ++lane)
+        {
+            result[lane] = static_cast<std::uint8_t>(kCullInside - ((intersect >> lane) & 1) - ((outside >> lane) & 1));
+        }
+    }
+
+    void CullSpheres(float const* planes, float const* x, float const* y, float const* z,
+                     float const* radius, std::uint8_t* result, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 r = _mm_loadu_ps(radius + i);
+            int outside, intersect;
+            ClassifyPlanes4(planes, _mm_loadu_ps(x + i), _mm_loadu_ps(y + i), _mm_loadu_ps(z + i),
+                            [r](float const*) { return r; }, outside, intersect);
+            StoreCullResults(result + i, outside, intersect, 4);
+        }
+
+        for (; i < count; ++i)
+        {
+            result[i] = CullSphere(planes, x[i], y[i], z[i], radius[i]);
+        }
+    }
+
+    void CullAabbs(float const* planes, float const* center_x, float const* center_y, float const* center_z,
+                   float const* extent_x, float const* extent_y, float const* extent_z,
+                   std::uint8_t* result, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 ex = _mm_loadu_ps(extent_x + i);
+            __m128 ey = _mm_loadu_ps(extent_y + i);
+            __m128 ez = _mm_loadu_ps(extent_z + i);
+            auto radius = [ex, ey, ez](float const* plane)
+            {
+                return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(Abs(plane[0])), ex), _mm_mul_ps(_mm_set1_ps(Abs(plane[1])), ey)),
+                                  _mm_mul_ps(_mm_set1_ps(Abs(plane[2])), ez));
+            };
+
+            int outside, intersect;
+            ClassifyPlanes4(planes, _mm_loadu_ps(center_x + i), _mm_loadu_ps(center_y + i), _mm_loadu_ps(center_z + i),
+                            radius, outside, intersect);
+            StoreCullResults(result + i, outside, intersect, 4);
+        }
+
+        for (; i < count; ++i)
+        {
+            result[i] = CullAabb(planes, center_x[i], center_y[i], center_z[i], extent_x[i], extent_y[i], extent_z[i]);
+        }
+    }
+
+    // Tail bounds of the multi-view kernels
+    std::uint32_t SphereVisibility(float const* planes, std::size_t view_count, float x, float y, float z, float radius)
+    {
+        std::uint32_t mask = 0;
+        for (std::size_t view = 0; view < view_count; ++view)
+        {
+            mask |= CullSphere(planes + view * 24, x, y, z, radius) != kCullOutside ? 1u << view : 0u;
+        }
+        return mask;
+    }
+
+    std::uint32_t AabbVisibility(float const* planes, std::size_t view_count, float x, float y, float z, float ex, float ey, float ez)
+    {
+        std::uint32_t mask = 0;
+        for (std::size_t view = 0; view < view_count; ++view)
+        {
+            mask |= CullAabb(planes + view * 24, x, y, z, ex, ey, ez) != kCullOutside ? 1u << view : 0u;
+        }
+        return mask;
+    }
+
+    // Visibility bits of four bounds against every view, the bounds stay in registers
+    // while the planes of all views stream past them
+    template <typename RadiusFunc>
+    __m128i Visibility4(float const* planes, std::size_t view_count, __m128 x, __m128 y, __m128 z, RadiusFunc radius)
+    {
+        __m128i visibility = _mm_setzero_si128();
+        for (std::size_t view = 0; view < view_count; ++view)
+        {
+            __m128 outside_mask = _mm_setzero_ps();
+            for (int i = 0; i < 6; ++i)
+            {
+                float const* plane = planes + view * 24 + i * 4;
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), x), _mm_mul_ps(_mm_set1_ps(plane[1]), y)),
+                                             _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[2]), z), _mm_set1_ps(plane[3])));
+                outside_mask = _mm_or_ps(outside_mask, _mm_cmplt_ps(_mm_add_ps(distance, radius(plane)), _mm_setzero_ps()));
+            }
+
+            visibility = _mm_or_si128(visibility, _mm_andnot_si128(_mm_castps_si128(outside_mask),
+                                                                   _mm_set1_epi32(static_cast<int>(1u << view))));
+        }
+
+        return visibility;
+    }
+
+    void CullSpheresMulti(float const* planes, std::size_t view_count, float const* x, float const* y, float const* z,
+                          float const* radius, std::uint32_t* visibility, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 r = _mm_loadu_ps(radius + i);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(visibility + i),
+                             Visibility4(planes, view_count, _mm_loadu_ps(x + i), _mm_loadu_ps(y + i), _mm_loadu_ps(z + i),
+                                         [r](float const*) { return r; }));
+        }
+
+        for (; i < count; ++i)
+        {
+            visibility[i] = SphereVisibility(planes, view_count, x[i], y[i], z[i], radius[i]);
+        }
+    }
+
+    void CullAabbsMulti(float const* planes, std::size_t view_count,
+                        float const* center_x, float const* center_y, float const* center_z,
+                        float const* extent_x, float const* extent_y, float const* extent_z,
+                        std::uint32_t* visibility, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 ex = _mm_loadu_ps(extent_x + i);
+            __m128 ey = _mm_loadu_ps(extent_y + i);
+            __m128 ez = _mm_loadu_ps(extent_z + i);
+            auto radius = [ex, ey, ez](float const* plane)
+            {
+                return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(Abs(plane[0])), ex), _mm_mul_ps(_mm_set1_ps(Abs(plane[1])), ey)),
+                                  _mm_mul_ps(_mm_set1_ps(Abs(plane[2])), ez));
+            };
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(visibility + i),
+                             Visibility4(planes, view_count, _mm_loadu_ps(center_x + i), _mm_loadu_ps(center_y + i),
+                                         _mm_loadu_ps(center_z + i), radius));
+        }
+
+        for (; i < count; ++i)
+        {
+            visibility[i] = AabbVisibility(planes, view_count, center_x[i], center_y[i], center_z[i],
+                                           extent_x[i], extent_y[i], extent_z[i]);
+        }
+    }
+
+    // x, y, z, 0 without touching memory past p[2]
+    __m128 LoadFloat3(float const* p)
+    {
+        return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<__m64 const*>(p)), _mm_load_ss(p + 2));
+    }
+
+    void StoreFloat3(float* p, __m128 v)
+    {
+        _mm_storel_pi(reinterpret_cast<__m64*>(p), v);
+        _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+    }
+
+    void ComputeBounds(float const* points, std::size_t stride, std::size_t count, float* min, float* max)
+    {
+        __m128 lower = _mm_set1_ps(3.402823466e+38f);
+        __m128 upper = _mm_set1_ps(-3.402823466e+38f);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            __m128 p = LoadFloat3(points + i * stride);
+            lower = _mm_min_ps(lower, p);
+            upper = _mm_max_ps(upper, p);
+        }
+
+        StoreFloat3(min, lower);
+        StoreFloat3(max, upper);
+    }
+
+    float MaxDistanceSq(float const* points, std::size_t stride, std::size_t count, float const* center)
+    {
+        __m128 c = LoadFloat3(center);
+        __m128 result = _mm_setzero_ps();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            __m128 d = _mm_sub_ps(LoadFloat3(points + i * stride), c);
+            result = _mm_max_ss(result, _mm_dp_ps(d, d, 0x71));
+        }
+
+        return _mm_cvtss_f32(result);
+    }
+
+    void TransformAabbs(float const* m, float const* boxes, float* result, std::size_t count)
+    {
+        __m128 columns[4];
+        LoadColumns(m, columns);
+        __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 abs_columns[3] =
+        {
+            _mm_and_ps(columns[0], abs_mask),
+            _mm_and_ps(columns[1], abs_mask),
+            _mm_and_ps(columns[2], abs_mask)
+        };
+
+        __m128 half = _mm_set1_ps(0.5f);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            __m128 lower = LoadFloat3(boxes + i * 6);
+            __m128 upper = LoadFloat3(boxes + i * 6 + 3);
+            __m128 center = _mm_mul_ps(_mm_add_ps(lower, upper), half);
+            __m128 extent = _mm_mul_ps(_mm_sub_ps(upper, lower), half);
+
+            __m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns[0], _mm_shuffle_ps(center, center, 0x00)),
+                                             _mm_mul_ps(columns[1], _mm_shuffle_ps(center, center, 0x55))),
+                                  _mm_add_ps(_mm_mul_ps(columns[2], _mm_shuffle_ps(center, center, 0xaa)), columns[3]));
+            __m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abs_columns[0], _mm_shuffle_ps(extent, extent, 0x00)),
+                                             _mm_mul_ps(abs_columns[1], _mm_shuffle_ps(extent, extent, 0x55))),
+                                  _mm_mul_ps(abs_columns[2], _mm_shuffle_ps(extent, extent, 0xaa)));
+            StoreFloat3(result + i * 6, _mm_sub_ps(c, e));
+            StoreFloat3(result + i * 6 + 3, _mm_add_ps(c, e));
+        }
+    }
+
+    constexpr float kParallelEpsilon = 1e-12f;
+
+    // 4 lanes starting at i, count - i may be less than 4 at the tail
+    __m128 LoadLanes(float const* data, std::size_t i, std::size_t lanes)
+    {
+        if (lanes == 4)
+        {
+            return _mm_loadu_ps(data + i);
+        }
+
+        float padded[4] = {};
+        for (std::size_t k = 0; k < lanes; ++k)
+        {
+            padded[k] = data[i + k];
+        }
+
+        return _mm_loadu_ps(padded);
+    }
+
+    void StoreLanes(float* data, std::size_t i, std::size_t lanes, __m128 value)
+    {
+        if (lanes == 4)
+        {
+            _mm_storeu_ps(data + i, value);
+            return;
+        }
+
+        float padded[4];
+        _mm_storeu_ps(padded, value);
+        for (std::size_t k = 0; k < lanes; ++k)
+        {
+            data[i + k] = padded[k];
+        }
+    }
+
+    __m128 SlabTest(__m128 const o[3], __m128 const inv[3], __m128 t_max, __m128 const lo[3], __m128 const hi[3])
+    {
+        __m128 t_near = _mm_setzero_ps();
+        __m128 t_far = t_max;
+        for (int c = 0; c < 3; ++c)
+        {
+            __m128 t0 = _mm_mul_ps(_mm_sub_ps(lo[c], o[c]), inv[c]);
+            __m128 t1 = _mm_mul_ps(_mm_sub_ps(hi[c], o[c]), inv[c]);
+            t_near = _mm_max_ps(t_near, _mm_min_ps(t0, t1));
+            t_far = _mm_min_ps(t_far, _mm_max_ps(t0, t1));
+        }
+
+        return _mm_blendv_ps(_mm_set1_ps(kRayMiss), t_near, _mm_cmple_ps(t_near, t_far));
+    }
+
+    void Cross(__m128 const a[3], __m128 const b[3], __m128 r[3])
+    {
+        r[0] = _mm_sub_ps(_mm_mul_ps(a[1], b[2]), _mm_mul_ps(a[2], b[1]));
+        r[1] = _mm_sub_ps(_mm_mul_ps(a[2], b[0]), _mm_mul_ps(a[0], b[2]));
+        r[2] = _mm_sub_ps(_mm_mul_ps(a[0], b[1]), _mm_mul_ps(a[1], b[0]));
+    }
+
+    __m128 Dot(__m128 const a[3], __m128 const b[3])
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])), _mm_mul_ps(a[2], b[2]));
+    }
+
+    __m128 MollerTrumbore(__m128 const o[3], __m128 const d[3], __m128 t_max, __m128 const v0[3], __m128 const v1[3], __m128 const v2[3], __m128 & u, __m128 & v)
+    {
+        __m128 e1[3], e2[3], s[3], p[3], q[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            e1[c] = _mm_sub_ps(v1[c], v0[c]);
+            e2[c] = _mm_sub_ps(v2[c], v0[c]);
+            s[c] = _mm_sub_ps(o[c], v0[c]);
+        }
+
+        Cross(d, e2, p);
+        __m128 det = Dot(e1, p);
+        __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+        u = _mm_mul_ps(Dot(s, p), inv_det);
+        Cross(s, e1, q);
+        v = _mm_mul_ps(Dot(d, q), inv_det);
+        __m128 t = _mm_mul_ps(Dot(e2, q), inv_det);
+
+        __m128 zero = _mm_setzero_ps();
+        __m128 abs_det = _mm_and_ps(det, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+        __m128 hit = _mm_and_ps(_mm_cmpgt_ps(abs_det, _mm_set1_ps(kParallelEpsilon)), _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero)));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)), _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmple_ps(t, t_max))));
+        return _mm_blendv_ps(_mm_set1_ps(kRayMiss), t, hit);
+    }
+
+    void IntersectRayAabbs(float const* ray, AabbArrays const& boxes, std::size_t count, float* t)
+    {
+        __m128 o[3], inv[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            o[c] = _mm_set1_ps(ray[c]);
+            inv[c] = _mm_set1_ps(1.0f / ray[3 + c]);
+        }
+        __m128 t_max = _mm_set1_ps(ray[6]);
+
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            __m128 lo[3], hi[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                lo[c] = LoadLanes(boxes.min_point[c], i, lanes);
+                hi[c] = LoadLanes(boxes.max_point[c], i, lanes);
+            }
+            StoreLanes(t, i, lanes, SlabTest(o, inv, t_max, lo, hi));
+        }
+    }
+
+    void IntersectRaysAabb(RayArrays const& rays, std::size_t count, float const* box, float* t)
+    {
+        __m128 lo[3], hi[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            lo[c] = _mm_set1_ps(box[c]);
+            hi[c] = _mm_set1_ps(box[3 + c]);
+        }
+
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            __m128 o[3], inv[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                o[c] = LoadLanes(rays.origin[c], i, lanes);
+                inv[c] = LoadLanes(rays.inv_direction[c], i, lanes);
+            }
+            StoreLanes(t, i, lanes, SlabTest(o, inv, LoadLanes(rays.t_max, i, lanes), lo, hi));
+        }
+    }
+
+    void IntersectRayTriangles(float const* ray, TriangleArrays const& triangles, std::size_t count,
+                               float* t, float* u, float* v)
+    {
+        __m128 o[3], d[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            o[c] = _mm_set1_ps(ray[c]);
+            d[c] = _mm_set1_ps(ray[3 + c]);
+        }
+        __m128 t_max = _mm_set1_ps(ray[6]);
+
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            __m128 v0[3], v1[3], v2[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                v0[c] = LoadLanes(triangles.v0[c], i, lanes);
+                v1[c] = LoadLanes(triangles.v1[c], i, lanes);
+                v2[c] = LoadLanes(triangles.v2[c], i, lanes);
+            }
+
+            __m128 hit_u, hit_v;
+            StoreLanes(t, i, lanes, MollerTrumbore(o, d, t_max, v0, v1, v2, hit_u, hit_v));
+            StoreLanes(u, i, lanes, hit_u);
+            StoreLanes(v, i, lanes, hit_v);
+        }
+    }
+
+    void IntersectRaysTriangle(RayArrays const& rays, std::size_t count, float const* triangle,
+                               float* t, float* u, float* v)
+    {
+        __m128 v0[3], v1[3], v2[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            v0[c] = _mm_set1_ps(triangle[c]);
+            v1[c] = _mm_set1_ps(triangle[3 + c]);
+            v2[c] = _mm_set1_ps(triangle[6 + c]);
+        }
+
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            __m128 o[3], d[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                o[c] = LoadLanes(rays.origin[c], i, lanes);
+                d[c] = LoadLanes(rays.direction[c], i, lanes);
+            }
+
+            __m128 hit_u, hit_v;
+            StoreLanes(t, i, lanes, MollerTrumbore(o, d, LoadLanes(rays.t_max, i, lanes), v0, v1, v2, hit_u, hit_v));
+            StoreLanes(u, i, lanes, hit_u);
+            StoreLanes(v, i, lanes, hit_v);
+        }
+    }
+
+    constexpr float kPi = 3.141592654f;
+    constexpr float kHalfPi = 1.570796327f;
+
+    __m128 CmpLt(__m128 a, __m128 b) { return _mm_cmplt_ps(a, b); }
+    __m128 CmpGt(__m128 a, __m128 b) { return _mm_cmpgt_ps(a, b); }
+
+    __m128 Round(__m128 x)
+    {
+        return _mm_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    }
+
+    void SinCos(__m128 x, __m128 & sin, __m128 & cos)
+    {
+        __m128 j = Round(_mm_mul_ps(x, _mm_set1_ps(kFastTwoOverPi)));
+        __m128 r = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(kFastPiOverTwo[0])));
+        r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(kFastPiOverTwo[1])));
+        r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(kFastPiOverTwo[2])));
+        __m128i quadrant = _mm_cvtps_epi32(j);
+
+        __m128 r2 = _mm_mul_ps(r, r);
+        __m128 s = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(kFastSin[0]), r2), _mm_set1_ps(kFastSin[1])), r2), _mm_set1_ps(kFastSin[2]));
+        s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+        __m128 c = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(kFastCos[0]), r2), _mm_set1_ps(kFastCos[1])), r2), _mm_set1_ps(kFastCos[2]));
+        c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), c));
+
+        // Odd quadrants swap sin and cos, bit 1 of the quadrant flips the signs
+        __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+        sin = _mm_blendv_ps(s, c, swap);
+        cos = _mm_blendv_ps(c, s, swap);
+        sin = _mm_xor_ps(sin, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30)));
+        cos = _mm_xor_ps(cos, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30)));
+    }
+
+    __m128 Rsqrt(__m128 x)
+    {
+        __m128 y = _mm_rsqrt_ps(x);
+        return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x), _mm_mul_ps(y, y))));
+    }
+
+    __m128 Atan2(__m128 y, __m128 x)
+    {
+        __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+        __m128 ax = _mm_andnot_ps(sign_mask, x);
+        __m128 ay = _mm_andnot_ps(sign_mask, y);
+        __m128 a = _mm_div_ps(_mm_min_ps(ax, ay), _mm_max_ps(_mm_max_ps(ax, ay), _mm_set1_ps(1e-30f)));
+        __m128 s = _mm_mul_ps(a, a);
+
+        __m128 p = _mm_set1_ps(kFastAtan[0]);
+        for (int i = 1; i < 8; ++i)
+        {
+            p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(kFastAtan[i]));
+        }
+
+        __m128 r = _mm_add_ps(a, _mm_mul_ps(_mm_mul_ps(a, s), p));
+        r = _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(kHalfPi), r), CmpGt(ay, ax));
+        r = _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(kPi), r), CmpLt(x, _mm_setzero_ps()));
+        return _mm_or_ps(r, _mm_and_ps(y, sign_mask));
+    }
+
+    __m128 Exp(__m128 x)
+    {
+        x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(kFastExpMin)), _mm_set1_ps(kFastExpMax));
+        __m128 n = Round(_mm_mul_ps(x, _mm_set1_ps(kFastLog2E)));
+        __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(kFastLn2[0]))), _mm_mul_ps(n, _mm_set1_ps(kFastLn2[1])));
+
+        __m128 p = _mm_set1_ps(kFastExp[0]);
+        for (int i = 1; i < 6; ++i)
+        {
+            p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(kFastExp[i]));
+        }
+
+        __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, r), r), r), _mm_set1_ps(1.0f));
+        __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23));
+        return _mm_mul_ps(y, scale);
+    }
+
+    __m128 Log(__m128 x)
+    {
+        __m128i bits = _mm_castps_si128(x);
+        __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f000000)));
+
+        __m128 small = CmpLt(m, _mm_set1_ps(kFastSqrtHalf));
+        e = _mm_sub_ps(e, _mm_and_ps(small, _mm_set1_ps(1.0f)));
+        m = _mm_sub_ps(_mm_add_ps(m, _mm_and_ps(small, m)), _mm_set1_ps(1.0f));
+
+        __m128 z = _mm_mul_ps(m, m);
+        __m128 p = _mm_set1_ps(kFastLog[0]);
+        for (int i = 1; i < 9; ++i)
+        {
+            p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(kFastLog[i]));
+        }
+
+        __m128 y = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, m), z), _mm_mul_ps(e, _mm_set1_ps(kFastLn2[1])));
+        y = _mm_sub_ps(y, _mm_mul_ps(_mm_set1_ps(0.5f), z));
+        return _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(e, _mm_set1_ps(kFastLn2[0])));
+    }
+
+    void FastSinCosArray(float const* x, float* sin, float* cos, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            __m128 s, c;
+            SinCos(LoadLanes(x, i, lanes), s, c);
+            StoreLanes(sin, i, lanes, s);
+            StoreLanes(cos, i, lanes, c);
+        }
+    }
+
+    void FastRsqrtArray(float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            StoreLanes(result, i, lanes, Rsqrt(LoadLanes(x, i, lanes)));
+        }
+    }
+
+    void FastAtan2Array(float const* y, float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            StoreLanes(result, i, lanes, Atan2(LoadLanes(y, i, lanes), LoadLanes(x, i, lanes)));
+        }
+    }
+
+    void FastExpArray(float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            StoreLanes(result, i, lanes, Exp(LoadLanes(x, i, lanes)));
+        }
+    }
+
+    void FastLogArray(float const* x, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            // Padding lanes are 0, which is outside the log domain but never stored
+            StoreLanes(result, i, lanes, Log(LoadLanes(x, i, lanes)));
+        }
+    }
+
+    void NormalizeVectors(float const* vectors, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            __m128 v = LoadFloat3(vectors + i * 3);
+            StoreFloat3(result + i * 3, _mm_mul_ps(v, Rsqrt(_mm_dp_ps(v, v, 0x7f))));
+        }
+    }
+
+    void RotationMatrices(float const* axes, float const* angles, float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            float axis[3][4] = {};
+            for (std::size_t k = 0; k < lanes; ++k)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    axis[c][k] = axes[(i + k) * 3 + c];
+                }
+            }
+
+            __m128 x = _mm_loadu_ps(axis[0]);
+            __m128 y = _mm_loadu_ps(axis[1]);
+            __m128 z = _mm_loadu_ps(axis[2]);
+            __m128 inv_length = Rsqrt(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+            x = _mm_mul_ps(x, inv_length);
+            y = _mm_mul_ps(y, inv_length);
+            z = _mm_mul_ps(z, inv_length);
+
+            __m128 s, c;
+            SinCos(LoadLanes(angles, i, lanes), s, c);
+            __m128 t = _mm_sub_ps(_mm_set1_ps(1.0f), c);
+            __m128 xt = _mm_mul_ps(x, t);
+            __m128 yt = _mm_mul_ps(y, t);
+            __m128 zt = _mm_mul_ps(z, t);
+
+            // Upper 3x3 in SoA, written out as full matrices per lane
+            float m[9][4];
+            _mm_storeu_ps(m[0], _mm_add_ps(_mm_mul_ps(xt, x), c));
+            _mm_storeu_ps(m[1], _mm_sub_ps(_mm_mul_ps(xt, y), _mm_mul_ps(z, s)));
+            _mm_storeu_ps(m[2], _mm_add_ps(_mm_mul_ps(xt, z), _mm_mul_ps(y, s)));
+            _mm_storeu_ps(m[3], _mm_add_ps(_mm_mul_ps(xt, y), _mm_mul_ps(z, s)));
+            _mm_storeu_ps(m[4], _mm_add_ps(_mm_mul_ps(yt, y), c));
+            _mm_storeu_ps(m[5], _mm_sub_ps(_mm_mul_ps(yt, z), _mm_mul_ps(x, s)));
+            _mm_storeu_ps(m[6], _mm_sub_ps(_mm_mul_ps(xt, z), _mm_mul_ps(y, s)));
+            _mm_storeu_ps(m[7], _mm_add_ps(_mm_mul_ps(yt, z), _mm_mul_ps(x, s)));
+            _mm_storeu_ps(m[8], _mm_add_ps(_mm_mul_ps(zt, z), c));
+
+            for (std::size_t k = 0; k < lanes; ++k)
+            {
+                float* out = result + (i + k) * 16;
+                out[0] = m[0][k]; out[1] = m[1][k]; out[2] = m[2][k];  out[3] = 0.0f;
+                out[4] = m[3][k]; out[5] = m[4][k]; out[6] = m[5][k];  out[7] = 0.0f;
+                out[8] = m[6][k]; out[9] = m[7][k]; out[10] = m[8][k]; out[11] = 0.0f;
+                out[12] = 0.0f;   out[13] = 0.0f;   out[14] = 0.0f;    out[15] = 1.0f;
+            }
+        }
+    }
+
+    // Lanes of a 4-wide slice at offset within a block that has lanes valid elements
+    std::size_t SliceLanes(std::size_t lanes, std::size_t offset)
+    {
+        return lanes > offset + 4 ? 4 : (lanes > offset ? lanes - offset : 0);
+    }
+
+    // Bit exact SSE version of the scalar half conversion, F16C is only assumed from AVX2 up
+    __m128i FloatToHalf(__m128 value)
+    {
+        __m128i bits = _mm_castps_si128(value);
+        __m128i sign = _mm_and_si128(bits, _mm_set1_epi32(static_cast<int>(0x80000000u)));
+        __m128i abs = _mm_xor_si128(bits, sign);
+
+        __m128i inf_nan = _mm_blendv_epi8(_mm_set1_epi32(0x7c00), _mm_set1_epi32(0x7e00),
+            _mm_cmpgt_epi32(abs, _mm_set1_epi32(0x7f800000)));
+
+        __m128i magic = _mm_set1_epi32(126 << 23);
+        __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(abs), _mm_castsi128_ps(magic))), magic);
+
+        __m128i mantissa_odd = _mm_and_si128(_mm_srli_epi32(abs, 13), _mm_set1_epi32(1));
+        __m128i normal = _mm_add_epi32(abs, _mm_set1_epi32(((15 - 127) * (1 << 23)) + 0xfff));
+        normal = _mm_srli_epi32(_mm_add_epi32(normal, mantissa_odd), 13);
+
+        __m128i result = _mm_blendv_epi8(normal, denormal, _mm_cmplt_epi32(abs, _mm_set1_epi32(0x38800000)));
+        result = _mm_blendv_epi8(result, inf_nan, _mm_cmpgt_epi32(abs, _mm_set1_epi32(0x477fffff)));
+        return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+    }
+
+    __m128 HalfToFloat(__m128i value)
+    {
+        __m128i bits = _mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0x7fff)), 13);
+        __m128i exponent = _mm_and_si128(bits, _mm_set1_epi32(0x7c00 << 13));
+        bits = _mm_add_epi32(bits, _mm_set1_epi32((127 - 15) << 23));
+
+        __m128i inf_nan = _mm_add_epi32(bits, _mm_set1_epi32((128 - 16) << 23));
+        __m128 denormal = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), _mm_set1_ps(6.10351562e-05f));
+
+        __m128i result = _mm_blendv_epi8(bits, inf_nan, _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7c00 << 13)));
+        result = _mm_blendv_epi8(result, _mm_castps_si128(denormal), _mm_cmpeq_epi32(exponent, _mm_setzero_si128()));
+        return _mm_castsi128_ps(_mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0x8000)), 16)));
+    }
+
+    void FloatToHalfArray(float const* src, std::uint16_t* dst, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            __m128i half = _mm_packus_epi32(FloatToHalf(LoadLanes(src, i, SliceLanes(lanes, 0))), FloatToHalf(LoadLanes(src, i + 4, SliceLanes(lanes, 4))));
+            if (lanes == 8)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), half);
+            }
+            else
+            {
+                alignas(16) std::uint16_t padded[8];
+                _mm_store_si128(reinterpret_cast<__m128i*>(padded), half);
+                for (std::size_t k = 0; k < lanes; ++k)
+                {
+                    dst[i + k] = padded[k];
+                }
+            }
+        }
+    }
+
+    void HalfToFloatArray(std::uint16_t const* src, float* dst, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            std::size_t lanes = count - i < 8 ? count - i : 8;
+            __m128i half;
+            if (lanes == 8)
+            {
+                half = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+            }
+            else
+            {
+                alignas(16) std::uint16_t padded[8] = {};
+                for (std::size_t k = 0; k < lanes; ++k)
+                {
+                    padded[k] = src[i + k];
+                }
+                half = _mm_load_si128(reinterpret_cast<__m128i const*>(padded));
+            }
+
+            StoreLanes(dst, i, SliceLanes(lanes, 0), HalfToFloat(_mm_cvtepu16_epi32(half)));
+            StoreLanes(dst, i + 4, SliceLanes(lanes, 4), HalfToFloat(_mm_cvtepu16_epi32(_mm_srli_si128(half, 8))));
+        }
+    }
+
+    // Clamp, scale and round to int32 with the current rounding mode (nearest even by default)
+    __m128i QuantizeNorm(__m128 value, __m128 lower, __m128 scale)
+    {
+        return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(value, lower), _mm_set1_ps(1.0f)), scale));
+    }
+
+    void FloatToNorm(NormFormat format, float const* src, void* dst, std::size_t count)
+    {
+        bool is_signed = format == NormFormat::kSnorm8 || format == NormFormat::kSnorm16;
+        bool is_wide = format == NormFormat::kSnorm16 || format == NormFormat::kUnorm16;
+        __m128 lower = _mm_set1_ps(is_signed ? -1.0f : 0.0f);
+        __m128 scale = _mm_set1_ps(is_signed ? (is_wide ? 32767.0f : 127.0f) : (is_wide ? 65535.0f : 255.0f));
+        std::size_t const element_size = is_wide ? 2 : 1;
+        std::uint8_t* out = static_cast<std::uint8_t*>(dst);
+
+        // 16 values per iteration, 8 and 16 bit results are packed with saturation, which is exact after the clamp
+        for (std::size_t i = 0; i < count; i += 16)
+        {
+            std::size_t lanes = count - i < 16 ? count - i : 16;
+            __m128i q[4];
+            for (std::size_t k = 0; k < 4; ++k)
+            {
+                std::size_t offset = k * 4;
+                q[k] = QuantizeNorm(LoadLanes(src, i + offset, SliceLanes(lanes, offset)), lower, scale);
+            }
+
+            __m128i packed[2] = { _mm_setzero_si128(), _mm_setzero_si128() };
+            switch (format)
+            {
+            case NormFormat::kSnorm8:
+                packed[0] = _mm_packs_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+                break;
+            case NormFormat::kUnorm8:
+                packed[0] = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+                break;
+            case NormFormat::kSnorm16:
+                packed[0] = _mm_packs_epi32(q[0], q[1]);
+                packed[1] = _mm_packs_epi32(q[2], q[3]);
+                break;
+            case NormFormat::kUnorm16:
+                packed[0] = _mm_packus_epi32(q[0], q[1]);
+                packed[1] = _mm_packus_epi32(q[2], q[3]);
+                break;
+            }
+
+            std::size_t bytes = lanes * element_size;
+            if (lanes == 16)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * element_size), packed[0]);
+                if (is_wide)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * element_size + 16), packed[1]);
+                }
+            }
+            else
+            {
+                alignas(16) std::uint8_t padded[32];
+                _mm_store_si128(reinterpret_cast<__m128i*>(padded), packed[0]);
+                _mm_store_si128(reinterpret_cast<__m128i*>(padded + 16), packed[1]);
+                for (std::size_t k = 0; k < bytes; ++k)
+                {
+                    out[i * element_size + k] = padded[k];
+                }
+            }
+        }
+    }
+
+    void NormToFloat(NormFormat format, void const* src, float* dst, std::size_t count)
+    {
+        bool is_signed = format == NormFormat::kSnorm8 || format == NormFormat::kSnorm16;
+        bool is_wide = format == NormFormat::kSnorm16 || format == NormFormat::kUnorm16;
+        __m128 lower = _mm_set1_ps(is_signed ? -1.0f : 0.0f);
+        __m128 inv_scale = _mm_set1_ps(1.0f / (is_signed ? (is_wide ? 32767.0f : 127.0f) : (is_wide ? 65535.0f : 255.0f)));
+        std::size_t const element_size = is_wide ? 2 : 1;
+        std::uint8_t const* in = static_cast<std::uint8_t const*>(src);
+
+        for (std::size_t i = 0; i < count; i += 16)
+        {
+            std::size_t lanes = count - i < 16 ? count - i : 16;
+            alignas(16) std::uint8_t padded[32] = {};
+            std::uint8_t const* block = in + i * element_size;
+            if (lanes < 16)
+            {
+                for (std::size_t k = 0; k < lanes * element_size; ++k)
+                {
+                    padded[k] = block[k];
+                }
+                block = padded;
+            }
+
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<__m128i const*>(block));
+            __m128i hi = is_wide ? _mm_loadu_si128(reinterpret_cast<__m128i const*>(block + 16)) : _mm_setzero_si128();
+            __m128i q[4];
+            switch (format)
+            {
+            case NormFormat::kSnorm8:
+                for (int k = 0; k < 4; ++k)
+                {
+                    q[k] = _mm_cvtepi8_epi32(lo);
+                    lo = _mm_srli_si128(lo, 4);
+                }
+                break;
+            case NormFormat::kUnorm8:
+                for (int k = 0; k < 4; ++k)
+                {
+                    q[k] = _mm_cvtepu8_epi32(lo);
+                    lo = _mm_srli_si128(lo, 4);
+                }
+                break;
+            case NormFormat::kSnorm16:
+                q[0] = _mm_cvtepi16_epi32(lo);
+                q[1] = _mm_cvtepi16_epi32(_mm_srli_si128(lo, 8));
+                q[2] = _mm_cvtepi16_epi32(hi);
+                q[3] = _mm_cvtepi16_epi32(_mm_srli_si128(hi, 8));
+                break;
+            case NormFormat::kUnorm16:
+                q[0] = _mm_cvtepu16_epi32(lo);
+                q[1] = _mm_cvtepu16_epi32(_mm_srli_si128(lo, 8));
+                q[2] = _mm_cvtepu16_epi32(hi);
+                q[3] = _mm_cvtepu16_epi32(_mm_srli_si128(hi, 8));
+                break;
+            }
+
+            for (std::size_t k = 0; k < 4; ++k)
+            {
+                std::size_t offset = k * 4;
+                __m128 value = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(q[k]), inv_scale), lower);
+                StoreLanes(dst, i + offset, SliceLanes(lanes, offset), value);
+            }
+        }
+    }
+
+    void PackAffine(float const* matrices, float* result, std::size_t count, bool transpose)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float const* m = matrices + i * 16;
+            float* out = result + i * 12;
+            __m128 r0 = _mm_loadu_ps(m + 0);
+            __m128 r1 = _mm_loadu_ps(m + 4);
+            __m128 r2 = _mm_loadu_ps(m + 8);
+            if (transpose)
+            {
+                __m128 r3 = _mm_loadu_ps(m + 12);
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            }
+
+            _mm_storeu_ps(out + 0, r0);
+            _mm_storeu_ps(out + 4, r1);
+            _mm_storeu_ps(out + 8, r2);
+        }
+    }
+
+    // Quaternion::ToMatrix with the scale applied to the columns, 4 lanes at a time
+    void PackTrs(float const* translation, float const* rotation, float const* scale, std::size_t stride,
+                 float* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            // Translation, rotation and scale components in SoA
+            float trs[10][4] = {};
+            for (std::size_t k = 0; k < lanes; ++k)
+            {
+                std::size_t offset = (i + k) * stride;
+                for (int c = 0; c < 3; ++c)
+                {
+                    trs[c][k] = translation[offset + c];
+                    trs[7 + c][k] = scale[offset + c];
+                }
+                for (int c = 0; c < 4; ++c)
+                {
+                    trs[3 + c][k] = rotation[offset + c];
+                }
+            }
+
+            __m128 x = _mm_loadu_ps(trs[3]), y = _mm_loadu_ps(trs[4]), z = _mm_loadu_ps(trs[5]), w = _mm_loadu_ps(trs[6]);
+            __m128 sx = _mm_loadu_ps(trs[7]), sy = _mm_loadu_ps(trs[8]), sz = _mm_loadu_ps(trs[9]);
+            __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+            __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+            __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+
+            float m[12][4];
+            _mm_storeu_ps(m[0], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx));
+            _mm_storeu_ps(m[1], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy));
+            _mm_storeu_ps(m[2], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz));
+            _mm_storeu_ps(m[4], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx));
+            _mm_storeu_ps(m[5], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy));
+            _mm_storeu_ps(m[6], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz));
+            _mm_storeu_ps(m[8], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx));
+            _mm_storeu_ps(m[9], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy));
+            _mm_storeu_ps(m[10], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz));
+
+            for (std::size_t k = 0; k < lanes; ++k)
+            {
+                float* out = result + (i + k) * 12;
+                out[0] = m[0][k]; out[1] = m[1][k]; out[2] = m[2][k];  out[3] = trs[0][k];
+                out[4] = m[4][k]; out[5] = m[5][k]; out[6] = m[6][k];  out[7] = trs[1][k];
+                out[8] = m[8][k]; out[9] = m[9][k]; out[10] = m[10][k]; out[11] = trs[2][k];
+            }
+        }
+    }
+
+    __m128 CmpGe(__m128 a, __m128 b) { return _mm_cmpge_ps(a, b); }
+
+    template <int kBits>
+    __m128i RotlLanes(__m128i x)
+    {
+        return _mm_or_si128(_mm_slli_epi32(x, kBits), _mm_srli_epi32(x, 32 - kBits));
+    }
+
+    // One xoshiro128** step of every stream, 4 streams per register
+    void NextRandomRound(std::uint32_t* state, std::uint32_t* result)
+    {
+        for (std::size_t k = 0; k < kRandomStreams; k += 4)
+        {
+            __m128i* s0 = reinterpret_cast<__m128i*>(state + k);
+            __m128i* s1 = reinterpret_cast<__m128i*>(state + kRandomStreams + k);
+            __m128i* s2 = reinterpret_cast<__m128i*>(state + kRandomStreams * 2 + k);
+            __m128i* s3 = reinterpret_cast<__m128i*>(state + kRandomStreams * 3 + k);
+            __m128i a = _mm_loadu_si128(s0), b = _mm_loadu_si128(s1), c = _mm_loadu_si128(s2), d = _mm_loadu_si128(s3);
+
+            __m128i r = _mm_mullo_epi32(RotlLanes<7>(_mm_mullo_epi32(b, _mm_set1_epi32(5))), _mm_set1_epi32(9));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(result + k), r);
+
+            __m128i t = _mm_slli_epi32(b, 9);
+            c = _mm_xor_si128(c, a);
+            d = _mm_xor_si128(d, b);
+            b = _mm_xor_si128(b, c);
+            a = _mm_xor_si128(a, d);
+            c = _mm_xor_si128(c, t);
+            d = RotlLanes<11>(d);
+
+            _mm_storeu_si128(s0, a);
+            _mm_storeu_si128(s1, b);
+            _mm_storeu_si128(s2, c);
+            _mm_storeu_si128(s3, d);
+        }
+    }
+
+    void RandomUint32(std::uint32_t* state, std::uint32_t* result, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i += kRandomStreams)
+        {
+            if (i + kRandomStreams <= count)
+            {
+                NextRandomRound(state, result + i);
+                continue;
+            }
+
+            std::uint32_t round[kRandomStreams];
+            NextRandomRound(state, round);
+            for (std::size_t k = 0; i + k < count; ++k)
+            {
+                result[i + k] = round[k];
+            }
+        }
+    }
+
+    void RandomFloat(std::uint32_t* state, float* result, std::size_t count, float min, float max)
+    {
+        __m128 base = _mm_set1_ps(min);
+        __m128 range = _mm_set1_ps(max - min);
+        for (std::size_t i = 0; i < count; i += kRandomStreams)
+        {
+            std::uint32_t round[kRandomStreams];
+            NextRandomRound(state, round);
+            for (std::size_t k = 0; k < kRandomStreams; k += 4)
+            {
+                std::size_t lanes = i + k >= count ? 0 : (count - i - k < 4 ? count - i - k : 4);
+                __m128i bits = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(round + k)), 8);
+                __m128 unit = _mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.0f / 16777216.0f));
+                StoreLanes(result, i + k, lanes, _mm_add_ps(base, _mm_mul_ps(range, unit)));
+            }
+        }
+    }
+
+    __m128i HashLattice(__m128i x, __m128i y, __m128i z, __m128i seed)
+    {
+        __m128i h = _mm_add_epi32(seed, _mm_mullo_epi32(x, _mm_set1_epi32(static_cast<int>(0x8da6b343u))));
+        h = _mm_add_epi32(h, _mm_mullo_epi32(y, _mm_set1_epi32(static_cast<int>(0xd8163841u))));
+        h = _mm_add_epi32(h, _mm_mullo_epi32(z, _mm_set1_epi32(static_cast<int>(0xcb1ab31fu))));
+        h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+        h = _mm_mullo_epi32(h, _mm_set1_epi32(0x7feb352d));
+        h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+        h = _mm_mullo_epi32(h, _mm_set1_epi32(static_cast<int>(0x846ca68bu)));
+        return _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+    }
+
+    __m128 Fade(__m128 t)
+    {
+        __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f));
+        return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+    }
+
+    __m128 LerpLanes(__m128 a, __m128 b, __m128 t)
+    {
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+    }
+
+    // Same gradient selection as the scalar version, negation is a sign flip
+    __m128 Gradient(__m128i h, __m128 x, __m128 y, __m128 z)
+    {
+        h = _mm_and_si128(h, _mm_set1_epi32(15));
+        __m128 u = _mm_blendv_ps(y, x, _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(8), h)));
+        __m128i use_x = _mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14)));
+        __m128 v = _mm_blendv_ps(z, x, _mm_castsi128_ps(use_x));
+        v = _mm_blendv_ps(v, y, _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(4), h)));
+        u = _mm_xor_ps(u, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31)));
+        v = _mm_xor_ps(v, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30)));
+        return _mm_add_ps(u, v);
+    }
+
+    template <bool kGradient>
+    __m128 LatticeNoise(__m128 x, __m128 y, __m128 z, __m128i seed)
+    {
+        __m128 fx = _mm_floor_ps(x), fy = _mm_floor_ps(y), fz = _mm_floor_ps(z);
+        __m128i ix = _mm_cvttps_epi32(fx), iy = _mm_cvttps_epi32(fy), iz = _mm_cvttps_epi32(fz);
+        __m128 tx = _mm_sub_ps(x, fx), ty = _mm_sub_ps(y, fy), tz = _mm_sub_ps(z, fz);
+
+        __m128 corner[8];
+        for (int c = 0; c < 8; ++c)
+        {
+            int dx = c & 1, dy = (c >> 1) & 1, dz = c >> 2;
+            __m128i h = HashLattice(_mm_add_epi32(ix, _mm_set1_epi32(dx)), _mm_add_epi32(iy, _mm_set1_epi32(dy)), _mm_add_epi32(iz, _mm_set1_epi32(dz)), seed);
+            if (kGradient)
+            {
+                corner[c] = Gradient(h, _mm_sub_ps(tx, _mm_set1_ps(static_cast<float>(dx))), _mm_sub_ps(ty, _mm_set1_ps(static_cast<float>(dy))),
+                    _mm_sub_ps(tz, _mm_set1_ps(static_cast<float>(dz))));
+            }
+            else
+            {
+                corner[c] = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h, 8)), _mm_set1_ps(1.0f / 8388608.0f)), _mm_set1_ps(1.0f));
+            }
+        }
+
+        __m128 u = Fade(tx), v = Fade(ty), w = Fade(tz);
+        __m128 x00 = LerpLanes(corner[0], corner[1], u);
+        __m128 x10 = LerpLanes(corner[2], corner[3], u);
+        __m128 x01 = LerpLanes(corner[4], corner[5], u);
+        __m128 x11 = LerpLanes(corner[6], corner[7], u);
+        return LerpLanes(LerpLanes(x00, x10, v), LerpLanes(x01, x11, v), w);
+    }
+
+    __m128 SimplexCorner(__m128 x, __m128 y, __m128 z, __m128i h)
+    {
+        __m128 t = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        t = _mm_max_ps(t, _mm_setzero_ps());
+        t = _mm_mul_ps(t, t);
+        return _mm_mul_ps(_mm_mul_ps(t, t), Gradient(h, x, y, z));
+    }
+
+    __m128 SimplexNoise(__m128 x, __m128 y, __m128 z, __m128i seed)
+    {
+        __m128 const skew = _mm_set1_ps(1.0f / 3.0f);
+        __m128 const unskew = _mm_set1_ps(1.0f / 6.0f);
+        __m128 const one = _mm_set1_ps(1.0f);
+
+        __m128 s = _mm_mul_ps(_mm_add_ps(_mm_add_ps(x, y), z), skew);
+        __m128 fi = _mm_floor_ps(_mm_add_ps(x, s)), fj = _mm_floor_ps(_mm_add_ps(y, s)), fk = _mm_floor_ps(_mm_add_ps(z, s));
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(fi, fj), fk), unskew);
+        __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(fi, t)), y0 = _mm_sub_ps(y, _mm_sub_ps(fj, t)), z0 = _mm_sub_ps(z, _mm_sub_ps(fk, t));
+
+        // Traversal order as masks, see the scalar version for the case analysis
+        __m128 xy = CmpGe(x0, y0), yz = CmpGe(y0, z0), xz = CmpGe(x0, z0);
+        __m128 i1 = _mm_and_ps(_mm_and_ps(xy, xz), one);
+        __m128 j1 = _mm_and_ps(_mm_andnot_ps(xy, yz), one);
+        __m128 k1 = _mm_sub_ps(_mm_sub_ps(one, i1), j1);
+        __m128 i2 = _mm_and_ps(_mm_or_ps(xy, xz), one);
+        __m128 j2 = _mm_andnot_ps(_mm_andnot_ps(yz, xy), one);
+        __m128 k2 = _mm_andnot_ps(_mm_and_ps(yz, xz), one);
+
+        __m128i i = _mm_cvttps_epi32(fi), j = _mm_cvttps_epi32(fj), k = _mm_cvttps_epi32(fk);
+        __m128 offset2 = _mm_set1_ps(2.0f * (1.0f / 6.0f));
+        __m128 offset3 = _mm_set1_ps(3.0f * (1.0f / 6.0f));
+        __m128 n = SimplexCorner(x0, y0, z0, HashLattice(i, j, k, seed));
+        n = _mm_add_ps(n, SimplexCorner(_mm_add_ps(_mm_sub_ps(x0, i1), unskew), _mm_add_ps(_mm_sub_ps(y0, j1), unskew), _mm_add_ps(_mm_sub_ps(z0, k1), unskew),
+            HashLattice(_mm_add_epi32(i, _mm_cvttps_epi32(i1)), _mm_add_epi32(j, _mm_cvttps_epi32(j1)), _mm_add_epi32(k, _mm_cvttps_epi32(k1)), seed)));
+        n = _mm_add_ps(n, SimplexCorner(_mm_add_ps(_mm_sub_ps(x0, i2), offset2), _mm_add_ps(_mm_sub_ps(y0, j2), offset2), _mm_add_ps(_mm_sub_ps(z0, k2), offset2),
+            HashLattice(_mm_add_epi32(i, _mm_cvttps_epi32(i2)), _mm_add_epi32(j, _mm_cvttps_epi32(j2)), _mm_add_epi32(k, _mm_cvttps_epi32(k2)), seed)));
+        __m128i one_i = _mm_set1_epi32(1);
+        n = _mm_add_ps(n, SimplexCorner(_mm_add_ps(_mm_sub_ps(x0, one), offset3), _mm_add_ps(_mm_sub_ps(y0, one), offset3), _mm_add_ps(_mm_sub_ps(z0, one), offset3),
+            HashLattice(_mm_add_epi32(i, one_i), _mm_add_epi32(j, one_i), _mm_add_epi32(k, one_i), seed)));
+        return _mm_mul_ps(_mm_set1_ps(76.0f), n);
+    }
+
+    void Noise(NoiseType type, float const* x, float const* y, float const* z, std::uint32_t seed, float* result, std::size_t count)
+    {
+        __m128i seed_lanes = _mm_set1_epi32(static_cast<int>(seed));
+        for (std::size_t i = 0; i < count; i += 4)
+        {
+            std::size_t lanes = count - i < 4 ? count - i : 4;
+            __m128 px = LoadLanes(x, i, lanes), py = LoadLanes(y, i, lanes), pz = LoadLanes(z, i, lanes);
+            __m128 value;
+            switch (type)
+            {
+            case NoiseType::kValue: value = LatticeNoise<false>(px, py, pz, seed_lanes); break;
+            case NoiseType::kGradient: value = LatticeNoise<true>(px, py, pz, seed_lanes); break;
+            default: value = SimplexNoise(px, py, pz, seed_lanes); break;
+            }
+            StoreLanes(result, i, lanes, value);
+        }
+    }
+
+    // Screen space triangle ready for rasterization. Edge i covers the pixel centers where
+    // edge_a[i] * (px - edge_x[i]) + edge_b[i] * (py - edge_y[i]) >= 0, depth is a plane through v0
+    struct DepthTriangle
+    {
+        float edge_a[3];
+        float edge_b[3];
+        float edge_x[3];
+        float edge_y[3];
+        float x0, y0, z0;
+        float dzdx, dzdy;
+        std::uint32_t min_x, max_x, min_y, max_y;
+    };
+
+    // Smallest integer >= value for value >= 0
+    std::uint32_t CeilToUint(float value)
+    {
+        std::uint32_t result = static_cast<std::uint32_t>(value);
+        return static_cast<float>(result) < value ? result + 1 : result;
+    }
+
+    // false for degenerate, NaN and off-screen triangles
+    bool SetupDepthTriangle(float const* v, std::uint32_t width, std::uint32_t height, DepthTriangle & t)
+    {
+        float x[3] = { v[0], v[3], v[6] };
+        float y[3] = { v[1], v[4], v[7] };
+        float z[3] = { v[2], v[5], v[8] };
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+        if (area < 0.0f)
+        {
+            // Flip to counter-clockwise in y-down coordinates so that inside is positive
+            float swap_x = x[1], swap_y = y[1], swap_z = z[1];
+            x[1] = x[2]; y[1] = y[2]; z[1] = z[2];
+            x[2] = swap_x; y[2] = swap_y; z[2] = swap_z;
+            area = -area;
+        }
+
+        if (!(area > 0.0f))
+        {
+            return false;
+        }
+
+        // Pixel centers in the bounding box, clamped to the buffer
+        float min_x = x[0] < x[1] ? (x[0] < x[2] ? x[0] : x[2]) : (x[1] < x[2] ? x[1] : x[2]);
+        float max_x = x[0] > x[1] ? (x[0] > x[2] ? x[0] : x[2]) : (x[1] > x[2] ? x[1] : x[2]);
+        float min_y = y[0] < y[1] ? (y[0] < y[2] ? y[0] : y[2]) : (y[1] < y[2] ? y[1] : y[2]);
+        float max_y = y[0] > y[1] ? (y[0] > y[2] ? y[0] : y[2]) : (y[1] > y[2] ? y[1] : y[2]);
+        float last_x = static_cast<float>(width - 1);
+        float last_y = static_cast<float>(height - 1);
+        min_x -= 0.5f; max_x -= 0.5f; min_y -= 0.5f; max_y -= 0.5f;
+        if (!(max_x >= 0.0f && max_y >= 0.0f && min_x <= last_x && min_y <= last_y))
+        {
+            return false;
+        }
+
+        t.min_x = CeilToUint(min_x > 0.0f ? min_x : 0.0f);
+        t.min_y = CeilToUint(min_y > 0.0f ? min_y : 0.0f);
+        t.max_x = static_cast<std::uint32_t>(max_x < last_x ? max_x : last_x);
+        t.max_y = static_cast<std::uint32_t>(max_y < last_y ? max_y : last_y);
+        if (t.min_x > t.max_x || t.min_y > t.max_y)
+        {
+            return false;
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            int j = i == 2 ? 0 : i + 1;
+            t.edge_a[i] = y[i] - y[j];
+            t.edge_b[i] = x[j] - x[i];
+            t.edge_x[i] = x[i];
+            t.edge_y[i] = y[i];
+        }
+
+        // Edge 2 is the barycentric of v1, edge 0 the one of v2
+        float inv_area = 1.0f / area;
+        t.x0 = x[0];
+        t.y0 = y[0];
+        t.z0 = z[0];
+        t.dzdx = (t.edge_a[2] * (z[1] - z[0]) + t.edge_a[0] * (z[2] - z[0])) * inv_area;
+        t.dzdy = (t.edge_b[2] * (z[1] - z[0]) + t.edge_b[0] * (z[2] - z[0])) * inv_area;
+        return true;
+    }
+
+    // Four pixels per step, the steps are aligned to four pixels so they never cross a row
+    void RasterizeDepth(float const* triangles, std::size_t count, float* depth, std::uint32_t width, std::uint32_t height)
+    {
+        __m128 lane_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            DepthTriangle t;
+            if (!SetupDepthTriangle(triangles + i * 9, width, height, t))
+            {
+                continue;
+            }
+
+            __m128 edge_a[3], edge_x[3];
+            for (int e = 0; e < 3; ++e)
+            {
+                edge_a[e] = _mm_set1_ps(t.edge_a[e]);
+                edge_x[e] = _mm_set1_ps(t.edge_x[e]);
+            }
+            __m128 dzdx = _mm_set1_ps(t.dzdx);
+            __m128 x0 = _mm_set1_ps(t.x0);
+            __m128 box_min = _mm_set1_ps(static_cast<float>(t.min_x) + 0.5f);
+            __m128 box_max = _mm_set1_ps(static_cast<float>(t.max_x) + 0.5f);
+
+            for (std::uint32_t y = t.min_y; y <= t.max_y; ++y)
+            {
+                float py = static_cast<float>(y) + 0.5f;
+                __m128 row_edge[3];
+                for (int e = 0; e < 3; ++e)
+                {
+                    row_edge[e] = _mm_set1_ps(t.edge_b[e] * (py - t.edge_y[e]));
+                }
+                __m128 row_z = _mm_set1_ps(t.z0 + t.dzdy * (py - t.y0));
+
+                float* row = depth + static_cast<std::size_t>(y) * width;
+                for (std::uint32_t x = t.min_x & ~3u; x <= t.max_x; x += 4)
+                {
+                    __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane_offsets);
+                    __m128 inside = _mm_and_ps(_mm_cmpge_ps(px, box_min), _mm_cmple_ps(px, box_max));
+                    for (int e = 0; e < 3; ++e)
+                    {
+                        __m128 edge = _mm_add_ps(_mm_mul_ps(edge_a[e], _mm_sub_ps(px, edge_x[e])), row_edge[e]);
+                        inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, _mm_setzero_ps()));
+                    }
+
+                    __m128 z = _mm_add_ps(row_z, _mm_mul_ps(dzdx, _mm_sub_ps(px, x0)));
+                    __m128 old = _mm_loadu_ps(row + x);
+                    _mm_storeu_ps(row + x, _mm_blendv_ps(old, _mm_min_ps(z, old), inside));
+                }
+            }
+        }
+    }
+}
+
+void FillMathKernelsSse41(MathKernels & kernels)
+{
+    kernels.multiply_matrix = MultiplyMatrix;
+    kernels.invert_matrix = InvertMatrix;
+    kernels.invert_affine = InvertAffine;
+    kernels.invert_rigid = InvertRigid;
+    kernels.transform_points = TransformPoints;
+    kernels.transform_vectors = TransformVectors;
+    kernels.transform_points_soa = TransformPointsSoa;
+    kernels.multiply_matrices = MultiplyMatrices;
+    kernels.cull_spheres = CullSpheres;
+    kernels.cull_aabbs = CullAabbs;
+    kernels.cull_spheres_multi = CullSpheresMulti;
+    kernels.cull_aabbs_multi = CullAabbsMulti;
+    kernels.compute_bounds = ComputeBounds;
+    kernels.max_distance_sq = MaxDistanceSq;
+    kernels.transform_aabbs = TransformAabbs;
+    kernels.intersect_ray_aabbs = IntersectRayAabbs;
+    kernels.intersect_rays_aabb = IntersectRaysAabb;
+    kernels.intersect_ray_triangles = IntersectRayTriangles;
+    kernels.intersect_rays_triangle = IntersectRaysTriangle;
+    kernels.fast_sincos = FastSinCosArray;
+    kernels.fast_rsqrt = FastRsqrtArray;
+    kernels.fast_atan2 = FastAtan2Array;
+    kernels.fast_exp = FastExpArray;
+    kernels.fast_log = FastLogArray;
+    kernels.normalize_vectors = NormalizeVectors;
+    kernels.rotation_matrices = RotationMatrices;
+    kernels.float_to_half = FloatToHalfArray;
+    kernels.half_to_float = HalfToFloatArray;
+    kernels.float_to_norm = FloatToNorm;
+    kernels.norm_to_float = NormToFloat;
+    kernels.pack_affine = PackAffine;
+    kernels.pack_trs = PackTrs;
+    kernels.random_uint32 = RandomUint32;
+    kernels.random_float = RandomFloat;
+    kernels.noise = Noise;
+    kernels.rasterize_depth = RasterizeDepth;
+}
+
+#endif // CHAY_SIMD_X86
@@ -1,8 +1,16 @@
 #ifndef MATHLIB_HPP
 #define MATHLIB_HPP
 
+#include "cpu_features.hpp"
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <limits>
+
+#if CHAY_SIMD_X86
+#include <immintrin.h>
+#endif
 
 const float MATH_PI = 3.141592654f;
 const float MATH_2PI = 6.283185307f;
@@ -13,36 +21,35 @@ const float MATH_PIDIV4 = 0.785398163f;
 
 struct float3
 {
-    float3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
-    float3(float val) : x(val), y(val), z(val) {}
-    float3() : x(0), y(0), z(0) {}
+    constexpr float3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+    constexpr float3(float val) : x(val), y(val), z(val) {}
+    constexpr float3() : x(0), y(0), z(0) {}
 
     float length() const { return sqrt(x*x + y*y + z*z); }
-    float3 normalize() const { return float3(x / length(), y / length(), z / length()); }
+    float3 normalize() const { float inv_length = 1.0f / length(); return float3(x * inv_length, y * inv_length, z * inv_length); }
 
     // Scalar operators
-    float3 operator+ (float scalar) { return float3(x + scalar, y + scalar, z + scalar); }
-    float3 operator- (float scalar) { return float3(x - scalar, y - scalar, z - scalar); }
-    float3 operator* (float scalar) { return float3(x * scalar, y * scalar, z * scalar); }
-    float3 operator/ (float scalar) { return float3(x / scalar, y / scalar, z / scalar); }
+    constexpr float3 operator+ (float scalar) const { return float3(x + scalar, y + scalar, z + scalar); }
+    constexpr float3 operator- (float scalar) const { return float3(x - scalar, y - scalar, z - scalar); }
+    constexpr float3 operator/ (float scalar) const { return float3(x / scalar, y / scalar, z / scalar); }
 
     // Vector operators
-    friend float3 operator+ (const float3 &lhs, const float3 &rhs) { return float3(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z); }
-    friend float3 operator- (const float3 &lhs, const float3 &rhs) { return float3(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z); }
+    friend constexpr float3 operator+ (const float3 &lhs, const float3 &rhs) { return float3(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z); }
+    friend constexpr float3 operator- (const float3 &lhs, const float3 &rhs) { return float3(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z); }
 
-    float3& operator+= (const float3 &other) { x += other.x; y += other.y; z += other.z; return *this; }
-    float3& operator*= (const float  &other) { x *= other;   y *= other;   z *= other;   return *this; }
-    float3& operator-= (const float3 &other) { x -= other.x; y -= other.y; z -= other.z; return *this; }
+    constexpr float3& operator+= (const float3 &other) { x += other.x; y += other.y; z += other.z; return *this; }
+    constexpr float3& operator*= (const float  &other) { x *= other;   y *= other;   z *= other;   return *this; }
+    constexpr float3& operator-= (const float3 &other) { x -= other.x; y -= other.y; z -= other.z; return *this; }
 
-    friend float3 operator- (const float3& vec) { return float3(-vec.x, -vec.y, -vec.z); }
+    friend constexpr float3 operator- (const float3& vec) { return float3(-vec.x, -vec.y, -vec.z); }
 
     //float operator[] (size_t i) const { return i == 0 ? x : (i == 1 ? y : z); }
-    float& operator[] (size_t i) { return i == 0 ? x : (i == 1 ? y : z); }
-    const float& operator[] (size_t i) const { return i == 0 ? x : (i == 1 ? y : z); }
+    constexpr float& operator[] (size_t i) { return i == 0 ? x : (i == 1 ? y : z); }
+    constexpr const float& operator[] (size_t i) const { return i == 0 ? x : (i == 1 ? y : z); }
 //    friend std::ostream& operator<< (std::ostream &os, const float3 &vec) { return os << "(" << vec.x << ", " << vec.y << ", " << vec.z << ")"; }
-    friend float3 operator* (const float3& a, float b) { return float3(a.x * b, a.y * b, a.z * b); }
+    friend constexpr float3 operator* (const float3& a, float b) { return float3(a.x * b, a.y * b, a.z * b); }
 
-    bool IsZero() const { return x == 0.0f && y == 0.0f && z == 0.0f; }
+    constexpr bool IsZero() const { return x == 0.0f && y == 0.0f && z == 0.0f; }
 
     float x, y, z;
 
@@ -52,58 +59,100 @@ private:
 
 };
 
-#define float3_aligned _declspec(align(16)) float3
+#define float3_aligned alignas(16) float3
+
+// 16-byte aligned vector, maps to a single SSE register
+struct alignas(16) float4
+{
+    constexpr float4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+    constexpr float4(const float3& xyz, float _w) : x(xyz.x), y(xyz.y), z(xyz.z), w(_w) {}
+    constexpr float4(float val) : x(val), y(val), z(val), w(val) {}
+    constexpr float4() : x(0), y(0), z(0), w(0) {}
+
+#if CHAY_SIMD_X86
+    // SIMD operators are runtime-only, the constructors and accessors are constexpr
+    float4(__m128 v) { _mm_store_ps(&x, v); }
+    __m128 simd() const { return _mm_load_ps(&x); }
+
+    friend float4 operator+ (const float4& lhs, const float4& rhs) { return float4(_mm_add_ps(lhs.simd(), rhs.simd())); }
+    friend float4 operator- (const float4& lhs, const float4& rhs) { return float4(_mm_sub_ps(lhs.simd(), rhs.simd())); }
+    friend float4 operator* (const float4& lhs, const float4& rhs) { return float4(_mm_mul_ps(lhs.simd(), rhs.simd())); }
+    friend float4 operator/ (const float4& lhs, const float4& rhs) { return float4(_mm_div_ps(lhs.simd(), rhs.simd())); }
+#else
+    friend float4 operator+ (const float4& lhs, const float4& rhs) { return float4(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z, lhs.w + rhs.w); }
+    friend float4 operator- (const float4& lhs, const float4& rhs) { return float4(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z, lhs.w - rhs.w); }
+    friend float4 operator* (const float4& lhs, const float4& rhs) { return float4(lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z, lhs.w * rhs.w); }
+    friend float4 operator/ (const float4& lhs, const float4& rhs) { return float4(lhs.x / rhs.x, lhs.y / rhs.y, lhs.z / rhs.z, lhs.w / rhs.w); }
+#endif
+
+    friend float4 operator* (const float4& a, float b) { return a * float4(b); }
+    float4& operator+= (const float4 &other) { return *this = *this + other; }
+    float4& operator-= (const float4 &other) { return *this = *this - other; }
+    float4& operator*= (float other) { return *this = *this * float4(other); }
+    friend constexpr float4 operator- (const float4& vec) { return float4(-vec.x, -vec.y, -vec.z, -vec.w); }
+
+    float& operator[] (size_t i) { return (&x)[i]; }
+    const float& operator[] (size_t i) const { return (&x)[i]; }
+
+    constexpr float3 xyz() const { return float3(x, y, z); }
+
+    float x, y, z, w;
+
+};
 
 struct float2
 {
-    float2(float x, float y) : x(x), y(y) {}
-    float2(float val) : x(val), y(val) {}
-    float2() : x(0), y(0) {}
+    constexpr float2(float x, float y) : x(x), y(y) {}
+    constexpr float2(float val) : x(val), y(val) {}
+    constexpr float2() : x(0), y(0) {}
 
     float length() const { return sqrt(x*x + y*y); }
-    float2 normalize() const { return float2(x / length(), y / length()); }
+    float2 normalize() const { float inv_length = 1.0f / length(); return float2(x * inv_length, y * inv_length); }
 
     // Scalar operators
-    float2 operator+ (float scalar) { return float2(x + scalar, y + scalar); }
-    float2 operator- (float scalar) { return float2(x - scalar, y - scalar); }
-    float2 operator* (float scalar) { return float2(x * scalar, y * scalar); }
-    float2 operator/ (float scalar) { return float2(x / scalar, y / scalar); }
+    constexpr float2 operator+ (float scalar) const { return float2(x + scalar, y + scalar); }
+    constexpr float2 operator- (float scalar) const { return float2(x - scalar, y - scalar); }
+    constexpr float2 operator* (float scalar) const { return float2(x * scalar, y * scalar); }
+    constexpr float2 operator/ (float scalar) const { return float2(x / scalar, y / scalar); }
 
     // Vector operators
-    float2 operator+ (const float2 &other) { return float2(x + other.x, y + other.y); }
-    float2 operator- (const float2 &other) { return float2(x - other.x, y - other.y); }
-    friend float2 operator+ (const float2 &lhs, const float2 &rhs) { return float2(lhs.x + rhs.x, lhs.y + rhs.y); }
-    friend float2 operator- (const float2 &lhs, const float2 &rhs) { return float2(lhs.x - rhs.x, lhs.y - rhs.y); }
+    friend constexpr float2 operator+ (const float2 &lhs, const float2 &rhs) { return float2(lhs.x + rhs.x, lhs.y + rhs.y); }
+    friend constexpr float2 operator- (const float2 &lhs, const float2 &rhs) { return float2(lhs.x - rhs.x, lhs.y - rhs.y); }
 
-    float2 operator+= (const float2 &other) { x += other.x; y += other.y; return *this; }
-    float2 operator*= (const float  &other) { x *= other;   y *= other;   return *this; }
-    float2 operator-= (const float2 &other) { x -= other.x; y -= other.y; return *this; }
+    constexpr float2& operator+= (const float2 &other) { x += other.x; y += other.y; return *this; }
+    constexpr float2& operator*= (const float  &other) { x *= other;   y *= other;   return *this; }
+    constexpr float2& operator-= (const float2 &other) { x -= other.x; y -= other.y; return *this; }
 
-    float2 operator- () { return float2(-x, -y); }
+    constexpr float2 operator- () const { return float2(-x, -y); }
 
-    float operator[] (size_t i) const { return i == 0 ? x : y; }
+    constexpr float operator[] (size_t i) const { return i == 0 ? x : y; }
     //float& operator[] (size_t i) { return i == 0 ? x : y; }
 
     float x, y;
 
 };
 
-inline float3 cross(const float3& a, const float3& b)
+constexpr float3 cross(const float3& a, const float3& b)
 {
     return float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
 }
 
-inline float dot(const float3& a, const float3& b)
+constexpr float dot(const float3& a, const float3& b)
 {
     return a.x * b.x + a.y * b.y + a.z * b.z;
 }
 
+constexpr float dot(const float4& a, const float4& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
 inline float distance(const float3& a, const float3& b)
 {
     return (b - a).length();
 }
 
-struct Matrix
+struct alignas(16) Matrix
 {
     static Matrix LookAtLH(const float3& eye, const float3& target, const float3& up = float3(0.0f, 0.0f, 1.0f));
     static Matrix LookAtRH(const float3& eye, const float3& target, const float3& up = float3(0.0f, 0.0f, 1.0f));
@@ -111,40 +160,78 @@ struct Matrix
     static Matrix PerspectiveFovRH(float fov, float aspect, float nearZ, float farZ);
     static Matrix OrthoLH(float width, float height, float nearZ, float farZ);
     static Matrix OrthoRH(float width, float height, float nearZ, float farZ);
-    static Matrix Zero();
-    static Matrix Identity();
-    static Matrix Translation(const float3& translation);
-    static Matrix Translation(float x, float y, float z);
     static Matrix RotationAxis(const float3& axis, float angle);
     static Matrix RotationAxisAroundPoint(const float3& axis, const float3& point, float angle);
-    static Matrix Scaling(float scalex, float scaley, float scalez);
 
-    // Constructors
-    Matrix() { memset(m, 0, sizeof(float) * 16); }
-    Matrix(float matrix[4][4]) { memcpy(m, matrix, sizeof(float) * 16); }
+    // Builders without transcendentals are constexpr and fold into read-only data
+    static constexpr Matrix Zero()
+    {
+        return Matrix();
+    }
+
+    static constexpr Matrix Identity()
+    {
+        return Matrix(1.0f, 0.0f, 0.0f, 0.0f,
+                      0.0f, 1.0f, 0.0f, 0.0f,
+                      0.0f, 0.0f, 1.0f, 0.0f,
+                      0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    static constexpr Matrix Translation(float x, float y, float z)
+    {
+        return Matrix(1.0f, 0.0f, 0.0f, x,
+                      0.0f, 1.0f, 0.0f, y,
+                      0.0f, 0.0f, 1.0f, z,
+                      0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    static constexpr Matrix Translation(const float3& translation)
+    {
+        return Translation(translation.x, translation.y, translation.z);
+    }
 
-    Matrix(float m00, float m01, float m02, float m03,
-           float m10, float m11, float m12, float m13,
-           float m20, float m21, float m22, float m23,
-           float m30, float m31, float m32, float m33)
+    static constexpr Matrix Scaling(float scalex, float scaley, float scalez)
     {
-        m[0][0] = m00; m[0][1] = m01; m[0][2] = m02; m[0][3] = m03;
-        m[1][0] = m10; m[1][1] = m11; m[1][2] = m12; m[1][3] = m13;
-        m[2][0] = m20; m[2][1] = m21; m[2][2] = m22; m[2][3] = m23;
-        m[3][0] = m30; m[3][1] = m31; m[3][2] = m32; m[3][3] = m33;
-    }    
-    
-    Matrix(const Matrix& other)
+        return Matrix(scalex, 0.0f, 0.0f, 0.0f,
+                      0.0f, scaley, 0.0f, 0.0f,
+                      0.0f, 0.0f, scalez, 0.0f,
+                      0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    // Constructors
+    constexpr Matrix() : m{} {}
+    constexpr Matrix(const float matrix[4][4]) : m{}
     {
-        m[0][0] = other.m[0][0]; m[0][1] = other.m[0][1]; m[0][2] = other.m[0][2]; m[0][3] = other.m[0][3];
-        m[1][0] = other.m[1][0]; m[1][1] = other.m[1][1]; m[1][2] = other.m[1][2]; m[1][3] = other.m[1][3];
-        m[2][0] = other.m[2][0]; m[2][1] = other.m[2][1]; m[2][2] = other.m[2][2]; m[2][3] = other.m[2][3];
-        m[3][0] = other.m[3][0]; m[3][1] = other.m[3][1]; m[3][2] = other.m[3][2]; m[3][3] = other.m[3][3];
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                m[i][j] = matrix[i][j];
+            }
+        }
     }
 
+    constexpr Matrix(float m00, float m01, float m02, float m03,
+                     float m10, float m11, float m12, float m13,
+                     float m20, float m21, float m22, float m23,
+                     float m30, float m31, float m32, float m33)
+        : m{ { m00, m01, m02, m03 },
+             { m10, m11, m12, m13 },
+             { m20, m21, m22, m23 },
+             { m30, m31, m32, m33 } }
+    {}
+
+    constexpr Matrix(const Matrix& other) = default;
+
     // Methods
+    // General inverse, works for any invertible matrix
     Matrix Inverse() const;
-    Matrix Transpose() const
+    // Cheaper inverse for matrices without projection: either the last row
+    // (Translation, RotationAxis, Scaling) or the last column (LookAt*, Ortho*) is 0 0 0 1
+    Matrix InverseAffine() const;
+    // Affine inverse for rotation + translation only, e.g. view matrices and unscaled transforms
+    Matrix InverseRigid() const;
+    constexpr Matrix Transpose() const
     {
         return Matrix(m[0][0], m[1][0], m[2][0], m[3][0],
                       m[0][1], m[1][1], m[2][1], m[3][1],
@@ -152,22 +239,319 @@ struct Matrix
                       m[0][3], m[1][3], m[2][3], m[3][3]);
     }
 
-    // Operators
-    Matrix operator*(const Matrix& other);
+    // Operators, matrix products run on the best SIMD kernel for this CPU
+    Matrix operator*(const Matrix& other) const;
     Matrix& operator*= (const Matrix& other);
-    float3  operator* (const float3& vec);
-    Matrix& operator= (const Matrix& other)
+    float3  operator* (const float3& vec) const;
+    constexpr Matrix& operator= (const Matrix& other) = default;
+
+    float m[4][4];
+};
+
+// Batched Matrix * float3 over whole arrays, result may alias the input
+void TransformPoints(const Matrix& m, const float3* points, float3* result, std::size_t count);
+// No translation, for directions. Normals need the inverse transpose of m unless it is rigid
+void TransformVectors(const Matrix& m, const float3* vectors, float3* result, std::size_t count);
+void TransformPointsSoA(const Matrix& m, const float* x, const float* y, const float* z,
+                        float* result_x, float* result_y, float* result_z, std::size_t count);
+// result[i] = a[i] * b[i], e.g. world = parent * local for a whole hierarchy level
+void MultiplyMatrices(const Matrix* a, const Matrix* b, Matrix* result, std::size_t count);
+
+// Affine matrix without the constant 0 0 0 1 row, 48 bytes per instance instead of 64.
+// Rows follow the Matrix::Translation convention with translation in the last column, a shader
+// gets the world position as float3(dot(m[0], p), dot(m[1], p), dot(m[2], p)) with p.w = 1
+struct alignas(16) Matrix3x4
+{
+    constexpr Matrix3x4() : m{} {}
+    // Drops the last row, which must be 0 0 0 1
+    explicit constexpr Matrix3x4(const Matrix& matrix)
+        : m{ { matrix.m[0][0], matrix.m[0][1], matrix.m[0][2], matrix.m[0][3] },
+             { matrix.m[1][0], matrix.m[1][1], matrix.m[1][2], matrix.m[1][3] },
+             { matrix.m[2][0], matrix.m[2][1], matrix.m[2][2], matrix.m[2][3] } } {}
+
+    constexpr Matrix ToMatrix() const
     {
-        m[0][0] = other.m[0][0]; m[0][1] = other.m[0][1]; m[0][2] = other.m[0][2]; m[0][3] = other.m[0][3];
-        m[1][0] = other.m[1][0]; m[1][1] = other.m[1][1]; m[1][2] = other.m[1][2]; m[1][3] = other.m[1][3];
-        m[2][0] = other.m[2][0]; m[2][1] = other.m[2][1]; m[2][2] = other.m[2][2]; m[2][3] = other.m[2][3];
-        m[3][0] = other.m[3][0]; m[3][1] = other.m[3][1]; m[3][2] = other.m[3][2]; m[3][3] = other.m[3][3];
-        return *this;
+        return Matrix(m[0][0], m[0][1], m[0][2], m[0][3],
+                      m[1][0], m[1][1], m[1][2], m[1][3],
+                      m[2][0], m[2][1], m[2][2], m[2][3],
+                      0.0f,    0.0f,    0.0f,    1.0f);
     }
 
-    float m[4][4];
+    float m[3][4];
+};
+
+// Batched packing for instance uploads, result can point straight into a mapped buffer.
+// PackAffine takes the Matrix::Translation convention (last row 0 0 0 1), PackAffineTransposed
+// the row vector one of LookAt* and Ortho* (last column 0 0 0 1)
+void PackAffine(const Matrix* matrices, Matrix3x4* result, std::size_t count);
+void PackAffineTransposed(const Matrix* matrices, Matrix3x4* result, std::size_t count);
+
+// Axis-aligned box. Empty() is inverted so that merging or growing it yields the other operand
+struct Aabb
+{
+    static constexpr Aabb Empty()
+    {
+        return Aabb(float3(std::numeric_limits<float>::max()), float3(-std::numeric_limits<float>::max()));
+    }
+
+    static constexpr Aabb FromCenterExtent(const float3& center, const float3& extent)
+    {
+        return Aabb(center - extent, center + extent);
+    }
+
+    constexpr Aabb(const float3& _min_point, const float3& _max_point) : min_point(_min_point), max_point(_max_point) {}
+    constexpr Aabb() : Aabb(Empty()) {}
+
+    constexpr bool IsEmpty() const
+    {
+        return min_point.x > max_point.x || min_point.y > max_point.y || min_point.z > max_point.z;
+    }
+
+    constexpr float3 GetCenter() const { return (min_point + max_point) * 0.5f; }
+    // Half size
+    constexpr float3 GetExtent() const { return (max_point - min_point) * 0.5f; }
+
+    constexpr bool Contains(const float3& point) const
+    {
+        return point.x >= min_point.x && point.y >= min_point.y && point.z >= min_point.z &&
+               point.x <= max_point.x && point.y <= max_point.y && point.z <= max_point.z;
+    }
+
+    constexpr bool Intersects(const Aabb& other) const
+    {
+        return min_point.x <= other.max_point.x && min_point.y <= other.max_point.y && min_point.z <= other.max_point.z &&
+               max_point.x >= other.min_point.x && max_point.y >= other.min_point.y && max_point.z >= other.min_point.z;
+    }
+
+    void Grow(const float3& point);
+    // Arvo's method, Matrix * float3 convention
+    Aabb Transform(const Matrix& m) const;
+
+    float3 min_point;
+    float3 max_point;
 };
 
+Aabb merge(const Aabb& a, const Aabb& b);
+
+// Bounds of count positions stride floats apart, e.g. the position of interleaved vertices
+Aabb ComputeBounds(const float* positions, std::size_t stride, std::size_t count);
+inline Aabb ComputeBounds(const float3* points, std::size_t count) { return ComputeBounds(&points->x, 3, count); }
+// Union of an array of boxes
+Aabb MergeBounds(const Aabb* boxes, std::size_t count);
+// result may alias boxes
+void TransformAabbs(const Matrix& m, const Aabb* boxes, Aabb* result, std::size_t count);
+
+struct BoundingSphere
+{
+    // Centered on the bounds of the points, not minimal but found with two SIMD passes
+    static BoundingSphere FromPoints(const float* positions, std::size_t stride, std::size_t count);
+    static BoundingSphere FromPoints(const float3* points, std::size_t count) { return FromPoints(&points->x, 3, count); }
+
+    constexpr BoundingSphere(const float3& _center, float _radius) : center(_center), radius(_radius) {}
+    constexpr BoundingSphere() : center(), radius(-1.0f) {}
+
+    constexpr bool IsEmpty() const { return radius < 0.0f; }
+    constexpr bool Contains(const float3& point) const
+    {
+        return dot(point - center, point - center) <= radius * radius;
+    }
+
+    // Radius is scaled by the largest axis scale of m
+    BoundingSphere Transform(const Matrix& m) const;
+    Aabb GetAabb() const { return Aabb::FromCenterExtent(center, float3(radius)); }
+
+    float3 center;
+    float radius;
+};
+
+BoundingSphere merge(const BoundingSphere& a, const BoundingSphere& b);
+
+// Oriented box: orthonormal axes and half extents along them
+struct Obb
+{
+    // Axes are the normalized columns of m, shear is not representable
+    static Obb FromAabb(const Aabb& aabb, const Matrix& m);
+
+    bool Contains(const float3& point) const;
+    Aabb GetAabb() const;
+
+    float3 center;
+    float3 extent;
+    float3 axes[3];
+};
+
+// Layout matches the single-ray input of the ray kernels in math_kernels.hpp,
+// which also have packet versions for many rays or many primitives at once
+struct Ray
+{
+    constexpr Ray(const float3& _origin, const float3& _direction, float _t_max = std::numeric_limits<float>::max())
+        : origin(_origin), direction(_direction), t_max(_t_max) {}
+
+    constexpr float3 At(float t) const { return origin + direction * t; }
+
+    float3 origin;
+    float3 direction;
+    float t_max;
+};
+
+// t is the entry distance, 0 when the ray starts inside the box
+bool IntersectRayAabb(const Ray& ray, const Aabb& aabb, float& t);
+// Two-sided, u and v are the barycentric weights of v1 and v2
+bool IntersectRayTriangle(const Ray& ray, const float3& v0, const float3& v1, const float3& v2, float& t, float& u, float& v);
+
+// Six planes (nx, ny, nz, d) with unit normals pointing inside, so dot(n, p) + d is the
+// signed distance of p. Order: left, right, bottom, top, near, far
+struct Frustum
+{
+    // view_projection uses the convention of LookAt* and Perspective*/Ortho*: row vectors,
+    // clip = p * view_projection, depth in [0, 1]. Transpose() other matrices first
+    static Frustum FromViewProjection(const Matrix& view_projection);
+
+    float4 planes[6];
+};
+
+// Classify SoA bounds against the frustum, result[i] is one of kCullOutside,
+// kCullIntersect or kCullInside from math_kernels.hpp
+void CullSpheres(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius,
+                 std::uint8_t* result, std::size_t count);
+// Boxes are given by center and half extents
+void CullAabbs(const Frustum& frustum, const float* center_x, const float* center_y, const float* center_z,
+               const float* extent_x, const float* extent_y, const float* extent_z,
+               std::uint8_t* result, std::size_t count);
+// Several views in one pass over the bounds, e.g. the main camera and shadow cascades.
+// Bit v of visibility[i] is set unless bound i is outside frusta[v]. Throws unless there are
+// 1 to kMaxCullViews frusta
+void CullSpheres(const Frustum* frusta, std::size_t frustum_count, const float* x, const float* y, const float* z,
+                 const float* radius, std::uint32_t* visibility, std::size_t count);
+void CullAabbs(const Frustum* frusta, std::size_t frustum_count,
+               const float* center_x, const float* center_y, const float* center_z,
+               const float* extent_x, const float* extent_y, const float* extent_z,
+               std::uint32_t* visibility, std::size_t count);
+
+// Unit quaternion rotation, (x, y, z) is the vector part. Rotates the same way as
+// Matrix::RotationAxis, so ToMatrix() of FromAxisAngle(axis, angle) matches it.
+// Not 16-byte aligned on purpose so that TrsTransform stays 40 bytes
+struct Quaternion
+{
+    static constexpr Quaternion Identity() { return Quaternion(0.0f, 0.0f, 0.0f, 1.0f); }
+    static Quaternion FromAxisAngle(const float3& axis, float angle);
+
+    constexpr Quaternion(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+    constexpr Quaternion() : x(0), y(0), z(0), w(1) {}
+
+    // Applies other first, then this
+    friend Quaternion operator* (const Quaternion& lhs, const Quaternion& rhs)
+    {
+#if CHAY_SIMD_X86
+        __m128 a = _mm_loadu_ps(&lhs.x);
+        __m128 b = _mm_loadu_ps(&rhs.x);
+        __m128 result = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b);
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)),
+            _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3)), _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f))));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)),
+            _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2)), _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f))));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)),
+            _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1)), _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f))));
+        Quaternion q;
+        _mm_storeu_ps(&q.x, result);
+        return q;
+#else
+        return Quaternion(lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
+                          lhs.w * rhs.y - lhs.x * rhs.z + lhs.y * rhs.w + lhs.z * rhs.x,
+                          lhs.w * rhs.z + lhs.x * rhs.y - lhs.y * rhs.x + lhs.z * rhs.w,
+                          lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z);
+#endif
+    }
+
+    Quaternion& operator*= (const Quaternion& other) { return *this = *this * other; }
+
+    constexpr Quaternion Conjugate() const { return Quaternion(-x, -y, -z, w); }
+    // Conjugate is enough for unit quaternions
+    Quaternion Inverse() const
+    {
+        float inv_length_sq = 1.0f / (x * x + y * y + z * z + w * w);
+        return Quaternion(-x * inv_length_sq, -y * inv_length_sq, -z * inv_length_sq, w * inv_length_sq);
+    }
+
+    float length() const { return std::sqrt(x * x + y * y + z * z + w * w); }
+    Quaternion normalize() const
+    {
+        float inv_length = 1.0f / length();
+        return Quaternion(x * inv_length, y * inv_length, z * inv_length, w * inv_length);
+    }
+
+    // q * v * q^-1 for a unit quaternion, without building a matrix
+    constexpr float3 Rotate(const float3& v) const
+    {
+        float3 u(x, y, z);
+        float3 t = cross(u, v) * 2.0f;
+        return v + t * w + cross(u, t);
+    }
+
+    Matrix ToMatrix() const;
+
+    float x, y, z, w;
+};
+
+constexpr float dot(const Quaternion& a, const Quaternion& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+// Component-wise lerp along the shortest arc, not normalized
+Quaternion lerp(const Quaternion& a, const Quaternion& b, float t);
+// Normalized lerp: cheap, constant direction but not constant angular speed
+Quaternion nlerp(const Quaternion& a, const Quaternion& b, float t);
+// Constant angular speed, falls back to nlerp for nearly equal rotations
+Quaternion slerp(const Quaternion& a, const Quaternion& b, float t);
+
+// Decomposed transform: scale, then rotate, then translate.
+// 40 bytes instead of 64 for a Matrix and cheap to interpolate.
+// Non-uniform scale combined with rotation can't be represented exactly after
+// composition or inversion, the usual scale-times-scale approximation is used
+struct TrsTransform
+{
+    static constexpr TrsTransform Identity() { return TrsTransform(); }
+
+    constexpr TrsTransform(const float3& _translation, const Quaternion& _rotation, const float3& _scale)
+        : translation(_translation), rotation(_rotation), scale(_scale) {}
+    constexpr TrsTransform() : translation(0.0f), rotation(), scale(1.0f) {}
+
+    constexpr float3 TransformPoint(const float3& point) const
+    {
+        return translation + rotation.Rotate(float3(point.x * scale.x, point.y * scale.y, point.z * scale.z));
+    }
+
+    // parent * child applies child first, e.g. world = parent_world * local
+    friend TrsTransform operator* (const TrsTransform& parent, const TrsTransform& child)
+    {
+        return TrsTransform(parent.TransformPoint(child.translation),
+                            parent.rotation * child.rotation,
+                            float3(parent.scale.x * child.scale.x, parent.scale.y * child.scale.y, parent.scale.z * child.scale.z));
+    }
+
+    TrsTransform Inverse() const
+    {
+        float3 inv_scale(1.0f / scale.x, 1.0f / scale.y, 1.0f / scale.z);
+        Quaternion inv_rotation = rotation.Conjugate();
+        float3 t = inv_rotation.Rotate(-translation);
+        return TrsTransform(float3(t.x * inv_scale.x, t.y * inv_scale.y, t.z * inv_scale.z), inv_rotation, inv_scale);
+    }
+
+    // Same convention as Matrix::Translation: translation ends up in the last column
+    Matrix ToMatrix() const;
+
+    float3 translation;
+    Quaternion rotation;
+    float3 scale;
+};
+
+// Same as TrsTransform::ToMatrix packed to 3x4, without building the 4x4 matrices
+void PackAffine(const TrsTransform* transforms, Matrix3x4* result, std::size_t count);
+
+// Translation and scale are lerped, rotation uses nlerp
+TrsTransform lerp(const TrsTransform& a, const TrsTransform& b, float t);
+
 template <typename T>
 inline T clamp(T value, T min, T max)
 {
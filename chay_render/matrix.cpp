@@ -1,6 +1,5 @@
 #include "mathlib.hpp"
-#include <cstring>
-#include <algorithm>
+#include "math_kernels.hpp"
 
 Matrix Matrix::LookAtLH(const float3& eye, const float3& target, const float3& up)
 {
@@ -28,7 +27,7 @@ Matrix Matrix::LookAtRH(const float3& eye, const float3& target, const float3& u
 
 Matrix Matrix::PerspectiveFovLH(float fov, float aspect, float nearZ, float farZ)
 {
-    float h = 1.0f / std::tanf(0.5f * fov);
+    float h = 1.0f / std::tan(0.5f * fov);
     float w = h / aspect;
     float range = farZ / (farZ - nearZ);
 
@@ -41,7 +40,7 @@ Matrix Matrix::PerspectiveFovLH(float fov, float aspect, float nearZ, float farZ
 
 Matrix Matrix::PerspectiveFovRH(float fov, float aspect, float nearZ, float farZ)
 {
-    float h = 1.0f / std::tanf(0.5f * fov);
+    float h = 1.0f / std::tan(0.5f * fov);
     float w = h / aspect;
     float range = farZ / (nearZ - farZ);
 
@@ -72,27 +71,10 @@ Matrix Matrix::OrthoRH(float width, float height, float nearZ, float farZ)
         0.0f, 0.0f, range * nearZ, 1.0f);
 }
 
-Matrix Matrix::Zero()
-{
-    return Matrix(0.0f, 0.0f, 0.0f, 0.0f,
-                  0.0f, 0.0f, 0.0f, 0.0f,
-                  0.0f, 0.0f, 0.0f, 0.0f,
-                  0.0f, 0.0f, 0.0f, 0.0f);
-}
-
-
-Matrix Matrix::Identity()
-{
-    return Matrix(1.0f, 0.0f, 0.0f, 0.0f,
-                  0.0f, 1.0f, 0.0f, 0.0f,
-                  0.0f, 0.0f, 1.0f, 0.0f,
-                  0.0f, 0.0f, 0.0f, 1.0f);
-}
-
 Matrix Matrix::RotationAxis(const float3& axis, float angle)
 {
-    float cosAngle = std::cosf(angle);
-    float sinAngle = std::sinf(angle);
+    float cosAngle = std::cos(angle);
+    float sinAngle = std::sin(angle);
     float3 a = axis.normalize();
 
     Matrix result;
@@ -123,31 +105,6 @@ Matrix Matrix::RotationAxisAroundPoint(const float3& axis, const float3& point,
     return Matrix::Translation(point) * Matrix::RotationAxis(axis, angle) * Matrix::Translation(-point);
 }
 
-Matrix Matrix::Translation(float x, float y, float z)
-{
-    return Matrix(1.0f, 0.0f, 0.0f, x,
-        0.0f, 1.0f, 0.0f, y,
-        0.0f, 0.0f, 1.0f, z,
-        0.0f, 0.0f, 0.0f, 1.0f);
-}
-
-Matrix Matrix::Translation(const float3& translation)
-{
-    return Matrix(1.0f, 0.0f, 0.0f, translation.x,
-        0.0f, 1.0f, 0.0f, translation.y,
-        0.0f, 0.0f, 1.0f, translation.z,
-        0.0f, 0.0f, 0.0f, 1.0f);
-}
-
-
-Matrix Matrix::Scaling(float scalex, float scaley, float scalez)
-{
-    return Matrix(scalex, 0.0f, 0.0f, 0.0f,
-        0.0f, scaley, 0.0f, 0.0f,
-        0.0f, 0.0f, scalez, 0.0f,
-        0.0f, 0.0f, 0.0f, 1.0f);
-}
-
 
 /*
 float x = M1.m[0][0];
@@ -186,75 +143,21 @@ mResult.m[3][2] = (M2.m[0][2] * x) + (M2.m[1][2] * y) + (M2.m[2][2] * z) + (M2.m
 mResult.m[3][3] = (M2.m[0][3] * x) + (M2.m[1][3] * y) + (M2.m[2][3] * z) + (M2.m[3][3] * w);
 */
 
-Matrix Matrix::operator*(const Matrix& other)
+Matrix Matrix::operator*(const Matrix& other) const
 {
     Matrix result;
-    float x = m[0][0];
-    float y = m[0][1];
-    float z = m[0][2];
-    float w = m[0][3];
-    // Perform the operation on the first row
-    result.m[0][0] = (other.m[0][0] * x) + (other.m[1][0] * y) + (other.m[2][0] * z) + (other.m[3][0] * w);
-    result.m[0][1] = (other.m[0][1] * x) + (other.m[1][1] * y) + (other.m[2][1] * z) + (other.m[3][1] * w);
-    result.m[0][2] = (other.m[0][2] * x) + (other.m[1][2] * y) + (other.m[2][2] * z) + (other.m[3][2] * w);
-    result.m[0][3] = (other.m[0][3] * x) + (other.m[1][3] * y) + (other.m[2][3] * z) + (other.m[3][3] * w);
-    // Repeat for all the other rows
-    x = m[1][0];
-    y = m[1][1];
-    z = m[1][2];
-    w = m[1][3];
-    result.m[1][0] = (other.m[0][0] * x) + (other.m[1][0] * y) + (other.m[2][0] * z) + (other.m[3][0] * w);
-    result.m[1][1] = (other.m[0][1] * x) + (other.m[1][1] * y) + (other.m[2][1] * z) + (other.m[3][1] * w);
-    result.m[1][2] = (other.m[0][2] * x) + (other.m[1][2] * y) + (other.m[2][2] * z) + (other.m[3][2] * w);
-    result.m[1][3] = (other.m[0][3] * x) + (other.m[1][3] * y) + (other.m[2][3] * z) + (other.m[3][3] * w);
-    x = m[2][0];
-    y = m[2][1];
-    z = m[2][2];
-    w = m[2][3];
-    result.m[2][0] = (other.m[0][0] * x) + (other.m[1][0] * y) + (other.m[2][0] * z) + (other.m[3][0] * w);
-    result.m[2][1] = (other.m[0][1] * x) + (other.m[1][1] * y) + (other.m[2][1] * z) + (other.m[3][1] * w);
-    result.m[2][2] = (other.m[0][2] * x) + (other.m[1][2] * y) + (other.m[2][2] * z) + (other.m[3][2] * w);
-    result.m[2][3] = (other.m[0][3] * x) + (other.m[1][3] * y) + (other.m[2][3] * z) + (other.m[3][3] * w);
-    x = m[3][0];
-    y = m[3][1];
-    z = m[3][2];
-    w = m[3][3];
-    result.m[3][0] = (other.m[0][0] * x) + (other.m[1][0] * y) + (other.m[2][0] * z) + (other.m[3][0] * w);
-    result.m[3][1] = (other.m[0][1] * x) + (other.m[1][1] * y) + (other.m[2][1] * z) + (other.m[3][1] * w);
-    result.m[3][2] = (other.m[0][2] * x) + (other.m[1][2] * y) + (other.m[2][2] * z) + (other.m[3][2] * w);
-    result.m[3][3] = (other.m[0][3] * x) + (other.m[1][3] * y) + (other.m[2][3] * z) + (other.m[3][3] * w);
-
+    GetMathKernels().multiply_matrix(&m[0][0], &other.m[0][0], &result.m[0][0]);
     return result;
 
 }
 
 Matrix& Matrix::operator*=(const Matrix& other)
 {
-    float x = m[0][0],     y = m[0][1],     z = m[0][2],     w = m[0][3];
-    m[0][0] = (other.m[0][0] * x) + (other.m[1][0] * y) + (other.m[2][0] * z) + (other.m[3][0] * w);
-    m[0][1] = (other.m[0][1] * x) + (other.m[1][1] * y) + (other.m[2][1] * z) + (other.m[3][1] * w);
-    m[0][2] = (other.m[0][2] * x) + (other.m[1][2] * y) + (other.m[2][2] * z) + (other.m[3][2] * w);
-    m[0][3] = (other.m[0][3] * x) + (other.m[1][3] * y) + (other.m[2][3] * z) + (other.m[3][3] * w);
-    x = m[1][0];    y = m[1][1];    z = m[1][2];    w = m[1][3];
-    m[1][0] = (other.m[0][0] * x) + (other.m[1][0] * y) + (other.m[2][0] * z) + (other.m[3][0] * w);
-    m[1][1] = (other.m[0][1] * x) + (other.m[1][1] * y) + (other.m[2][1] * z) + (other.m[3][1] * w);
-    m[1][2] = (other.m[0][2] * x) + (other.m[1][2] * y) + (other.m[2][2] * z) + (other.m[3][2] * w);
-    m[1][3] = (other.m[0][3] * x) + (other.m[1][3] * y) + (other.m[2][3] * z) + (other.m[3][3] * w);
-    x = m[2][0];    y = m[2][1];    z = m[2][2];    w = m[2][3];
-    m[2][0] = (other.m[0][0] * x) + (other.m[1][0] * y) + (other.m[2][0] * z) + (other.m[3][0] * w);
-    m[2][1] = (other.m[0][1] * x) + (other.m[1][1] * y) + (other.m[2][1] * z) + (other.m[3][1] * w);
-    m[2][2] = (other.m[0][2] * x) + (other.m[1][2] * y) + (other.m[2][2] * z) + (other.m[3][2] * w);
-    m[2][3] = (other.m[0][3] * x) + (other.m[1][3] * y) + (other.m[2][3] * z) + (other.m[3][3] * w);
-    x = m[3][0];    y = m[3][1];    z = m[3][2];    w = m[3][3];
-    m[3][0] = (other.m[0][0] * x) + (other.m[1][0] * y) + (other.m[2][0] * z) + (other.m[3][0] * w);
-    m[3][1] = (other.m[0][1] * x) + (other.m[1][1] * y) + (other.m[2][1] * z) + (other.m[3][1] * w);
-    m[3][2] = (other.m[0][2] * x) + (other.m[1][2] * y) + (other.m[2][2] * z) + (other.m[3][2] * w);
-    m[3][3] = (other.m[0][3] * x) + (other.m[1][3] * y) + (other.m[2][3] * z) + (other.m[3][3] * w);
-
+    GetMathKernels().multiply_matrix(&m[0][0], &other.m[0][0], &m[0][0]);
     return *this;
 }
 
-float3 Matrix::operator*(const float3& vec)
+float3 Matrix::operator*(const float3& vec) const
 {
     return float3(m[0][0] * vec.x + m[0][1] * vec.y + m[0][2] * vec.z + m[0][3],
         m[1][0] * vec.x + m[1][1] * vec.y + m[1][2] * vec.z + m[1][3],
@@ -263,74 +166,60 @@ float3 Matrix::operator*(const float3& vec)
 
 Matrix Matrix::Inverse() const
 {
-    int indxc[4], indxr[4];
-    int ipiv[4] = { 0, 0, 0, 0 };
-    float minv[4][4];
-    memcpy(minv, m, sizeof(float) * 16);
-    for (int i = 0; i < 4; i++)
-    {
-        int irow = 0, icol = 0;
-        float big = 0.f;
-        // Choose pivot
-        for (int j = 0; j < 4; j++)
-        {
-            if (ipiv[j] != 1)
-            {
-                for (int k = 0; k < 4; k++)
-                {
-                    if (ipiv[k] == 0)
-                    {
-                        if (std::abs(minv[j][k]) >= big)
-                        {
-                            big = float(std::abs(minv[j][k]));
-                            irow = j;
-                            icol = k;
-                        }
-                    }
-                    else if (ipiv[k] > 1)
-                    {
-                    //    Error("Singular matrix in MatrixInvert");
-                    }
-                }
-            }
-        }
-        ++ipiv[icol];
-        // Swap rows _irow_ and _icol_ for pivot
-        if (irow != icol)
-        {
-            for (int k = 0; k < 4; ++k) std::swap(minv[irow][k], minv[icol][k]);
-        }
-        indxr[i] = irow;
-        indxc[i] = icol;
-        //if (minv[icol][icol] == 0.f) Error("Singular matrix in MatrixInvert");
-
-        // Set $m[icol][icol]$ to one by scaling row _icol_ appropriately
-        float pivinv = 1.0f / minv[icol][icol];
-        minv[icol][icol] = 1.0f;
-        for (int j = 0; j < 4; j++) minv[icol][j] *= pivinv;
-
-        // Subtract this row from others to zero out their columns
-        for (int j = 0; j < 4; j++)
-        {
-            if (j != icol)
-            {
-                float save = minv[j][icol];
-                minv[j][icol] = 0;
-                for (int k = 0; k < 4; k++) minv[j][k] -= minv[icol][k] * save;
-            }
-        }
-    }
-    // Swap columns to reflect permutation
-    for (int j = 3; j >= 0; j--)
-    {
-        if (indxr[j] != indxc[j])
-        {
-            for (int k = 0; k < 4; k++)
-            {
-                std::swap(minv[k][indxr[j]], minv[k][indxc[j]]);
-            }
-        }
-    }
-    return Matrix(minv);
+    Matrix result;
+    GetMathKernels().invert_matrix(&m[0][0], &result.m[0][0]);
+    return result;
+
+}
+
+Matrix Matrix::InverseAffine() const
+{
+    Matrix result;
+    GetMathKernels().invert_affine(&m[0][0], &result.m[0][0]);
+    return result;
 
 }
+
+Matrix Matrix::InverseRigid() const
+{
+    Matrix result;
+    GetMathKernels().invert_rigid(&m[0][0], &result.m[0][0]);
+    return result;
+
+}
+
+static_assert(sizeof(float3) == sizeof(float) * 3, "Batched kernels expect packed float3");
+static_assert(sizeof(Matrix) == sizeof(float) * 16, "Batched kernels expect packed matrices");
+
+void TransformPoints(const Matrix& m, const float3* points, float3* result, std::size_t count)
+{
+    GetMathKernels().transform_points(&m.m[0][0], &points->x, &result->x, count);
+}
+
+void TransformVectors(const Matrix& m, const float3* vectors, float3* result, std::size_t count)
+{
+    GetMathKernels().transform_vectors(&m.m[0][0], &vectors->x, &result->x, count);
+}
+
+void TransformPointsSoA(const Matrix& m, const float* x, const float* y, const float* z,
+                        float* result_x, float* result_y, float* result_z, std::size_t count)
+{
+    GetMathKernels().transform_points_soa(&m.m[0][0], x, y, z, result_x, result_y, result_z, count);
+}
+
+void MultiplyMatrices(const Matrix* a, const Matrix* b, Matrix* result, std::size_t count)
+{
+    GetMathKernels().multiply_matrices(&a->m[0][0], &b->m[0][0], &result->m[0][0], count);
+}
+
+static_assert(sizeof(Matrix3x4) == sizeof(float) * 12, "Packed matrices must stay 48 bytes for uploads");
+
+void PackAffine(const Matrix* matrices, Matrix3x4* result, std::size_t count)
+{
+    GetMathKernels().pack_affine(&matrices->m[0][0], &result->m[0][0], count, false);
+}
+
+void PackAffineTransposed(const Matrix* matrices, Matrix3x4* result, std::size_t count)
+{
+    GetMathKernels().pack_affine(&matrices->m[0][0], &result->m[0][0], count, true);
+}
@@ -0,0 +1,258 @@
+#include "occlusion_buffer.hpp"
+#include "math_kernels.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    // clip = (p, 1) * m
+    float4 TransformToClip(const Matrix& matrix, const float3& p)
+    {
+        const auto& m = matrix.m;
+        return float4(p.x * m[0][0] + p.y * m[1][0] + p.z * m[2][0] + m[3][0],
+                      p.x * m[0][1] + p.y * m[1][1] + p.z * m[2][1] + m[3][1],
+                      p.x * m[0][2] + p.y * m[1][2] + p.z * m[2][2] + m[3][2],
+                      p.x * m[0][3] + p.y * m[1][3] + p.z * m[2][3] + m[3][3]);
+    }
+}
+
+OcclusionBuffer::OcclusionBuffer(std::uint32_t width, std::uint32_t height)
+    : width_(width)
+    , height_(height)
+    , view_projection_(Matrix::Identity())
+{
+    if (width == 0 || height == 0 || width % 8 != 0)
+    {
+        throw std::runtime_error("Occlusion buffer width must be a non-zero multiple of 8!");
+    }
+
+    depth_.assign(static_cast<std::size_t>(width) * height, 1.0f);
+    std::uint32_t level_width = width;
+    std::uint32_t level_height = height;
+    while (level_width > 1 || level_height > 1)
+    {
+        level_width = (level_width + 1) / 2;
+        level_height = (level_height + 1) / 2;
+        std::size_t size = static_cast<std::size_t>(level_width) * level_height;
+        levels_.push_back({ level_width, level_height, std::vector<float>(size, 1.0f), std::vector<float>(size, 1.0f) });
+    }
+}
+
+void OcclusionBuffer::Clear(const Matrix& view_projection)
+{
+    view_projection_ = view_projection;
+    std::fill(depth_.begin(), depth_.end(), 1.0f);
+    for (Level& level : levels_)
+    {
+        std::fill(level.min_depth.begin(), level.min_depth.end(), 1.0f);
+        std::fill(level.max_depth.begin(), level.max_depth.end(), 1.0f);
+    }
+}
+
+void OcclusionBuffer::RenderOccluder(const float3* vertices, const std::uint32_t* indices, std::size_t index_count,
+                                     const Matrix& model_view_projection)
+{
+    triangles_.clear();
+    for (std::size_t i = 0; i + 2 < index_count; i += 3)
+    {
+        float4 clip[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            clip[k] = TransformToClip(model_view_projection, vertices[indices[i + k]]);
+        }
+
+        // Sutherland-Hodgman against z >= 0, one plane turns a triangle into at most a quad
+        float4 polygon[4];
+        int vertex_count = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            const float4& a = clip[k];
+            const float4& b = clip[k == 2 ? 0 : k + 1];
+            if (a.z >= 0.0f)
+            {
+                polygon[vertex_count++] = a;
+            }
+
+            if ((a.z >= 0.0f) != (b.z >= 0.0f))
+            {
+                polygon[vertex_count++] = a + (b - a) * (a.z / (a.z - b.z));
+            }
+        }
+
+        for (int k = 1; k + 1 < vertex_count; ++k)
+        {
+            const float4* triangle[3] = { &polygon[0], &polygon[k], &polygon[k + 1] };
+            if (!(triangle[0]->w > 0.0f && triangle[1]->w > 0.0f && triangle[2]->w > 0.0f))
+            {
+                continue;
+            }
+
+            for (const float4* v : triangle)
+            {
+                float inv_w = 1.0f / v->w;
+                triangles_.push_back((v->x * inv_w * 0.5f + 0.5f) * width_);
+                triangles_.push_back((0.5f - v->y * inv_w * 0.5f) * height_);
+                triangles_.push_back(v->z * inv_w);
+            }
+        }
+    }
+
+    GetMathKernels().rasterize_depth(triangles_.data(), triangles_.size() / 9, depth_.data(), width_, height_);
+}
+
+void OcclusionBuffer::BuildHierarchy()
+{
+    const float* src_min = depth_.data();
+    const float* src_max = depth_.data();
+    std::uint32_t src_width = width_;
+    std::uint32_t src_height = height_;
+    for (Level& level : levels_)
+    {
+        for (std::uint32_t y = 0; y < level.height; ++y)
+        {
+            // Odd sizes repeat the last row or column
+            std::uint32_t y0 = y * 2;
+            std::uint32_t y1 = std::min(y0 + 1, src_height - 1);
+            for (std::uint32_t x = 0; x < level.width; ++x)
+            {
+                std::uint32_t x0 = x * 2;
+                std::uint32_t x1 = std::min(x0 + 1, src_width - 1);
+                std::size_t i00 = y0 * src_width + x0, i01 = y0 * src_width + x1;
+                std::size_t i10 = y1 * src_width + x0, i11 = y1 * src_width + x1;
+                std::size_t dst = y * level.width + x;
+                level.min_depth[dst] = std::min(std::min(src_min[i00], src_min[i01]), std::min(src_min[i10], src_min[i11]));
+                level.max_depth[dst] = std::max(std::max(src_max[i00], src_max[i01]), std::max(src_max[i10], src_max[i11]));
+            }
+        }
+
+        src_min = level.min_depth.data();
+        src_max = level.max_depth.data();
+        src_width = level.width;
+        src_height = level.height;
+    }
+}
+
+bool OcclusionBuffer::IsVisible(const float3& min_point, const float3& max_point) const
+{
+    constexpr float kMax = std::numeric_limits<float>::max();
+    float min_x = kMax, max_x = -kMax;
+    float min_y = kMax, max_y = -kMax;
+    float min_z = kMax;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        float3 p((corner & 1) ? max_point.x : min_point.x,
+                 (corner & 2) ? max_point.y : min_point.y,
+                 (corner & 4) ? max_point.z : min_point.z);
+        float4 clip = TransformToClip(view_projection_, p);
+        if (!(clip.z >= 0.0f && clip.w > 0.0f))
+        {
+            return true;
+        }
+
+        float inv_w = 1.0f / clip.w;
+        float x = (clip.x * inv_w * 0.5f + 0.5f) * width_;
+        float y = (0.5f - clip.y * inv_w * 0.5f) * height_;
+        min_x = std::min(min_x, x);
+        max_x = std::max(max_x, x);
+        min_y = std::min(min_y, y);
+        max_y = std::max(max_y, y);
+        min_z = std::min(min_z, clip.z * inv_w);
+    }
+
+    // Every pixel the screen rectangle touches
+    if (!(max_x >= 0.0f && max_y >= 0.0f && min_x < width_ && min_y < height_))
+    {
+        return false;
+    }
+
+    std::uint32_t x0 = static_cast<std::uint32_t>(std::max(min_x, 0.0f));
+    std::uint32_t y0 = static_cast<std::uint32_t>(std::max(min_y, 0.0f));
+    std::uint32_t x1 = static_cast<std::uint32_t>(std::min(max_x, static_cast<float>(width_ - 1)));
+    std::uint32_t y1 = static_cast<std::uint32_t>(std::min(max_y, static_cast<float>(height_ - 1)));
+
+    // Start where the rectangle spans at most 2 x 2 texels
+    std::size_t level = 0;
+    while (level < levels_.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+    {
+        ++level;
+    }
+
+    return IsRegionVisible(level, x0, y0, x1, y1, min_z);
+}
+
+void OcclusionBuffer::TestAabbs(const float* center_x, const float* center_y, const float* center_z,
+                                const float* extent_x, const float* extent_y, const float* extent_z,
+                                std::uint8_t* visible, std::size_t count) const
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        float3 center(center_x[i], center_y[i], center_z[i]);
+        float3 extent(extent_x[i], extent_y[i], extent_z[i]);
+        visible[i] = IsVisible(center - extent, center + extent) ? 1 : 0;
+    }
+}
+
+float OcclusionBuffer::GetMinDepth(std::size_t level, std::uint32_t x, std::uint32_t y) const
+{
+    return level == 0 ? depth_[y * width_ + x] : levels_[level - 1].min_depth[y * levels_[level - 1].width + x];
+}
+
+float OcclusionBuffer::GetMaxDepth(std::size_t level, std::uint32_t x, std::uint32_t y) const
+{
+    return level == 0 ? depth_[y * width_ + x] : levels_[level - 1].max_depth[y * levels_[level - 1].width + x];
+}
+
+bool OcclusionBuffer::IsRegionVisible(std::size_t level, std::uint32_t x0, std::uint32_t y0,
+                                      std::uint32_t x1, std::uint32_t y1, float z) const
+{
+    if (level == 0)
+    {
+        for (std::uint32_t y = y0; y <= y1; ++y)
+        {
+            for (std::uint32_t x = x0; x <= x1; ++x)
+            {
+                if (z <= depth_[y * width_ + x])
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    const Level& texels = levels_[level - 1];
+    for (std::uint32_t ty = y0 >> level; ty <= y1 >> level; ++ty)
+    {
+        for (std::uint32_t tx = x0 >> level; tx <= x1 >> level; ++tx)
+        {
+            std::size_t index = ty * texels.width + tx;
+            if (z > texels.max_depth[index])
+            {
+                continue;
+            }
+
+            // Pixels of the texel, then the part of them inside the rectangle
+            std::uint32_t texel_x0 = tx << level, texel_y0 = ty << level;
+            std::uint32_t texel_x1 = std::min(((tx + 1) << level) - 1, width_ - 1);
+            std::uint32_t texel_y1 = std::min(((ty + 1) << level) - 1, height_ - 1);
+            std::uint32_t px0 = std::max(x0, texel_x0), py0 = std::max(y0, texel_y0);
+            std::uint32_t px1 = std::min(x1, texel_x1), py1 = std::min(y1, texel_y1);
+
+            // In front of the nearest occluder of a fully covered texel
+            bool covered = px0 == texel_x0 && py0 == texel_y0 && px1 == texel_x1 && py1 == texel_y1;
+            if (covered && z <= texels.min_depth[index])
+            {
+                return true;
+            }
+
+            if (IsRegionVisible(level - 1, px0, py0, px1, py1, z))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
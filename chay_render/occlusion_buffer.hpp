@@ -0,0 +1,64 @@
+#ifndef OCCLUSION_BUFFER_HPP_
+#define OCCLUSION_BUFFER_HPP_
+
+#include "mathlib.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Low resolution CPU depth buffer for software occlusion culling. A frame renders a few large
+// occluders, builds the min/max depth hierarchy and then tests the bounds of everything else.
+// Matrices follow LookAt*/Perspective*/Ortho*: row vectors and depth 0 at the near plane.
+// Occluders are sampled at pixel centers, so their silhouette may grow by up to half a pixel
+class OcclusionBuffer
+{
+public:
+    // width must be a multiple of 8
+    OcclusionBuffer(std::uint32_t width, std::uint32_t height);
+
+    // Clears to the far plane, view_projection is used by the tests until the next Clear()
+    void Clear(const Matrix& view_projection);
+    // Triangles by index, clipped at the near plane. Both windings are drawn
+    void RenderOccluder(const float3* vertices, const std::uint32_t* indices, std::size_t index_count,
+                        const Matrix& model_view_projection);
+    // Call after the last occluder and before the tests
+    void BuildHierarchy();
+
+    // A box is hidden when every pixel it covers has an occluder in front of its nearest point.
+    // Boxes crossing the near plane are always visible, boxes off screen are always hidden
+    bool IsVisible(const float3& min_point, const float3& max_point) const;
+    // Center and half extents as CullAabbs, visible[i] is 1 or 0
+    void TestAabbs(const float* center_x, const float* center_y, const float* center_z,
+                   const float* extent_x, const float* extent_y, const float* extent_z,
+                   std::uint8_t* visible, std::size_t count) const;
+
+    std::uint32_t GetWidth() const { return width_; }
+    std::uint32_t GetHeight() const { return height_; }
+    // Level 0 is the depth buffer itself, level i covers 2^i x 2^i pixels per texel
+    std::size_t GetLevelCount() const { return levels_.size() + 1; }
+    float GetMinDepth(std::size_t level, std::uint32_t x, std::uint32_t y) const;
+    float GetMaxDepth(std::size_t level, std::uint32_t x, std::uint32_t y) const;
+
+private:
+    struct Level
+    {
+        std::uint32_t width;
+        std::uint32_t height;
+        std::vector<float> min_depth;
+        std::vector<float> max_depth;
+    };
+
+    // Whether a pixel of the inclusive level 0 rectangle has depth >= z, starting at the given level
+    bool IsRegionVisible(std::size_t level, std::uint32_t x0, std::uint32_t y0, std::uint32_t x1, std::uint32_t y1, float z) const;
+
+    std::uint32_t width_;
+    std::uint32_t height_;
+    Matrix view_projection_;
+    std::vector<float> depth_;
+    std::vector<Level> levels_;
+    // Screen space triangles of the current occluder
+    std::vector<float> triangles_;
+
+};
+
+#endif // OCCLUSION_BUFFER_HPP_
@@ -0,0 +1,72 @@
+#include "occlusion_culler.hpp"
+#include "math_kernels.hpp"
+
+OcclusionCuller::OcclusionCuller(std::uint32_t revalidate_interval)
+    : revalidate_interval_(revalidate_interval > 0 ? revalidate_interval : 1)
+{}
+
+void OcclusionCuller::Reset()
+{
+    states_.clear();
+    frame_index_ = 0;
+}
+
+void OcclusionCuller::Invalidate(std::size_t index)
+{
+    if (index < states_.size())
+    {
+        states_[index] |= kChanged;
+    }
+}
+
+void OcclusionCuller::Cull(const Frustum& frustum, const OcclusionBuffer& occlusion_buffer,
+                           const float* center_x, const float* center_y, const float* center_z,
+                           const float* extent_x, const float* extent_y, const float* extent_z,
+                           std::size_t count, std::vector<std::uint32_t>& visible_indices)
+{
+    // New objects have no history and get tested
+    states_.resize(count, kChanged);
+    frustum_results_.resize(count);
+    CullAabbs(frustum, center_x, center_y, center_z, extent_x, extent_y, extent_z, frustum_results_.data(), count);
+
+    // Last frame's visible objects first, they are likely the best occluders for the rest
+    visible_indices.clear();
+    std::uint32_t phase = frame_index_ % revalidate_interval_;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (frustum_results_[i] == kCullOutside)
+        {
+            states_[i] &= ~kVisible;
+            continue;
+        }
+
+        bool revalidate = (i + phase) % revalidate_interval_ == 0;
+        if (states_[i] == kVisible && !revalidate)
+        {
+            visible_indices.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    reused_count_ = visible_indices.size();
+
+    tested_count_ = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        bool revalidate = (i + phase) % revalidate_interval_ == 0;
+        if (frustum_results_[i] == kCullOutside || (states_[i] == kVisible && !revalidate))
+        {
+            continue;
+        }
+
+        ++tested_count_;
+        float3 center(center_x[i], center_y[i], center_z[i]);
+        float3 extent(extent_x[i], extent_y[i], extent_z[i]);
+        bool visible = occlusion_buffer.IsVisible(center - extent, center + extent);
+        states_[i] = visible ? kVisible : 0;
+        if (visible)
+        {
+            visible_indices.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+
+    ++frame_index_;
+}
@@ -0,0 +1,53 @@
+#ifndef OCCLUSION_CULLER_HPP_
+#define OCCLUSION_CULLER_HPP_
+
+#include "mathlib.hpp"
+#include "occlusion_buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Frustum and occlusion culling that reuses last frame's results. Objects that were visible
+// last frame are reported first without an occlusion test, only objects that were hidden,
+// are new or were invalidated get tested against the occlusion buffer. Visible objects are
+// re-tested every revalidate_interval frames, staggered by index, so that objects which got
+// hidden are eventually dropped. The frustum test runs on every object every frame.
+// Objects are identified by their index into the bounds arrays, call Reset() when that
+// mapping changes or after a camera cut
+class OcclusionCuller
+{
+public:
+    explicit OcclusionCuller(std::uint32_t revalidate_interval = 8);
+
+    void Reset();
+    // The object moved or changed its bounds, it gets an occlusion test in the next Cull()
+    void Invalidate(std::size_t index);
+
+    // Center and half extents as CullAabbs. visible_indices is overwritten: objects that keep
+    // last frame's visibility come first, then the ones the occlusion test found visible
+    void Cull(const Frustum& frustum, const OcclusionBuffer& occlusion_buffer,
+              const float* center_x, const float* center_y, const float* center_z,
+              const float* extent_x, const float* extent_y, const float* extent_z,
+              std::size_t count, std::vector<std::uint32_t>& visible_indices);
+
+    // Statistics of the last Cull()
+    std::size_t GetReusedCount() const { return reused_count_; }
+    std::size_t GetTestedCount() const { return tested_count_; }
+
+private:
+    enum StateFlags : std::uint8_t
+    {
+        kVisible = 1 << 0,
+        kChanged = 1 << 1
+    };
+
+    std::uint32_t revalidate_interval_;
+    std::uint32_t frame_index_ = 0;
+    std::vector<std::uint8_t> states_;
+    std::vector<std::uint8_t> frustum_results_;
+    std::size_t reused_count_ = 0;
+    std::size_t tested_count_ = 0;
+
+};
+
+#endif // OCCLUSION_CULLER_HPP_
@@ -0,0 +1,83 @@
+#include "mathlib.hpp"
+#include "math_kernels.hpp"
+
+Quaternion Quaternion::FromAxisAngle(const float3& axis, float angle)
+{
+    float3 a = axis.normalize();
+    float s = std::sin(0.5f * angle);
+    return Quaternion(a.x * s, a.y * s, a.z * s, std::cos(0.5f * angle));
+}
+
+Matrix Quaternion::ToMatrix() const
+{
+    float xx = x * x, yy = y * y, zz = z * z;
+    float xy = x * y, xz = x * z, yz = y * z;
+    float wx = w * x, wy = w * y, wz = w * z;
+
+    return Matrix(1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz),        2.0f * (xz + wy),        0.0f,
+                  2.0f * (xy + wz),        1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx),        0.0f,
+                  2.0f * (xz - wy),        2.0f * (yz + wx),        1.0f - 2.0f * (xx + yy), 0.0f,
+                  0.0f,                    0.0f,                    0.0f,                    1.0f);
+}
+
+Quaternion lerp(const Quaternion& a, const Quaternion& b, float t)
+{
+    // q and -q are the same rotation, pick the one closer to a
+    float sign = dot(a, b) < 0.0f ? -1.0f : 1.0f;
+    float s = 1.0f - t;
+    float u = t * sign;
+    return Quaternion(a.x * s + b.x * u, a.y * s + b.y * u, a.z * s + b.z * u, a.w * s + b.w * u);
+}
+
+Quaternion nlerp(const Quaternion& a, const Quaternion& b, float t)
+{
+    return lerp(a, b, t).normalize();
+}
+
+Quaternion slerp(const Quaternion& a, const Quaternion& b, float t)
+{
+    float cos_theta = dot(a, b);
+    float sign = 1.0f;
+    if (cos_theta < 0.0f)
+    {
+        cos_theta = -cos_theta;
+        sign = -1.0f;
+    }
+
+    // sin(theta) gets too small to divide by
+    if (cos_theta > 0.9995f)
+    {
+        return nlerp(a, b, t);
+    }
+
+    float theta = std::acos(cos_theta);
+    float inv_sin_theta = 1.0f / std::sin(theta);
+    float s = std::sin((1.0f - t) * theta) * inv_sin_theta;
+    float u = std::sin(t * theta) * inv_sin_theta * sign;
+    return Quaternion(a.x * s + b.x * u, a.y * s + b.y * u, a.z * s + b.z * u, a.w * s + b.w * u);
+}
+
+Matrix TrsTransform::ToMatrix() const
+{
+    // The first three rows of the row-major matrix are the 3x4 layout pack_trs writes,
+    // so single transforms and PackAffine share one implementation
+    Matrix result;
+    GetMathKernels().pack_trs(&translation.x, &rotation.x, &scale.x, 0, &result.m[0][0], 1);
+    result.m[3][3] = 1.0f;
+    return result;
+}
+
+static_assert(sizeof(TrsTransform) % sizeof(float) == 0, "The TRS kernel walks transforms in float strides");
+
+void PackAffine(const TrsTransform* transforms, Matrix3x4* result, std::size_t count)
+{
+    GetMathKernels().pack_trs(&transforms->translation.x, &transforms->rotation.x, &transforms->scale.x,
+                              sizeof(TrsTransform) / sizeof(float), &result->m[0][0], count);
+}
+
+TrsTransform lerp(const TrsTransform& a, const TrsTransform& b, float t)
+{
+    return TrsTransform(a.translation + (b.translation - a.translation) * t,
+                        nlerp(a.rotation, b.rotation, t),
+                        a.scale + (b.scale - a.scale) * t);
+}
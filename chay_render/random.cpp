@@ -0,0 +1,43 @@
+#include "random.hpp"
+
+RandomStreams::RandomStreams(std::uint64_t seed)
+{
+    // splitmix64, recommended for seeding xoshiro since it never yields an all zero state
+    for (std::size_t stream = 0; stream < kRandomStreams; ++stream)
+    {
+        for (std::size_t word = 0; word < 4; word += 2)
+        {
+            std::uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            z ^= z >> 31;
+            state_[word][stream] = static_cast<std::uint32_t>(z);
+            state_[word + 1][stream] = static_cast<std::uint32_t>(z >> 32);
+        }
+    }
+}
+
+void RandomStreams::Generate(std::uint32_t* result, std::size_t count)
+{
+    GetMathKernels().random_uint32(&state_[0][0], result, count);
+}
+
+void RandomStreams::GenerateFloats(float* result, std::size_t count, float min, float max)
+{
+    GetMathKernels().random_float(&state_[0][0], result, count, min, max);
+}
+
+void ValueNoise(const float* x, const float* y, const float* z, std::uint32_t seed, float* result, std::size_t count)
+{
+    GetMathKernels().noise(NoiseType::kValue, x, y, z, seed, result, count);
+}
+
+void GradientNoise(const float* x, const float* y, const float* z, std::uint32_t seed, float* result, std::size_t count)
+{
+    GetMathKernels().noise(NoiseType::kGradient, x, y, z, seed, result, count);
+}
+
+void SimplexNoise(const float* x, const float* y, const float* z, std::uint32_t seed, float* result, std::size_t count)
+{
+    GetMathKernels().noise(NoiseType::kSimplex, x, y, z, seed, result, count);
+}
@@ -0,0 +1,65 @@
+#ifndef RANDOM_HPP_
+#define RANDOM_HPP_
+
+#include "math_kernels.hpp"
+#include <cstdint>
+
+// Single PCG32 (XSH RR) stream for code that needs a few values at a time
+class Pcg32
+{
+public:
+    explicit Pcg32(std::uint64_t seed, std::uint64_t stream = 0)
+        : state_(0), increment_((stream << 1) | 1)
+    {
+        Next();
+        state_ += seed;
+        Next();
+    }
+
+    std::uint32_t Next()
+    {
+        std::uint64_t state = state_;
+        state_ = state * 6364136223846793005ull + increment_;
+        std::uint32_t xorshifted = static_cast<std::uint32_t>(((state >> 18) ^ state) >> 27);
+        std::uint32_t rotation = static_cast<std::uint32_t>(state >> 59);
+        return (xorshifted >> rotation) | (xorshifted << ((0u - rotation) & 31u));
+    }
+
+    // Uniform in [0, 1) with 24 random bits
+    float NextFloat()
+    {
+        return static_cast<float>(Next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+private:
+    std::uint64_t state_;
+    std::uint64_t increment_;
+
+};
+
+// kRandomStreams interleaved xoshiro128** streams generated together on the best SIMD kernel.
+// Value i of a batch comes from stream i % kRandomStreams, so batches give the same integers
+// on every CPU (floats up to rounding). Streams advance in whole rounds, a batch of 3 consumes
+// as much as a batch of 8.
+class RandomStreams
+{
+public:
+    // Every stream is seeded from splitmix64 of the seed
+    explicit RandomStreams(std::uint64_t seed);
+
+    void Generate(std::uint32_t* result, std::size_t count);
+    // Uniform between min and max, with 24 random bits per value
+    void GenerateFloats(float* result, std::size_t count, float min = 0.0f, float max = 1.0f);
+
+private:
+    alignas(32) std::uint32_t state_[4][kRandomStreams];
+
+};
+
+// Noise over SoA coordinates, roughly in [-1, 1]. Different seeds give uncorrelated fields.
+// SIMD levels agree up to rounding, which grows with the magnitude of the coordinates
+void ValueNoise(const float* x, const float* y, const float* z, std::uint32_t seed, float* result, std::size_t count);
+void GradientNoise(const float* x, const float* y, const float* z, std::uint32_t seed, float* result, std::size_t count);
+void SimplexNoise(const float* x, const float* y, const float* z, std::uint32_t seed, float* result, std::size_t count);
+
+#endif // RANDOM_HPP_
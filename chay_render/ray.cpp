@@ -0,0 +1,31 @@
+#include "mathlib.hpp"
+#include "math_kernels.hpp"
+
+static_assert(sizeof(Ray) == sizeof(float) * 7, "Ray kernels expect packed rays");
+
+bool IntersectRayAabb(const Ray& ray, const Aabb& aabb, float& t)
+{
+    AabbArrays boxes;
+    for (int c = 0; c < 3; ++c)
+    {
+        boxes.min_point[c] = &aabb.min_point[c];
+        boxes.max_point[c] = &aabb.max_point[c];
+    }
+
+    GetMathKernels().intersect_ray_aabbs(&ray.origin.x, boxes, 1, &t);
+    return t != kRayMiss;
+}
+
+bool IntersectRayTriangle(const Ray& ray, const float3& v0, const float3& v1, const float3& v2, float& t, float& u, float& v)
+{
+    TriangleArrays triangles;
+    for (int c = 0; c < 3; ++c)
+    {
+        triangles.v0[c] = &v0[c];
+        triangles.v1[c] = &v1[c];
+        triangles.v2[c] = &v2[c];
+    }
+
+    GetMathKernels().intersect_ray_triangles(&ray.origin.x, triangles, 1, &t, &u, &v);
+    return t != kRayMiss;
+}
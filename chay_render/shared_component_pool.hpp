@@ -0,0 +1,213 @@
+#ifndef SHARED_COMPONENT_POOL_HPP_
+#define SHARED_COMPONENT_POOL_HPP_
+
+#include "component.hpp"
+#include "world_recorder.hpp"
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstdint>
+
+typedef std::uint32_t SharedValueIndex;
+
+class SharedComponentPoolBase
+{
+public:
+    SharedComponentPoolBase(ComponentTypeId component_type_id, std::size_t value_size, char const* name)
+        : component_type_id_(component_type_id)
+        , value_size_(value_size)
+        , name_(name)
+    {}
+
+    virtual ~SharedComponentPoolBase() = default;
+
+    ComponentTypeId GetComponentTypeId() const { return component_type_id_; }
+    std::size_t GetValueSize() const { return value_size_; }
+    std::string const& GetName() const { return name_; }
+
+    // Value assignments and removals are reported to the recorder while it is set
+    void SetRecorder(WorldRecorder* recorder) { recorder_ = recorder; }
+    WorldRecorder* GetRecorder() const { return recorder_; }
+
+    // Type-erased access for WorldRecorder and WorldReplayer, values are raw bytes of GetValueSize()
+    virtual void const* GetValueBytes(EntityId id) const = 0;
+    virtual void SetValueBytes(EntityId id, void const* value) = 0;
+    virtual void RemoveValue(EntityId id) = 0;
+
+protected:
+    WorldRecorder* recorder_ = nullptr;
+
+private:
+    ComponentTypeId component_type_id_;
+    std::size_t value_size_;
+    std::string name_;
+
+};
+
+// Stores every distinct value of T once, entities reference values by index.
+// Entities are kept grouped by value, so iterating groups gives ready-made batches.
+// Values are deduplicated through a hash index, so T needs operator== and a std::hash
+// specialization. Assigning a value costs O(1) regardless of the number of distinct values.
+// Value indices are stable while at least one entity references the value.
+template <class T>
+class SharedComponentPool : public SharedComponentPoolBase
+{
+public:
+    // Values are recorded and replayed as raw bytes, the same way components are
+    static_assert(std::is_trivially_copyable<T>::value, "Shared component must be trivially copyable");
+
+    SharedComponentPool(ComponentTypeId component_type_id, char const* name)
+        : SharedComponentPoolBase(component_type_id, sizeof(T), name)
+    {}
+
+    SharedValueIndex SetValue(EntityId id, T const& value)
+    {
+        SharedValueIndex value_index = FindOrAddValue(value);
+
+        auto it = entity_id_2_membership_.find(id);
+        if (it != entity_id_2_membership_.end())
+        {
+            if (it->second.value_index == value_index)
+            {
+                return value_index;
+            }
+
+            RemoveFromGroup(it->second);
+        }
+
+        auto & group = groups_[value_index];
+        entity_id_2_membership_[id] = { value_index, static_cast<std::uint32_t>(group.size()) };
+        group.push_back(id);
+
+        if (recorder_)
+        {
+            recorder_->RecordSetShared(*this, id);
+        }
+
+        return value_index;
+    }
+
+    void RemoveValue(EntityId id) override
+    {
+        auto it = entity_id_2_membership_.find(id);
+        if (it == entity_id_2_membership_.end())
+        {
+            throw std::runtime_error("Failed to find shared component!");
+        }
+
+        RemoveFromGroup(it->second);
+        entity_id_2_membership_.erase(it);
+
+        if (recorder_)
+        {
+            recorder_->RecordRemoveShared(*this, id);
+        }
+    }
+
+    void const* GetValueBytes(EntityId id) const override { return &GetValue(id); }
+
+    void SetValueBytes(EntityId id, void const* value) override
+    {
+        T typed_value;
+        std::memcpy(&typed_value, value, sizeof(T));
+        SetValue(id, typed_value);
+    }
+
+    bool HasValue(EntityId id) const
+    {
+        return entity_id_2_membership_.find(id) != entity_id_2_membership_.end();
+    }
+
+    SharedValueIndex GetValueIndex(EntityId id) const
+    {
+        auto it = entity_id_2_membership_.find(id);
+        if (it == entity_id_2_membership_.end())
+        {
+            throw std::runtime_error("Failed to find shared component!");
+        }
+
+        return it->second.value_index;
+    }
+
+    T const& GetValue(EntityId id) const { return values_[GetValueIndex(id)]; }
+    T const& GetValueByIndex(SharedValueIndex value_index) const { return values_[value_index]; }
+
+    // Number of distinct values currently referenced by entities
+    std::size_t GetValueCount() const { return values_.size() - free_value_indices_.size(); }
+
+    // func(T const& value, EntityId const* entities, std::size_t entity_count) per distinct value
+    template <class Func>
+    void ForEachGroup(Func func) const
+    {
+        for (std::size_t i = 0; i < groups_.size(); ++i)
+        {
+            if (!groups_[i].empty())
+            {
+                func(values_[i], groups_[i].data(), groups_[i].size());
+            }
+        }
+    }
+
+private:
+    struct Membership
+    {
+        SharedValueIndex value_index;
+        std::uint32_t group_index;
+    };
+
+    SharedValueIndex FindOrAddValue(T const& value)
+    {
+        auto it = value_2_index_.find(value);
+        if (it != value_2_index_.end())
+        {
+            return it->second;
+        }
+
+        SharedValueIndex value_index;
+        if (!free_value_indices_.empty())
+        {
+            value_index = free_value_indices_.back();
+            free_value_indices_.pop_back();
+            values_[value_index] = value;
+        }
+        else
+        {
+            value_index = static_cast<SharedValueIndex>(values_.size());
+            values_.push_back(value);
+            groups_.emplace_back();
+        }
+
+        value_2_index_.emplace(value, value_index);
+        return value_index;
+    }
+
+    void RemoveFromGroup(Membership const& membership)
+    {
+        auto & group = groups_[membership.value_index];
+
+        // Swap with the last entity of the group to keep it dense
+        EntityId moved_id = group.back();
+        group[membership.group_index] = moved_id;
+        entity_id_2_membership_[moved_id].group_index = membership.group_index;
+        group.pop_back();
+
+        if (group.empty())
+        {
+            value_2_index_.erase(values_[membership.value_index]);
+            free_value_indices_.push_back(membership.value_index);
+        }
+    }
+
+    std::vector<T> values_;
+    std::vector<std::vector<EntityId>> groups_;
+    std::vector<SharedValueIndex> free_value_indices_;
+    // Only values referenced by at least one entity
+    std::unordered_map<T, SharedValueIndex> value_2_index_;
+    std::unordered_map<EntityId, Membership> entity_id_2_membership_;
+
+};
+
+#endif // SHARED_COMPONENT_POOL_HPP_
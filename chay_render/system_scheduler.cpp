@@ -0,0 +1,36 @@
+#include "system_scheduler.hpp"
+#include <stdexcept>
+
+SystemScheduler::SystemScheduler(ComponentManager & component_manager)
+    : component_manager_(component_manager)
+{
+}
+
+void SystemScheduler::AddSystem(char const* name, std::function<void(float)> update)
+{
+    systems_.push_back({ name, std::move(update), 0.0 });
+}
+
+void SystemScheduler::Update(float dt)
+{
+    for (auto & system : systems_)
+    {
+        auto start = std::chrono::steady_clock::now();
+        system.update(dt);
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        system.elapsed_us = elapsed.count();
+    }
+}
+
+double SystemScheduler::GetSystemTime(char const* name) const
+{
+    for (auto const& system : systems_)
+    {
+        if (system.name == name)
+        {
+            return system.elapsed_us;
+        }
+    }
+
+    throw std::runtime_error("Failed to find system!");
+}
@@ -0,0 +1,66 @@
+#ifndef SYSTEM_SCHEDULER_HPP_
+#define SYSTEM_SCHEDULER_HPP_
+
+#include "component_manager.hpp"
+#include "time_slicer.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+// Runs systems in registration order once per frame
+class SystemScheduler
+{
+public:
+    SystemScheduler(ComponentManager & component_manager);
+
+    // update(dt) is called every frame
+    void AddSystem(char const* name, std::function<void(float)> update);
+
+    // func(T&, dt) is called for a rotating slice of the enabled T components each frame,
+    // sized so that the slice takes about budget_us microseconds.
+    // For systems which don't need to touch every entity every frame (AI, LOD, far bounds)
+    template <class T>
+    void AddTimeSlicedSystem(char const* name, double budget_us, std::function<void(T &, float)> func);
+
+    void Update(float dt);
+
+    // Time spent in the system during the last Update, in microseconds
+    double GetSystemTime(char const* name) const;
+
+private:
+    struct System
+    {
+        std::string name;
+        std::function<void(float)> update;
+        double elapsed_us;
+    };
+
+    ComponentManager & component_manager_;
+    std::vector<System> systems_;
+
+};
+
+template <class T>
+void SystemScheduler::AddTimeSlicedSystem(char const* name, double budget_us, std::function<void(T &, float)> func)
+{
+    auto & pool = component_manager_.GetComponentPool<T>();
+    auto slicer = std::make_shared<TimeSlicer>(budget_us);
+
+    AddSystem(name, [&pool, slicer, func](float dt)
+    {
+        TimeSlice slice = slicer->BeginSlice(pool.GetComponentCount());
+        auto start = std::chrono::steady_clock::now();
+
+        pool.ForEachEnabled(slice.begin_index, slice.end_index, [&func, dt](void* component, EntityId)
+        {
+            func(*static_cast<T*>(component), dt);
+        });
+
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        slicer->EndSlice(slice, elapsed.count());
+    });
+}
+
+#endif // SYSTEM_SCHEDULER_HPP_
@@ -0,0 +1,57 @@
+#include "time_slicer.hpp"
+#include <algorithm>
+
+namespace
+{
+    // Weight of the latest measurement in the smoothed cost
+    constexpr double kCostSmoothing = 0.25;
+    // Timer resolution can report zero for a whole slice, a nanosecond per item keeps the quotient finite
+    constexpr double kMinCostPerItemUs = 1e-3;
+}
+
+TimeSlicer::TimeSlicer(double budget_us, std::size_t min_slice_size)
+    : budget_us_(budget_us)
+    , min_slice_size_(std::max<std::size_t>(min_slice_size, 1))
+{
+}
+
+TimeSlice TimeSlicer::BeginSlice(std::size_t item_count)
+{
+    if (item_count == 0)
+    {
+        cursor_ = 0;
+        return { 0, 0 };
+    }
+
+    if (cursor_ >= item_count)
+    {
+        cursor_ = 0;
+    }
+
+    std::size_t slice_size = min_slice_size_;
+    if (cost_per_item_us_ > 0.0)
+    {
+        // Clamp in floating point, the quotient can exceed what fits into size_t
+        double budget_slice_size = std::min(std::max(budget_us_ / cost_per_item_us_, 0.0), static_cast<double>(item_count));
+        slice_size = std::max(slice_size, static_cast<std::size_t>(budget_slice_size));
+    }
+
+    slice_size = std::min(slice_size, item_count - cursor_);
+    return { cursor_, cursor_ + slice_size };
+}
+
+void TimeSlicer::EndSlice(TimeSlice const& slice, double elapsed_us)
+{
+    std::size_t slice_size = slice.end_index - slice.begin_index;
+    cursor_ = slice.end_index;
+
+    if (slice_size == 0)
+    {
+        return;
+    }
+
+    double cost_per_item_us = std::max(elapsed_us / slice_size, kMinCostPerItemUs);
+    cost_per_item_us_ = cost_per_item_us_ > 0.0
+        ? cost_per_item_us_ + kCostSmoothing * (cost_per_item_us - cost_per_item_us_)
+        : cost_per_item_us;
+}
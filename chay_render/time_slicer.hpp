@@ -0,0 +1,37 @@
+#ifndef TIME_SLICER_HPP_
+#define TIME_SLICER_HPP_
+
+#include <cstddef>
+
+struct TimeSlice
+{
+    std::size_t begin_index;
+    std::size_t end_index;
+};
+
+// Splits a range of items into consecutive per-frame slices that fit into a time budget.
+// The cost per item is measured every frame and smoothed, so the slice grows when
+// items are cheap and shrinks when they get expensive, e.g. after the entity count jumps.
+// Slices rotate through the whole range and wrap around at the end.
+class TimeSlicer
+{
+public:
+    TimeSlicer(double budget_us, std::size_t min_slice_size = 16);
+
+    TimeSlice BeginSlice(std::size_t item_count);
+    void EndSlice(TimeSlice const& slice, double elapsed_us);
+
+    double GetBudget() const { return budget_us_; }
+    void SetBudget(double budget_us) { budget_us_ = budget_us; }
+    double GetCostPerItem() const { return cost_per_item_us_; }
+
+private:
+    double budget_us_;
+    std::size_t min_slice_size_;
+    std::size_t cursor_ = 0;
+    // Zero until the first measurement, the first slice is min_slice_size_ long
+    double cost_per_item_us_ = 0.0;
+
+};
+
+#endif // TIME_SLICER_HPP_
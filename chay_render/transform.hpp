@@ -12,7 +12,9 @@ public:
     {}
 
     void Ping() const;
-    Matrix transform;
+    Matrix GetMatrix() const { return transform.ToMatrix(); }
+
+    TrsTransform transform;
 };
 
 #endif // TRANSFORM_HPP_
@@ -0,0 +1,53 @@
+#include "vertex_packing.hpp"
+
+void FloatToHalf(const float* src, std::uint16_t* dst, std::size_t count)
+{
+    GetMathKernels().float_to_half(src, dst, count);
+}
+
+void HalfToFloat(const std::uint16_t* src, float* dst, std::size_t count)
+{
+    GetMathKernels().half_to_float(src, dst, count);
+}
+
+void FloatToNorm(NormFormat format, const float* src, void* dst, std::size_t count)
+{
+    GetMathKernels().float_to_norm(format, src, dst, count);
+}
+
+void NormToFloat(NormFormat format, const void* src, float* dst, std::size_t count)
+{
+    GetMathKernels().norm_to_float(format, src, dst, count);
+}
+
+void EncodeNormals(const float3* normals, std::int16_t* dst, std::size_t count)
+{
+    GetMathKernels().encode_octahedral(&normals->x, 3, dst, count);
+}
+
+void DecodeNormals(const std::int16_t* src, float3* normals, std::size_t count)
+{
+    GetMathKernels().decode_octahedral(src, &normals->x, 3, count);
+}
+
+void EncodeTangents(const float4* tangents, std::int16_t* dst, std::size_t count)
+{
+    GetMathKernels().encode_octahedral(&tangents->x, 4, dst, count);
+
+    // Trading the last bit of precision for the handedness keeps tangents in 32 bits
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::int16_t y = dst[i * 2 + 1];
+        dst[i * 2 + 1] = static_cast<std::int16_t>((y & ~1) | (tangents[i].w < 0.0f ? 1 : 0));
+    }
+}
+
+void DecodeTangents(const std::int16_t* src, float4* tangents, std::size_t count)
+{
+    GetMathKernels().decode_octahedral(src, &tangents->x, 4, count);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        tangents[i].w = (src[i * 2 + 1] & 1) != 0 ? -1.0f : 1.0f;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef VERTEX_PACKING_HPP_
+#define VERTEX_PACKING_HPP_
+
+#include "mathlib.hpp"
+#include "math_kernels.hpp"
+#include <cstdint>
+
+// Bulk conversions for compressed vertex streams, run on the best SIMD kernel. Encoders give
+// the same bits on every level except for half NaN payloads, which F16C keeps.
+//   half      round to nearest even, overflow to infinity, denormals preserved
+//   norm      clamp, then round to nearest, snorm decodes -128 and -32768 to -1
+//   normals   octahedral mapping to two snorm16, angular error below 1e-4 rad
+//   tangents  same as normals, the lowest bit of the second coordinate stores the handedness
+
+void FloatToHalf(const float* src, std::uint16_t* dst, std::size_t count);
+void HalfToFloat(const std::uint16_t* src, float* dst, std::size_t count);
+
+// dst holds count elements of the format: int8_t, uint8_t, int16_t or uint16_t
+void FloatToNorm(NormFormat format, const float* src, void* dst, std::size_t count);
+void NormToFloat(NormFormat format, const void* src, float* dst, std::size_t count);
+
+// Two int16 per vector, inputs must be unit length (any non-zero length for normals works)
+void EncodeNormals(const float3* normals, std::int16_t* dst, std::size_t count);
+void DecodeNormals(const std::int16_t* src, float3* normals, std::size_t count);
+
+// xyz is the unit tangent, w is the bitangent sign (+1 or -1)
+void EncodeTangents(const float4* tangents, std::int16_t* dst, std::size_t count);
+void DecodeTangents(const std::int16_t* src, float4* tangents, std::size_t count);
+
+#endif // VERTEX_PACKING_HPP_
@@ -0,0 +1,333 @@
+#include "world_recorder.hpp"
+#include "component_manager.hpp"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    constexpr char kLogMagic[8] = { 'C', 'H', 'A', 'Y', 'R', 'E', 'C', '1' };
+
+    enum class Command : std::uint8_t
+    {
+        kDefineType,
+        kCreate,
+        kDestroy,
+        kSetEnabled,
+        kWrite,
+        kOrder,
+        kEndFrame,
+        kDefineSharedType,
+        kSetShared,
+        kRemoveShared
+    };
+}
+
+WorldRecorder::WorldRecorder()
+    : log_(std::begin(kLogMagic), std::end(kLogMagic))
+{
+}
+
+template <class T>
+void WorldRecorder::Append(T const& value)
+{
+    Append(&value, sizeof(T));
+}
+
+void WorldRecorder::Append(void const* data, std::size_t size)
+{
+    auto bytes = static_cast<std::uint8_t const*>(data);
+    log_.insert(log_.end(), bytes, bytes + size);
+}
+
+std::uint16_t WorldRecorder::GetTypeIndex(ComponentPool & pool)
+{
+    auto it = pool_2_type_index_.find(&pool);
+    if (it != pool_2_type_index_.end())
+    {
+        return it->second;
+    }
+
+    // Types are defined on first use: index, name, component size
+    std::uint16_t type_index = static_cast<std::uint16_t>(pool_2_type_index_.size());
+    std::string const& name = pool.GetName();
+    Append(Command::kDefineType);
+    Append(type_index);
+    Append(static_cast<std::uint16_t>(name.size()));
+    Append(name.data(), name.size());
+    Append(static_cast<std::uint64_t>(pool.GetComponentSize()));
+
+    pool_2_type_index_.emplace(&pool, type_index);
+    return type_index;
+}
+
+std::uint16_t WorldRecorder::GetSharedTypeIndex(SharedComponentPoolBase & pool)
+{
+    auto it = shared_pool_2_type_index_.find(&pool);
+    if (it != shared_pool_2_type_index_.end())
+    {
+        return it->second;
+    }
+
+    // Shared types have their own index space, defined the same way as component types
+    std::uint16_t type_index = static_cast<std::uint16_t>(shared_pool_2_type_index_.size());
+    std::string const& name = pool.GetName();
+    Append(Command::kDefineSharedType);
+    Append(type_index);
+    Append(static_cast<std::uint16_t>(name.size()));
+    Append(name.data(), name.size());
+    Append(static_cast<std::uint64_t>(pool.GetValueSize()));
+
+    shared_pool_2_type_index_.emplace(&pool, type_index);
+    return type_index;
+}
+
+void WorldRecorder::RecordCreate(ComponentPool & pool, EntityId id)
+{
+    std::uint16_t type_index = GetTypeIndex(pool);
+    Append(Command::kCreate);
+    Append(type_index);
+    Append(id);
+}
+
+void WorldRecorder::RecordDestroy(ComponentPool & pool, EntityId id)
+{
+    std::uint16_t type_index = GetTypeIndex(pool);
+    Append(Command::kDestroy);
+    Append(type_index);
+    Append(id);
+}
+
+void WorldRecorder::RecordSetEnabled(ComponentPool & pool, EntityId id, bool enabled)
+{
+    std::uint16_t type_index = GetTypeIndex(pool);
+    Append(Command::kSetEnabled);
+    Append(type_index);
+    Append(id);
+    Append(static_cast<std::uint8_t>(enabled));
+}
+
+void WorldRecorder::RecordWrite(ComponentPool & pool, EntityId id)
+{
+    std::uint16_t type_index = GetTypeIndex(pool);
+    Append(Command::kWrite);
+    Append(type_index);
+    Append(id);
+    Append(pool.GetComponent(id), pool.GetComponentSize());
+}
+
+void WorldRecorder::RecordOrder(ComponentPool & pool)
+{
+    std::uint16_t type_index = GetTypeIndex(pool);
+    Append(Command::kOrder);
+    Append(type_index);
+    Append(static_cast<std::uint64_t>(pool.GetComponentCount()));
+    for (std::size_t i = 0; i < pool.GetComponentCount(); ++i)
+    {
+        Append(pool.GetEntityIdByIndex(i));
+    }
+}
+
+void WorldRecorder::RecordSetShared(SharedComponentPoolBase & pool, EntityId id)
+{
+    std::uint16_t type_index = GetSharedTypeIndex(pool);
+    Append(Command::kSetShared);
+    Append(type_index);
+    Append(id);
+    Append(pool.GetValueBytes(id), pool.GetValueSize());
+}
+
+void WorldRecorder::RecordRemoveShared(SharedComponentPoolBase & pool, EntityId id)
+{
+    std::uint16_t type_index = GetSharedTypeIndex(pool);
+    Append(Command::kRemoveShared);
+    Append(type_index);
+    Append(id);
+}
+
+void WorldRecorder::EndFrame()
+{
+    Append(Command::kEndFrame);
+    ++frame_count_;
+}
+
+void WorldRecorder::Save(char const* filename) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open recording file for writing!");
+    }
+
+    file.write(reinterpret_cast<char const*>(log_.data()), log_.size());
+}
+
+WorldReplayer::WorldReplayer(ComponentManager & component_manager, std::vector<std::uint8_t> log)
+    : component_manager_(component_manager)
+    , log_(std::move(log))
+{
+    if (log_.size() < sizeof(kLogMagic) || std::memcmp(log_.data(), kLogMagic, sizeof(kLogMagic)) != 0)
+    {
+        throw std::runtime_error("Invalid world recording!");
+    }
+
+    read_offset_ = sizeof(kLogMagic);
+}
+
+std::vector<std::uint8_t> WorldReplayer::Load(char const* filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open recording file!");
+    }
+
+    return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void const* WorldReplayer::ReadBytes(std::size_t size)
+{
+    if (read_offset_ + size > log_.size())
+    {
+        throw std::runtime_error("Truncated world recording!");
+    }
+
+    void const* data = log_.data() + read_offset_;
+    read_offset_ += size;
+    return data;
+}
+
+template <class T>
+T WorldReplayer::Read()
+{
+    T value;
+    std::memcpy(&value, ReadBytes(sizeof(T)), sizeof(T));
+    return value;
+}
+
+bool WorldReplayer::ReplayFrame()
+{
+    if (read_offset_ == log_.size())
+    {
+        return false;
+    }
+
+    while (read_offset_ < log_.size())
+    {
+        Command command = Read<Command>();
+        if (command == Command::kEndFrame)
+        {
+            ++frame_index_;
+            return true;
+        }
+
+        std::uint16_t type_index = Read<std::uint16_t>();
+
+        if (command == Command::kDefineType)
+        {
+            std::uint16_t name_size = Read<std::uint16_t>();
+            std::string name(static_cast<char const*>(ReadBytes(name_size)), name_size);
+            std::uint64_t component_size = Read<std::uint64_t>();
+
+            ComponentPool & pool = component_manager_.GetComponentPool(name.c_str());
+            if (pool.GetComponentSize() != component_size)
+            {
+                throw std::runtime_error("Component size doesn't match the recording!");
+            }
+
+            type_index_2_pool_.resize(std::max<std::size_t>(type_index_2_pool_.size(), type_index + 1u), nullptr);
+            type_index_2_pool_[type_index] = &pool;
+            continue;
+        }
+
+        if (command == Command::kDefineSharedType)
+        {
+            std::uint16_t name_size = Read<std::uint16_t>();
+            std::string name(static_cast<char const*>(ReadBytes(name_size)), name_size);
+            std::uint64_t value_size = Read<std::uint64_t>();
+
+            SharedComponentPoolBase & pool = component_manager_.GetSharedComponentPool(name.c_str());
+            if (pool.GetValueSize() != value_size)
+            {
+                throw std::runtime_error("Shared component size doesn't match the recording!");
+            }
+
+            type_index_2_shared_pool_.resize(std::max<std::size_t>(type_index_2_shared_pool_.size(), type_index + 1u), nullptr);
+            type_index_2_shared_pool_[type_index] = &pool;
+            continue;
+        }
+
+        if (command == Command::kSetShared || command == Command::kRemoveShared)
+        {
+            if (type_index >= type_index_2_shared_pool_.size() || !type_index_2_shared_pool_[type_index])
+            {
+                throw std::runtime_error("Undefined shared component type in world recording!");
+            }
+
+            SharedComponentPoolBase & pool = *type_index_2_shared_pool_[type_index];
+            EntityId id = Read<EntityId>();
+            if (command == Command::kSetShared)
+            {
+                pool.SetValueBytes(id, ReadBytes(pool.GetValueSize()));
+            }
+            else
+            {
+                pool.RemoveValue(id);
+            }
+            continue;
+        }
+
+        if (type_index >= type_index_2_pool_.size() || !type_index_2_pool_[type_index])
+        {
+            throw std::runtime_error("Undefined component type in world recording!");
+        }
+
+        ComponentPool & pool = *type_index_2_pool_[type_index];
+        EntityId id = 0;
+
+        switch (command)
+        {
+        case Command::kCreate:
+            pool.AllocateComponent(Read<EntityId>());
+            break;
+        case Command::kDestroy:
+            pool.FreeComponent(Read<EntityId>());
+            break;
+        case Command::kSetEnabled:
+            id = Read<EntityId>();
+            pool.SetEnabled(id, Read<std::uint8_t>() != 0);
+            break;
+        case Command::kWrite:
+            id = Read<EntityId>();
+            std::memcpy(pool.GetComponent(id), ReadBytes(pool.GetComponentSize()), pool.GetComponentSize());
+            break;
+        case Command::kOrder:
+        {
+            // Reproduce the recorded layout with the same sort the pool went through
+            std::size_t count = static_cast<std::size_t>(Read<std::uint64_t>());
+            std::unordered_map<EntityId, std::size_t> entity_id_2_position;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                entity_id_2_position.emplace(Read<EntityId>(), i);
+            }
+
+            std::vector<std::size_t> keys(pool.GetComponentCount());
+            for (std::size_t i = 0; i < keys.size(); ++i)
+            {
+                keys[i] = entity_id_2_position.at(pool.GetEntityIdByIndex(i));
+            }
+
+            pool.SortByKeys(keys);
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown command in world recording!");
+        }
+    }
+
+    // Trailing commands without a frame boundary form the last frame
+    ++frame_index_;
+    return true;
+}
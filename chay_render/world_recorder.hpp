@@ -0,0 +1,82 @@
+#ifndef WORLD_RECORDER_HPP_
+#define WORLD_RECORDER_HPP_
+
+#include "entity.hpp"
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+class ComponentPool;
+class ComponentManager;
+class SharedComponentPoolBase;
+
+// Records structural changes and component writes applied to component pools,
+// and value assignments of shared component pools, into a compact binary log. Attach with ComponentManager::SetRecorder, mark frame
+// boundaries with EndFrame and play the log back headless with WorldReplayer.
+// Component writes and shared values are captured as raw bytes: pointers inside components
+// (e.g. overflowed DynamicBuffers) are not meaningful on replay. Not thread-safe,
+// concurrently allocated components are recorded in EndConcurrentAllocation.
+class WorldRecorder
+{
+public:
+    WorldRecorder();
+
+    void RecordCreate(ComponentPool & pool, EntityId id);
+    void RecordDestroy(ComponentPool & pool, EntityId id);
+    void RecordSetEnabled(ComponentPool & pool, EntityId id, bool enabled);
+    // Snapshot of the current component bytes
+    void RecordWrite(ComponentPool & pool, EntityId id);
+    // Dense entity order of the pool, after it has been sorted
+    void RecordOrder(ComponentPool & pool);
+    // Current shared value of the entity
+    void RecordSetShared(SharedComponentPoolBase & pool, EntityId id);
+    void RecordRemoveShared(SharedComponentPoolBase & pool, EntityId id);
+    void EndFrame();
+
+    std::vector<std::uint8_t> const& GetLog() const { return log_; }
+    std::size_t GetFrameCount() const { return frame_count_; }
+    void Save(char const* filename) const;
+
+private:
+    std::uint16_t GetTypeIndex(ComponentPool & pool);
+    std::uint16_t GetSharedTypeIndex(SharedComponentPoolBase & pool);
+
+    template <class T>
+    void Append(T const& value);
+    void Append(void const* data, std::size_t size);
+
+    std::vector<std::uint8_t> log_;
+    std::unordered_map<ComponentPool*, std::uint16_t> pool_2_type_index_;
+    std::unordered_map<SharedComponentPoolBase*, std::uint16_t> shared_pool_2_type_index_;
+    std::size_t frame_count_ = 0;
+
+};
+
+// Replays a log produced by WorldRecorder into a ComponentManager as fast as possible.
+// Pools are matched by the registered component name
+class WorldReplayer
+{
+public:
+    WorldReplayer(ComponentManager & component_manager, std::vector<std::uint8_t> log);
+
+    static std::vector<std::uint8_t> Load(char const* filename);
+
+    // Applies commands up to the next frame boundary, returns false once the log is exhausted
+    bool ReplayFrame();
+    std::size_t GetFrameIndex() const { return frame_index_; }
+
+private:
+    template <class T>
+    T Read();
+    void const* ReadBytes(std::size_t size);
+
+    ComponentManager & component_manager_;
+    std::vector<std::uint8_t> log_;
+    std::size_t read_offset_ = 0;
+    std::size_t frame_index_ = 0;
+    std::vector<ComponentPool*> type_index_2_pool_;
+    std::vector<SharedComponentPoolBase*> type_index_2_shared_pool_;
+
+};
+
+#endif // WORLD_RECORDER_HPP_